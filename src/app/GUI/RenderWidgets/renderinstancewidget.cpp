@@ -59,22 +59,7 @@ RenderInstanceWidget::RenderInstanceWidget(const RenderInstanceSettings& sett,
 
 void RenderInstanceWidget::iniGUI()
 {
-    if (!OutputSettingsProfile::sOutputProfilesLoaded) {
-        OutputSettingsProfile::sOutputProfilesLoaded = true;
-        QDir dirPath(AppSupport::getAppOutputProfilesPath());
-        dirPath.setSorting(QDir::SortFlag::Name);
-        for (const auto &fileInfo : dirPath.entryInfoList()) {
-            if (!fileInfo.isFile()) { continue; }
-            if (!fileInfo.completeSuffix().contains("conf")) { continue; }
-            const auto profile = enve::make_shared<OutputSettingsProfile>();
-            try {
-                profile->load(fileInfo.absoluteFilePath());
-            } catch(const std::exception& e) {
-                gPrintExceptionCritical(e);
-            }
-            OutputSettingsProfile::sOutputProfiles << profile;
-        }
-    }
+    OutputSettingsProfile::sLoadProfiles();
 
     setCheckable(true);
     setObjectName("darkWidget");
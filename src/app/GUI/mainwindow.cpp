@@ -127,6 +127,8 @@ MainWindow::MainWindow(Document& document,
     , mRenderHandler(renderHandler)
     , mLayoutHandler(nullptr)
     , mFillStrokeSettings(nullptr)
+    , mSchedulerMetrics(nullptr)
+    , mMemoryUsage(nullptr)
     , mChangedSinceSaving(false)
     , mEventFilterDisabled(false)
     , mGrayOutWidget(nullptr)
@@ -152,6 +154,8 @@ MainWindow::MainWindow(Document& document,
     , mTimelineWindow(nullptr)
     , mTimelineWindowAct(nullptr)
     , mViewFillStrokeAct(nullptr)
+    , mViewSchedulerAct(nullptr)
+    , mViewMemoryAct(nullptr)
     , mRenderWindow(nullptr)
     , mRenderWindowAct(nullptr)
     , mToolBarMainAct(nullptr)
@@ -822,6 +826,22 @@ void MainWindow::readSettings(const QString &openProject)
         mUI->setDockVisible("Fill and Stroke", false);
     }
 
+    const bool visibleScheduler = AppSupport::getSettings("ui",
+                                                          "SchedulerVisible",
+                                                          false).toBool();
+    mViewSchedulerAct->setChecked(visibleScheduler);
+    if (!visibleScheduler) {
+        mUI->setDockVisible(tr("Scheduler"), false);
+    }
+
+    const bool visibleMemory = AppSupport::getSettings("ui",
+                                                       "MemoryVisible",
+                                                       false).toBool();
+    mViewMemoryAct->setChecked(visibleMemory);
+    if (!visibleMemory) {
+        mUI->setDockVisible(tr("Memory"), false);
+    }
+
 #ifdef Q_OS_LINUX
     if (AppSupport::isWayland()) { // Disable fullscreen on wayland
         isFull = false;
@@ -907,6 +927,8 @@ void MainWindow::setupMainWidgets()
                                        mLayoutHandler,
                                        this);
     mRenderWidget = new RenderWidget(this);
+    mSchedulerMetrics = new SchedulerMetricsWidget(this);
+    mMemoryUsage = new MemoryUsageWidget(this);
 }
 
 void MainWindow::setupStackWidgets()
@@ -1037,6 +1059,20 @@ void MainWindow::setupLayout()
                      false,
                      true,
                      false});
+    docks.push_back({UIDock::Position::Right,
+                     -1,
+                     tr("Scheduler"),
+                     mSchedulerMetrics,
+                     true,
+                     true,
+                     false});
+    docks.push_back({UIDock::Position::Right,
+                     -1,
+                     tr("Memory"),
+                     mMemoryUsage,
+                     true,
+                     true,
+                     false});
     mUI->addDocks(docks);
     setCentralWidget(mUI);
 }
@@ -57,6 +57,8 @@
 #include "widgets/canvastoolbar.h"
 #include "widgets/aboutwidget.h"
 #include "widgets/uilayout.h"
+#include "widgets/schedulermetricswidget.h"
+#include "widgets/memoryusagewidget.h"
 #include "widgets/toolbox.h"
 
 #ifndef Q_OS_MAC
@@ -301,6 +303,8 @@ private:
     LayoutHandler *mLayoutHandler;
 
     FillStrokeSettingsWidget *mFillStrokeSettings;
+    SchedulerMetricsWidget *mSchedulerMetrics;
+    MemoryUsageWidget *mMemoryUsage;
 
     bool mChangedSinceSaving;
     bool mEventFilterDisabled;
@@ -365,6 +369,8 @@ private:
     void closedTimelineWindow();
 
     QAction *mViewFillStrokeAct;
+    QAction *mViewSchedulerAct;
+    QAction *mViewMemoryAct;
 
     Window *mRenderWindow;
     QAction *mRenderWindowAct;
@@ -736,6 +736,24 @@ void MainWindow::setupMenuBar()
                 AppSupport::setSettings("ui", "FillStrokeVisible", triggered);
             });
 
+    mViewSchedulerAct = mViewMenu->addAction(tr("View Scheduler"));
+    mViewSchedulerAct->setCheckable(true);
+    mViewSchedulerAct->setChecked(false);
+    connect(mViewSchedulerAct, &QAction::triggered,
+            this, [this](bool triggered) {
+                mUI->setDockVisible(tr("Scheduler"), triggered);
+                AppSupport::setSettings("ui", "SchedulerVisible", triggered);
+            });
+
+    mViewMemoryAct = mViewMenu->addAction(tr("View Memory"));
+    mViewMemoryAct->setCheckable(true);
+    mViewMemoryAct->setChecked(false);
+    connect(mViewMemoryAct, &QAction::triggered,
+            this, [this](bool triggered) {
+                mUI->setDockVisible(tr("Memory"), triggered);
+                AppSupport::setSettings("ui", "MemoryVisible", triggered);
+            });
+
     mViewMenu->addSeparator();
 
     mTimelineWindowAct = mViewMenu->addAction(tr("Timeline in Window"));
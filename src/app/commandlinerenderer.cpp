@@ -0,0 +1,536 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "commandlinerenderer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QEventLoop>
+#include <QProcess>
+#include <QTemporaryDir>
+
+#include "renderhandler.h"
+#include "videoencoder.h"
+#include "canvas.h"
+#include "Sound/soundcomposition.h"
+#include "exceptions.h"
+#include "yuvconverter.h"
+#include "Private/document.h"
+#include "ReadWrite/evformat.h"
+#include "ReadWrite/filefooter.h"
+#include "ReadWrite/ereadstream.h"
+
+CommandLineRenderer::CommandLineRenderer(Document &document,
+                                         RenderHandler &renderHandler)
+    : mDocument(document)
+    , mRenderHandler(renderHandler)
+{
+
+}
+
+int CommandLineRenderer::exec(const QStringList &args)
+{
+    Options opts;
+    if (!parseArgs(args, opts)) { return -1; }
+    if (opts.fBenchmark) {
+        YuvConverter::sBenchmark(3840, 2160, 20);
+        return 0;
+    }
+
+    OutputSettingsProfile::sLoadProfiles();
+    try {
+        loadProject(opts.fProject);
+    } catch(const std::exception& e) {
+        gPrintExceptionCritical(e);
+        return -1;
+    }
+
+    if (opts.fList) {
+        listProject();
+        return 0;
+    }
+    if (!setupSettings(opts)) { return -1; }
+
+    const auto scene = mSettings->getTargetCanvas();
+    mDocument.addVisibleScene(scene);
+    mDocument.setActiveScene(scene);
+
+    if (opts.fWorkers > 1 && canSplitOutput()) { return execWorkers(opts); }
+
+    int result = -1;
+    const auto emitter = VideoEncoder::sInstance->getEmitter();
+    connect(emitter, &VideoEncoderEmitter::encodingFinished,
+            this, [&result]() {
+        result = 0;
+        QCoreApplication::exit(0);
+    });
+    const auto failed = [this]() {
+        qCritical().noquote() << tr("Rendering failed:") << mSettings->getRenderError();
+        QCoreApplication::exit(-1);
+    };
+    connect(emitter, &VideoEncoderEmitter::encodingFailed, this, failed);
+    connect(emitter, &VideoEncoderEmitter::encodingStartFailed, this, failed);
+    connect(emitter, &VideoEncoderEmitter::encodingInterrupted, this, failed);
+    connect(mSettings.get(), &RenderInstanceSettings::renderFrameChanged,
+            this, &CommandLineRenderer::renderFrameChanged);
+
+    const auto &renderSettings = mSettings->getRenderSettings();
+    qInfo().noquote() << tr("Rendering %1, frames %2 - %3 to %4")
+                         .arg(scene->prp_getName())
+                         .arg(renderSettings.fMinFrame)
+                         .arg(renderSettings.fMaxFrame)
+                         .arg(mSettings->getOutputDestination());
+
+    mRenderHandler.renderFromSettings(mSettings.get());
+    if (mSettings->getCurrentState() == RenderState::error) { return -1; }
+    QCoreApplication::exec();
+    return result;
+}
+
+bool CommandLineRenderer::parseArgs(const QStringList &args,
+                                    Options &opts)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(tr("Render a project without user interface."));
+    parser.addHelpOption();
+    parser.addPositionalArgument("project", tr("Project file (.friction)"));
+
+    const QCommandLineOption rendererOpt("renderer", tr("Run the command line renderer."));
+    const QCommandLineOption sceneOpt("scene", tr("Scene to render, name or index."), "scene");
+    const QCommandLineOption queueOpt("queue", tr("Use render queue item saved in the project."), "index");
+    const QCommandLineOption profileOpt("profile", tr("Output settings profile name."), "name");
+    const QCommandLineOption outputOpt("output", tr("Output file."), "file");
+    const QCommandLineOption firstOpt("first", tr("First frame to render."), "frame");
+    const QCommandLineOption lastOpt("last", tr("Last frame to render."), "frame");
+    const QCommandLineOption listOpt("list", tr("List scenes, render queue and output profiles."));
+    const QCommandLineOption noAudioOpt("no-audio", tr("Render video only."));
+    const QCommandLineOption workersOpt("workers", tr("Split the frame range between processes."), "count");
+    const QCommandLineOption benchmarkOpt("benchmark-conversion", tr("Time RGBA to YUV conversion of a 4K frame."));
+    parser.addOptions({rendererOpt, sceneOpt, queueOpt, profileOpt,
+                       outputOpt, firstOpt, lastOpt, listOpt,
+                       noAudioOpt, workersOpt, benchmarkOpt});
+
+    if (!parser.parse(args)) {
+        qCritical().noquote() << parser.errorText();
+        return false;
+    }
+    if (parser.isSet("help")) {
+        qInfo().noquote() << parser.helpText();
+        return false;
+    }
+
+    opts.fBenchmark = parser.isSet(benchmarkOpt);
+    if (opts.fBenchmark) { return true; }
+
+    const auto positional = parser.positionalArguments();
+    if (positional.count() != 1) {
+        qCritical().noquote() << tr("Expected exactly one project file.");
+        qInfo().noquote() << parser.helpText();
+        return false;
+    }
+    opts.fProject = positional.first();
+    opts.fScene = parser.value(sceneOpt);
+    opts.fProfile = parser.value(profileOpt);
+    opts.fOutput = parser.value(outputOpt);
+    opts.fList = parser.isSet(listOpt);
+    opts.fNoAudio = parser.isSet(noAudioOpt);
+
+    bool ok = true;
+    if (parser.isSet(queueOpt)) {
+        opts.fQueueItem = parser.value(queueOpt).toInt(&ok);
+        if (!ok) { qCritical().noquote() << tr("Invalid queue index."); return false; }
+    }
+    if (parser.isSet(firstOpt)) {
+        opts.fFirstFrame = parser.value(firstOpt).toInt(&ok);
+        if (!ok) { qCritical().noquote() << tr("Invalid first frame."); return false; }
+    }
+    if (parser.isSet(lastOpt)) {
+        opts.fLastFrame = parser.value(lastOpt).toInt(&ok);
+        if (!ok) { qCritical().noquote() << tr("Invalid last frame."); return false; }
+    }
+    if (parser.isSet(workersOpt)) {
+        opts.fWorkers = parser.value(workersOpt).toInt(&ok);
+        if (!ok || opts.fWorkers < 1) {
+            qCritical().noquote() << tr("Invalid number of workers.");
+            return false;
+        }
+    }
+    return true;
+}
+
+void CommandLineRenderer::loadProject(const QString &path)
+{
+    // mirrors MainWindow::loadEVFile, minus the user interface state
+    QFile file(path);
+    if (!file.exists()) { RuntimeThrow("File does not exist " + path); }
+    if (!file.open(QIODevice::ReadOnly)) {
+        RuntimeThrow("Could not open file " + path);
+    }
+    try {
+        const int evVersion = FileFooter::sReadEvFileVersion(&file);
+        if (evVersion <= 0) { RuntimeThrow("Incompatible or incomplete data"); }
+        if (evVersion > EvFormat::version) {
+            RuntimeThrow("Unsupported project version " + QString::number(evVersion));
+        }
+
+        eReadStream readStream(evVersion, &file);
+        readStream.setPath(path);
+
+        const qint64 savedPos = file.pos();
+        const qint64 pos = file.size() - FileFooter::sSize(evVersion) -
+                qint64(sizeof(int));
+        file.seek(pos);
+        readStream.readFutureTable();
+        file.seek(savedPos);
+        readStream.readCheckpoint("File beginning pos mismatch");
+        const bool hasLayout = evVersion >= EvFormat::betterSWTAbsReadWrite;
+        if (hasLayout) {
+            int nScenes; readStream >> nScenes;
+            for (int i = 0; i < nScenes; i++) {
+                const bool beforeContent = (evVersion >= EvFormat::readSceneSettingsBeforeContent);
+                const auto scene = mDocument.createNewScene(!beforeContent);
+                if (beforeContent) {
+                    scene->readSettings(readStream);
+                    mDocument.sceneCreated(scene);
+                }
+            }
+            readStream.skipToCheckpoint("Error skipping Layout");
+        }
+        mDocument.readScenes(readStream);
+        readStream.readCheckpoint("Error reading Document");
+        if (hasLayout) {
+            int nItems; readStream >> nItems;
+            for (int i = 0; i < nItems; i++) {
+                const auto settings = std::make_shared<RenderInstanceSettings>(nullptr);
+                settings->read(readStream);
+                bool checked; readStream >> checked;
+                mQueue << settings;
+            }
+            readStream.readCheckpoint("Error reading Render Queue");
+        }
+    } catch(...) {
+        file.close();
+        RuntimeThrow("Error while reading from file " + path);
+    }
+    file.close();
+}
+
+Canvas *CommandLineRenderer::findScene(const QString &scene) const
+{
+    const auto &scenes = mDocument.fScenes;
+    if (scenes.isEmpty()) { return nullptr; }
+    if (scene.isEmpty()) { return scenes.first().get(); }
+    for (const auto &s : scenes) {
+        if (s->prp_getName() == scene) { return s.get(); }
+    }
+    bool ok = false;
+    const int index = scene.toInt(&ok);
+    if (ok && index >= 0 && index < scenes.count()) {
+        return scenes.at(index).get();
+    }
+    return nullptr;
+}
+
+bool CommandLineRenderer::setupSettings(const Options &opts)
+{
+    if (opts.fQueueItem >= 0) {
+        if (opts.fQueueItem >= mQueue.count()) {
+            qCritical().noquote() << tr("No render queue item %1.").arg(opts.fQueueItem);
+            return false;
+        }
+        mSettings = mQueue.at(opts.fQueueItem);
+    }
+
+    const auto scene = opts.fScene.isEmpty() && mSettings ?
+                           mSettings->getTargetCanvas() : findScene(opts.fScene);
+    if (!scene) {
+        qCritical().noquote() << tr("Scene not found.");
+        return false;
+    }
+
+    if (!mSettings) {
+        // first queue item for this scene, or the scene defaults
+        for (const auto &item : mQueue) {
+            if (item->getTargetCanvas() == scene) {
+                mSettings = item;
+                break;
+            }
+        }
+        if (!mSettings) {
+            mSettings = std::make_shared<RenderInstanceSettings>(scene);
+        }
+    }
+    if (mSettings->getTargetCanvas() != scene) {
+        mSettings->setTargetCanvas(scene, false);
+    }
+
+    if (!opts.fProfile.isEmpty()) {
+        const auto profile = OutputSettingsProfile::sGetByName(opts.fProfile);
+        if (!profile) {
+            qCritical().noquote() << tr("Output profile not found: %1").arg(opts.fProfile);
+            return false;
+        }
+        mSettings->setOutputSettingsProfile(profile);
+    }
+    if (!mSettings->getOutputRenderSettings().fOutputFormat) {
+        qCritical().noquote() << tr("No output format, use --profile or --queue.");
+        return false;
+    }
+
+    if (!opts.fOutput.isEmpty()) { mSettings->setOutputDestination(opts.fOutput); }
+    if (mSettings->getOutputDestination().isEmpty()) {
+        qCritical().noquote() << tr("No output file, use --output.");
+        return false;
+    }
+
+    auto renderSettings = mSettings->getRenderSettings();
+    if (opts.fFirstFrame >= 0) { renderSettings.fMinFrame = opts.fFirstFrame; }
+    if (opts.fLastFrame >= 0) { renderSettings.fMaxFrame = opts.fLastFrame; }
+    if (renderSettings.fMinFrame > renderSettings.fMaxFrame) {
+        qCritical().noquote() << tr("Invalid frame range.");
+        return false;
+    }
+    mSettings->setRenderSettings(renderSettings);
+
+    if (opts.fNoAudio) {
+        auto outputSettings = mSettings->getOutputRenderSettings();
+        outputSettings.fAudioEnabled = false;
+        mSettings->setOutputRenderSettings(outputSettings);
+    }
+    return true;
+}
+
+void CommandLineRenderer::listProject() const
+{
+    const auto &scenes = mDocument.fScenes;
+    qInfo().noquote() << tr("Scenes:");
+    for (int i = 0; i < scenes.count(); i++) {
+        const auto &scene = scenes.at(i);
+        const auto range = scene->getFrameRange();
+        qInfo().noquote() << QString("  %1: %2 (%3x%4, %5 fps, frames %6 - %7)")
+                             .arg(i).arg(scene->prp_getName())
+                             .arg(scene->getCanvasWidth())
+                             .arg(scene->getCanvasHeight())
+                             .arg(scene->getFps())
+                             .arg(range.fMin).arg(range.fMax);
+    }
+    qInfo().noquote() << tr("Render queue:");
+    for (int i = 0; i < mQueue.count(); i++) {
+        const auto &item = mQueue.at(i);
+        const auto profile = item->getOutputSettingsProfile();
+        qInfo().noquote() << QString("  %1: %2 -> %3 [%4]")
+                             .arg(i).arg(item->getName())
+                             .arg(item->getOutputDestination())
+                             .arg(profile ? profile->getName() : QString());
+    }
+    qInfo().noquote() << tr("Output profiles:");
+    for (const auto &profile : OutputSettingsProfile::sOutputProfiles) {
+        qInfo().noquote() << "  " + profile->getName();
+    }
+}
+
+void CommandLineRenderer::renderFrameChanged(const int frame)
+{
+    const auto &renderSettings = mSettings->getRenderSettings();
+    const int nFrames = renderSettings.fMaxFrame - renderSettings.fMinFrame + 1;
+    const int progress = 100*(frame - renderSettings.fMinFrame + 1)/qMax(1, nFrames);
+    if (progress == mLastProgress) { return; }
+    mLastProgress = progress;
+    qInfo().noquote() << QString("frame %1 (%2 %)").arg(frame).arg(progress);
+}
+
+bool CommandLineRenderer::canSplitOutput() const
+{
+    const auto &outputSettings = mSettings->getOutputRenderSettings();
+    const auto format = outputSettings.fOutputFormat;
+    // image sequences and streams without timestamps can not be joined
+    const bool canSplit = outputSettings.fVideoEnabled &&
+                          outputSettings.fVideoCodec &&
+                          !(format->flags & AVFMT_NOFILE) &&
+                          !(format->flags & AVFMT_NOTIMESTAMPS);
+    if (!canSplit) {
+        qWarning().noquote() << tr("Output format can not be split, rendering in a single process.");
+    }
+    return canSplit;
+}
+
+int CommandLineRenderer::execWorkers(const Options &opts)
+{
+    const auto renderSettings = mSettings->getRenderSettings();
+    const auto outputSettings = mSettings->getOutputRenderSettings();
+    const QString output = mSettings->getOutputDestination();
+    const QFileInfo outputInfo(output);
+    const QString suffix = outputInfo.suffix().isEmpty() ?
+                               QString() : "." + outputInfo.suffix();
+
+    // segments are written next to the output so joining them is cheap
+    QTemporaryDir tmpDir(outputInfo.absoluteDir().filePath(".friction-render-XXXXXX"));
+    if (!tmpDir.isValid()) {
+        qCritical().noquote() << tr("Could not create temporary directory: %1")
+                                 .arg(tmpDir.errorString());
+        return -1;
+    }
+
+    // inter frame codecs start a new GOP in every segment,
+    // keep the keyframes where a single encoder would put them
+    const bool intraOnly = VideoEncoder::sIsIntraOnly(outputSettings.fVideoCodec);
+    const auto ranges = splitRange({renderSettings.fMinFrame,
+                                    renderSettings.fMaxFrame},
+                                   opts.fWorkers,
+                                   intraOnly ? 1 : VideoEncoder::sGopSize);
+
+    const auto soundComp = mSettings->getTargetCanvas()->getSoundComposition();
+    const bool renderAudio = outputSettings.fAudioEnabled &&
+                             outputSettings.fAudioCodec &&
+                             outputSettings.fOutputFormat->audio_codec != AV_CODEC_ID_NONE &&
+                             soundComp->hasAnySounds();
+
+    QEventLoop loop;
+    int running = 0;
+    bool failed = false;
+    const auto done = [&](const bool success) {
+        running--;
+        if (!success) { failed = true; }
+        if (failed || running == 0) { loop.quit(); }
+    };
+
+    auto env = QProcessEnvironment::systemEnvironment();
+    // every worker would write to the same trace file
+    env.remove("FRICTION_TASK_TRACE");
+
+    QStringList segments;
+    QList<QProcess*> workers;
+    for (int i = 0; i < ranges.count(); i++) {
+        const auto &range = ranges.at(i);
+        const QString segment = tmpDir.filePath(QString("segment%1%2")
+                                                .arg(i, 4, 10, QChar('0'))
+                                                .arg(suffix));
+        segments << segment;
+
+        const auto worker = new QProcess(&loop);
+        worker->setProcessEnvironment(env);
+        worker->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(worker, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
+                &loop, [done](const int exitCode, const QProcess::ExitStatus status) {
+            done(status == QProcess::NormalExit && exitCode == 0);
+        });
+        connect(worker, &QProcess::errorOccurred,
+                &loop, [done, worker](const QProcess::ProcessError error) {
+            if (error != QProcess::FailedToStart) { return; }
+            qCritical().noquote() << worker->errorString();
+            done(false);
+        });
+        qInfo().noquote() << tr("Worker %1, frames %2 - %3")
+                             .arg(i).arg(range.fMin).arg(range.fMax);
+        running++;
+        worker->start(QCoreApplication::applicationFilePath(),
+                      workerArgs(opts, range, segment));
+        workers << worker;
+    }
+
+    // audio is rendered once, in this process, while the workers run
+    QString audioFile;
+    QObject audioContext;
+    if (renderAudio && !failed) {
+        audioFile = tmpDir.filePath("audio" + suffix);
+        auto audioSettings = outputSettings;
+        audioSettings.fVideoEnabled = false;
+        mSettings->setOutputRenderSettings(audioSettings);
+        mSettings->setOutputDestination(audioFile);
+
+        const auto emitter = VideoEncoder::sInstance->getEmitter();
+        connect(emitter, &VideoEncoderEmitter::encodingFinished,
+                &audioContext, [done]() { done(true); });
+        const auto audioFailed = [this, done]() {
+            qCritical().noquote() << tr("Rendering audio failed:") << mSettings->getRenderError();
+            done(false);
+        };
+        connect(emitter, &VideoEncoderEmitter::encodingFailed, &audioContext, audioFailed);
+        connect(emitter, &VideoEncoderEmitter::encodingStartFailed, &audioContext, audioFailed);
+        connect(emitter, &VideoEncoderEmitter::encodingInterrupted, &audioContext, audioFailed);
+
+        qInfo().noquote() << tr("Rendering audio");
+        running++;
+        mRenderHandler.renderFromSettings(mSettings.get());
+    }
+
+    if (running > 0 && !failed) { loop.exec(); }
+
+    for (const auto worker : workers) {
+        worker->disconnect(&loop);
+        if (worker->state() == QProcess::NotRunning) { continue; }
+        worker->kill();
+        worker->waitForFinished();
+    }
+    if (failed) {
+        if (VideoEncoder::sEncodingSuccessfulyStarted()) {
+            VideoEncoder::sInterruptEncoding();
+        }
+        qCritical().noquote() << tr("Rendering failed.");
+        return -1;
+    }
+
+    qInfo().noquote() << tr("Joining %1 segments to %2").arg(segments.count()).arg(output);
+    try {
+        VideoEncoder::sMuxSegments(segments, audioFile, output,
+                                   outputSettings.fOutputFormat);
+    } catch(const std::exception& e) {
+        gPrintExceptionCritical(e);
+        return -1;
+    }
+    return 0;
+}
+
+QStringList CommandLineRenderer::workerArgs(const Options &opts,
+                                            const FrameRange &range,
+                                            const QString &output) const
+{
+    QStringList args{"--renderer", "--no-audio",
+                     "--first", QString::number(range.fMin),
+                     "--last", QString::number(range.fMax),
+                     "--output", output};
+    if (!opts.fScene.isEmpty()) { args << "--scene" << opts.fScene; }
+    if (opts.fQueueItem >= 0) { args << "--queue" << QString::number(opts.fQueueItem); }
+    if (!opts.fProfile.isEmpty()) { args << "--profile" << opts.fProfile; }
+    args << opts.fProject;
+    return args;
+}
+
+QList<FrameRange> CommandLineRenderer::splitRange(const FrameRange &range,
+                                                  const int count,
+                                                  const int align)
+{
+    const int nFrames = range.fMax - range.fMin + 1;
+    const int nBlocks = (nFrames + align - 1)/align;
+    const int nParts = qBound(1, count, nBlocks);
+    QList<FrameRange> result;
+    for (int i = 0; i < nParts; i++) {
+        const int first = range.fMin + align*(i*nBlocks/nParts);
+        const int last = range.fMin + align*((i + 1)*nBlocks/nParts) - 1;
+        result << FrameRange{first, qMin(range.fMax, last)};
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef COMMANDLINERENDERER_H
+#define COMMANDLINERENDERER_H
+
+#include <QObject>
+#include <QStringList>
+
+#include "renderinstancesettings.h"
+#include "framerange.h"
+
+class Document;
+class Canvas;
+class RenderHandler;
+
+//! @brief Renders a project without any window or GPU context,
+//! started with: friction --renderer [options] project.friction
+class CommandLineRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    CommandLineRenderer(Document &document,
+                        RenderHandler &renderHandler);
+
+    //! @brief Returns the process exit code.
+    int exec(const QStringList &args);
+
+private:
+    struct Options {
+        QString fProject;
+        QString fScene;
+        int fQueueItem = -1;
+        QString fProfile;
+        QString fOutput;
+        int fFirstFrame = -1;
+        int fLastFrame = -1;
+        bool fList = false;
+        bool fNoAudio = false;
+        int fWorkers = 1;
+        bool fBenchmark = false;
+    };
+
+    bool parseArgs(const QStringList &args, Options &opts);
+    void loadProject(const QString &path);
+    Canvas *findScene(const QString &scene) const;
+    bool setupSettings(const Options &opts);
+    void listProject() const;
+    void renderFrameChanged(const int frame);
+
+    bool canSplitOutput() const;
+    int execWorkers(const Options &opts);
+    QStringList workerArgs(const Options &opts,
+                           const FrameRange &range,
+                           const QString &output) const;
+    static QList<FrameRange> splitRange(const FrameRange &range,
+                                        const int count,
+                                        const int align);
+
+    Document &mDocument;
+    RenderHandler &mRenderHandler;
+
+    QList<stdsptr<RenderInstanceSettings>> mQueue;
+    stdsptr<RenderInstanceSettings> mSettings;
+    int mLastProgress = -1;
+};
+
+#endif // COMMANDLINERENDERER_H
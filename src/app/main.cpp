@@ -20,6 +20,7 @@
 */
 
 #include "GUI/mainwindow.h"
+#include "commandlinerenderer.h"
 
 #include <iostream>
 #include <QApplication>
@@ -32,6 +33,7 @@
 #include "importhandler.h"
 #include "effectsloader.h"
 #include "memoryhandler.h"
+#include "Private/Tasks/tasktracer.h"
 #include "ShaderEffects/shadereffectprogram.h"
 #include "videoencoder.h"
 #include "appsupport.h"
@@ -76,8 +78,8 @@ void generateAlphaMesh(QPixmap& alphaMesh,
 
 int main(int argc, char *argv[])
 {
-    // check if cli renderer (not supported yet)
-    const bool isRenderer = false; // AppSupport::hasArg(argc, argv, "--renderer");
+    // check if cli renderer
+    const bool isRenderer = AppSupport::hasArg(argc, argv, "--renderer");
 
     // init env variables
     AppSupport::initEnv(isRenderer);
@@ -104,6 +106,9 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
     setlocale(LC_NUMERIC, "C");
 
+    // log errors instead of showing message boxes
+    if (isRenderer) { gSetExceptionDialogs(false); }
+
     // handle XDG args
 #ifdef Q_OS_LINUX
     const auto handleXDGActs = AppSupport::handleXDGArgs(isRenderer,
@@ -126,7 +131,7 @@ int main(int argc, char *argv[])
 #endif
 
     QSplashScreen splash(QPixmap(":/icons/splash/splash-00001.png"));
-    splash.show();
+    if (!isRenderer) { splash.show(); }
     splash.raise();
     splash.showMessage(QObject::tr("Loading ..."),
                        Qt::AlignRight | Qt::AlignBottom, Qt::white);
@@ -140,7 +145,7 @@ int main(int argc, char *argv[])
 #endif
 
 #ifndef Q_OS_DARWIN
-    const bool threadedOpenGL = QOpenGLContext::supportsThreadedOpenGL();
+    const bool threadedOpenGL = isRenderer || QOpenGLContext::supportsThreadedOpenGL();
     if (!threadedOpenGL) {
         gPrintException("Your GPU drivers do not support OpenGL "
                         "rendering outside the main thread");
@@ -148,7 +153,7 @@ int main(int argc, char *argv[])
 #endif
 
     try {
-        HardwareInfo::sUpdateInfo();
+        HardwareInfo::sUpdateInfo(!isRenderer);
     } catch(const std::exception& e) {
         GPU_NOT_COMPATIBLE;
         gPrintExceptionCritical(e);
@@ -235,16 +240,23 @@ int main(int argc, char *argv[])
     QObject::connect(&memoryHandler, &MemoryHandler::finishedCriticalState,
                      &taskScheduler, &TaskScheduler::finishCriticalMemoryState);
 
+    // record task trace (chrome://tracing, ui.perfetto.dev)
+    const QString taskTracePath = QString(qgetenv("FRICTION_TASK_TRACE"));
+    if (!taskTracePath.isEmpty()) { TaskTracer::sStart(); }
+
     Document document(taskScheduler);
     Actions actions(document);
 
+    // the cli renderer runs without GPU context (CPU path only)
     EffectsLoader effectsLoader;
-    try {
-        effectsLoader.initializeGpu();
-        taskScheduler.initializeGpu();
-    } catch(const std::exception& e) {
-        GPU_NOT_COMPATIBLE;
-        gPrintExceptionFatal(e);
+    if (!isRenderer) {
+        try {
+            effectsLoader.initializeGpu();
+            taskScheduler.initializeGpu();
+        } catch(const std::exception& e) {
+            GPU_NOT_COMPATIBLE;
+            gPrintExceptionFatal(e);
+        }
     }
 
     // disabled for now
@@ -263,11 +275,13 @@ int main(int argc, char *argv[])
 #endif
 
     // init shaders
-    try {
-        effectsLoader.iniShaderEffects();
-    } catch(const std::exception& e) {
-        GPU_NOT_COMPATIBLE;
-        gPrintExceptionCritical(e);
+    if (!isRenderer) {
+        try {
+            effectsLoader.iniShaderEffects();
+        } catch(const std::exception& e) {
+            GPU_NOT_COMPATIBLE;
+            gPrintExceptionCritical(e);
+        }
     }
     QObject::connect(&effectsLoader, &EffectsLoader::programChanged,
     [&document](ShaderEffectProgram * program) {
@@ -318,6 +332,15 @@ int main(int argc, char *argv[])
     // check for ffmpeg version
     AppSupport::checkFFmpeg(isRenderer);
 
+    if (isRenderer) {
+        CommandLineRenderer renderer(document, renderHandler);
+        const int result = renderer.exec(QApplication::arguments());
+        if (!taskTracePath.isEmpty() && TaskTracer::sEnabled()) {
+            TaskTracer::sStop(taskTracePath);
+        }
+        return result;
+    }
+
 #ifdef Q_OS_WIN
     splash.raise();
     splash.setPixmap(QPixmap(":/icons/splash/splash-00006.png"));
@@ -339,7 +362,11 @@ int main(int argc, char *argv[])
 #endif
 
     try {
-        return app.exec();
+        const int result = app.exec();
+        if (!taskTracePath.isEmpty() && TaskTracer::sEnabled()) {
+            TaskTracer::sStop(taskTracePath);
+        }
+        return result;
     } catch(const std::exception& e) {
         gPrintExceptionFatal(e);
         return -1;
@@ -26,6 +26,7 @@
 #include "memoryhandler.h"
 #include "Boxes/boxrendercontainer.h"
 #include "GUI/mainwindow.h"
+#include "pixelbufferpool.h"
 #include <QMetaType>
 
 #ifdef Q_OS_MAC
@@ -97,9 +98,11 @@ void MemoryHandler::freeMemory(const MemoryState newState,
     }
 
     if(minFreeBytes.fValue <= 0) return;
-    qint64 memToFree = minFreeBytes.fValue;
+    // idle pooled buffers go first, nothing has to be recomputed for them
+    qint64 memToFree = minFreeBytes.fValue - PixelBufferPool::sClear();
+    if(memToFree > 0) mDataHandler.updatePriorities();
     while(memToFree > 0 && !mDataHandler.isEmpty()) {
-        const auto cont = mDataHandler.takeFirst();
+        const auto cont = mDataHandler.takeCheapest();
         memToFree -= cont->free_RAM_k();
     }
     if(newState == CRITICAL_MEMORY_STATE ||
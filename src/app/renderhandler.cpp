@@ -32,6 +32,7 @@
 #include "CacheHandlers/soundcachecontainer.h"
 #include "CacheHandlers/sceneframecontainer.h"
 #include "Private/document.h"
+#include "Private/esettings.h"
 
 RenderHandler* RenderHandler::sInstance = nullptr;
 
@@ -107,6 +108,21 @@ void RenderHandler::renderFromSettings(RenderInstanceSettings * const settings)
         mCurrentScene->anim_setAbsFrame(mCurrentRenderFrame);
         mCurrentScene->setOutputRendering(true);
         TaskScheduler::instance()->setAlwaysQue(true);
+        TaskScheduler::instance()->setQuePriority(eTaskPriority::background);
+        mFramesInFlight = outputFramesInFlight();
+        TaskScheduler::instance()->setMaxQues(mFramesInFlight);
+        if(!VideoEncoder::sEncodeVideo()) {
+            // audio only, no scene frames have to be rendered
+            mCurrentEncodeFrame = mMaxRenderFrame + 1;
+            mCurrentRenderFrame = mMaxRenderFrame;
+            mCurrentSoundComposition->scheduleFrameRange({mMinRenderFrame,
+                                                          mMaxRenderFrame});
+            mCurrentSoundComposition->setMaxFrameUseRange(mMaxRenderFrame);
+            if(TaskScheduler::sAllQuedCpuTasksFinished()) {
+                nextSaveOutputFrame();
+            }
+            return;
+        }
         //fitSceneToSize();
         if(!isZero6Dec(mSavedResolutionFraction - resolutionFraction)) {
             mCurrentScene->setResolution(resolutionFraction);
@@ -156,6 +172,28 @@ void RenderHandler::nextCurrentRenderFrame() {
     else setFrameAction(mCurrentRenderFrame);
 }
 
+int RenderHandler::outputFramesInFlight() const {
+    const auto& sett = eSettings::instance();
+    if(!sett.fParallelOutput) return 0;
+    const int requested = sett.fOutputFramesInFlight > 0 ?
+                sett.fOutputFramesInFlight :
+                2*eSettings::sCpuThreadsCapped();
+    // frames waiting in the reorder buffer may take at most a quarter of RAM
+    const qreal res = mCurrentRenderSettings->getRenderSettings().fResolution;
+    const qreal frameBytes = qMax(1., 4*res*mCurrentScene->getCanvasWidth()*
+                                      res*mCurrentScene->getCanvasHeight());
+    const qreal budget = eSettings::sRamMBCap().fValue*1024.*1024./4;
+    const int fitting = static_cast<int>(budget/frameBytes);
+    // never fewer frames than the sequential export kept the cpu busy with
+    const int minimum = qMax(1, eSettings::sCpuThreadsCapped());
+    return qMax(minimum, qMin(requested, fitting));
+}
+
+bool RenderHandler::outputWindowFull() const {
+    if(mFramesInFlight <= 0) return false;
+    return mCurrentRenderFrame - mCurrentEncodeFrame + 1 >= mFramesInFlight;
+}
+
 void RenderHandler::setPreviewState(const PreviewState state)
 {
     if (mPreviewState == state) { return; }
@@ -218,6 +256,8 @@ void RenderHandler::setRenderingPreview(const bool rendering) {
     mRenderingPreview = rendering;
     if(mCurrentScene) mCurrentScene->setRenderingPreview(rendering);
     TaskScheduler::instance()->setAlwaysQue(rendering);
+    TaskScheduler::instance()->setQuePriority(rendering ? eTaskPriority::lookAhead :
+                                                          eTaskPriority::interactive);
 }
 
 void RenderHandler::setPreviewing(const bool previewing) {
@@ -232,7 +272,10 @@ void RenderHandler::interruptPreviewRendering() {
 
 void RenderHandler::interruptOutputRendering() {
     if(mCurrentScene) mCurrentScene->setOutputRendering(false);
+    mFramesInFlight = 0;
+    TaskScheduler::instance()->setMaxQues(0);
     TaskScheduler::instance()->setAlwaysQue(false);
+    TaskScheduler::instance()->setQuePriority(eTaskPriority::interactive);
     TaskScheduler::sClearAllFinishedFuncs();
     stopPreview();
 }
@@ -343,7 +386,10 @@ void RenderHandler::finishEncoding() {
     TaskScheduler::sClearAllFinishedFuncs();
     mCurrentRenderSettings = nullptr;
     mCurrentScene->setOutputRendering(false);
+    mFramesInFlight = 0;
+    TaskScheduler::instance()->setMaxQues(0);
     TaskScheduler::instance()->setAlwaysQue(false);
+    TaskScheduler::instance()->setQuePriority(eTaskPriority::interactive);
     setFrameAction(mSavedCurrentFrame);
     if(!isZero4Dec(mSavedResolutionFraction - mCurrentScene->getResolution())) {
         mCurrentScene->setResolution(mSavedResolutionFraction);
@@ -374,6 +420,8 @@ void RenderHandler::nextSaveOutputFrame() {
     }
     if(mCurrentEncodeSoundSecond > mMaxSoundSec) VideoEncoder::sAllAudioProvided();
 
+    // the scene frame cache doubles as the reorder buffer,
+    // frames finished out of order wait there for their turn
     const auto& cacheHandler = mCurrentScene->getSceneFramesHandler();
     while(mCurrentEncodeFrame <= mMaxRenderFrame) {
         const auto cont = cacheHandler.atFrame(mCurrentEncodeFrame);
@@ -381,6 +429,11 @@ void RenderHandler::nextSaveOutputFrame() {
         VideoEncoder::sAddCacheContainerToEncoder(cont->ref<SceneFrameContainer>());
         mCurrentEncodeFrame = cont->getRangeMax() + 1;
     }
+    if(mFramesInFlight > 0) {
+        // encoded frames no longer need to stay in memory
+        const int minUse = qMin(mCurrentEncodeFrame, mCurrentRenderFrame);
+        mCurrentScene->setMinFrameUseRange(minUse);
+    }
 
     //mCurrentScene->renderCurrentFrameToOutput(*mCurrentRenderSettings);
     if(mCurrentRenderFrame >= mMaxRenderFrame) {
@@ -395,7 +448,7 @@ void RenderHandler::nextSaveOutputFrame() {
                 finishEncoding();
             });
         }
-    } else {
+    } else if(!outputWindowFull()) {
         mCurrentRenderSettings->setCurrentRenderFrame(mCurrentRenderFrame);
         nextCurrentRenderFrame();
         if(TaskScheduler::sAllTasksFinished()) {
@@ -87,6 +87,9 @@ private:
     void nextPreviewFrame();
     void nextCurrentRenderFrame();
 
+    int outputFramesInFlight() const;
+    bool outputWindowFull() const;
+
     void setPreviewState(const PreviewState state);
     void setRenderingPreview(const bool rendering);
     void setPreviewing(const bool previewing);
@@ -119,6 +122,8 @@ private:
     //! @brief true if currently preview is being rendered
     bool mRenderingPreview = false;
 
+    //! @brief Frames rendered ahead of the encoder, 0 - one frame at a time
+    int mFramesInFlight = 0;
     int mCurrentEncodeFrame;
     int mCurrentEncodeSoundSecond;
     int mMaxSoundSec;
@@ -47,7 +47,7 @@ struct AnimationBoxRenderData : public ImageContainerRenderData {
 
     void loadImageFromHandler();
 
-    const qptr<AnimationFrameHandler> fSrcCacheHandler;
+    qptr<AnimationFrameHandler> fSrcCacheHandler;
     int fAnimFrame;
 };
 
@@ -158,6 +158,23 @@ void AnimationBox::setAnimationFramesHandler(const qsptr<AnimationFrameHandler>&
     mSrcFramesCache = src;
 }
 
+void AnimationBox::setProxyFramesHandler(
+        const qsptr<AnimationFrameHandler>& proxy, const QSize& sourceSize) {
+    mProxyFramesCache = proxy;
+    mProxySourceSize = sourceSize;
+    prp_afterWholeInfluenceRangeChanged();
+}
+
+AnimationFrameHandler* AnimationBox::framesHandlerFor(
+        const int animFrame, const Canvas* const scene) const {
+    // output renders and full resolution previews read the source
+    const bool proxy = mProxyFramesCache && scene &&
+                       !scene->isRenderingOutput() &&
+                       scene->getResolution() < 1 &&
+                       animFrame < mProxyFramesCache->getFrameCount();
+    return proxy ? mProxyFramesCache.get() : mSrcFramesCache.get();
+}
+
 void AnimationBox::anim_setAbsFrame(const int frame) {
     BoundingBox::anim_setAbsFrame(frame);
     if(!mSrcFramesCache) return;
@@ -312,14 +329,24 @@ void AnimationBox::setupRenderData(const qreal relFrame,
     const auto imgData = static_cast<AnimationBoxRenderData*>(data);
     const int animFrame = getAnimationFrameForRelFrame(relFrame);
     imgData->fAnimFrame = animFrame;
-    const auto upd = mSrcFramesCache->scheduleFrameLoad(animFrame);
+    const auto src = framesHandlerFor(animFrame, scene);
+    imgData->fSrcCacheHandler = src;
+    imgData->fSourceSize = src == mProxyFramesCache.get() ? mProxySourceSize :
+                                                            QSize();
+    const auto upd = src->scheduleFrameLoad(animFrame);
     if(upd) upd->addDependent(imgData);
     else {
-        const auto cont = mSrcFramesCache->getFrameAtFrame(animFrame);
+        const auto cont = src->getFrameAtFrame(animFrame);
         imgData->setContainer(cont);
     }
 }
 
+void AnimationBox::prefetchFrame(const qreal relFrame) {
+    if(!mSrcFramesCache || mSrcFramesCache->getFrameCount() <= 0) return;
+    const int animFrame = getAnimationFrameForRelFrame(relFrame);
+    framesHandlerFor(animFrame, getParentScene())->scheduleFrameLoad(animFrame);
+}
+
 stdsptr<BoxRenderData> AnimationBox::createRenderData() {
     return enve::make_shared<AnimationBoxRenderData>(mSrcFramesCache.get(), this);
 }
@@ -54,6 +54,7 @@ public:
                          Canvas * const scene);
     stdsptr<BoxRenderData> createRenderData();
     bool shouldScheduleUpdate();
+    void prefetchFrame(const qreal relFrame);
     void saveSVG(SvgExporter& exp, DomEleTask* const task) const;
 
     FixedLenAnimationRect *getAnimationDurationRect() const;
@@ -71,13 +72,21 @@ public:
     void reload();
 protected:
     void setAnimationFramesHandler(const qsptr<AnimationFrameHandler>& src);
+    //! @brief Reduced frames drawn at sourceSize in previews below 100%
+    void setProxyFramesHandler(const qsptr<AnimationFrameHandler>& proxy,
+                               const QSize& sourceSize);
 private:
+    AnimationFrameHandler* framesHandlerFor(const int animFrame,
+                                            const Canvas* const scene) const;
+
     //void createPaintObject(const int firstAbsFrame,
       //                     const int lastAbsFrame,
         //                   const int increment);
 
     qreal mStretch = 1;
     qsptr<AnimationFrameHandler> mSrcFramesCache;
+    qsptr<AnimationFrameHandler> mProxyFramesCache;
+    QSize mProxySourceSize;
     qsptr<IntFrameRemapping> mFrameRemapping;
 };
 
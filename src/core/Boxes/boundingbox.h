@@ -222,6 +222,8 @@ public:
 
     virtual bool shouldScheduleUpdate() { return true; }
     virtual void queTasks();
+    //! @brief Starts loading source media needed to render relFrame.
+    virtual void prefetchFrame(const qreal relFrame) { Q_UNUSED(relFrame) }
 
     virtual void writeIdentifier(eWriteStream& dst) const;
 
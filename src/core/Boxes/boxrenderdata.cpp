@@ -26,6 +26,8 @@
 #include "boxrenderdata.h"
 #include "boundingbox.h"
 #include "skia/skiahelpers.h"
+#include "pixelbufferpool.h"
+#include "exceptions.h"
 #include "efiltersettings.h"
 #include "Private/Tasks/taskscheduler.h"
 #include "Private/Tasks/gputaskexecutor.h"
@@ -136,8 +138,9 @@ void BoxRenderData::processGpu(QGL33 * const gl,
                                                      kRGBA_8888_SkColorType);
     if(mEffectsRenderer.isEmpty() ||
        mEffectsRenderer.nextHardwareSupport() == HardwareSupport::cpuOnly)
-        fRenderedImage = fRenderedImage->makeRasterImage();
+        fRenderedImage = PixelBufferPool::sMakeRasterImage(fRenderedImage);
     else mEffectsRenderer.processGpu(gl, context, this);
+    updateMemoryTag();
 //    if(mEffectsRenderer.isEmpty()) return;
 //    const auto nextEffectHw = mEffectsRenderer.nextHardwareSupport();
 //    if(nextEffectHw != HardwareSupport::cpuOnly) {
@@ -153,7 +156,9 @@ void BoxRenderData::process() {
 
     const auto info = SkiaHelpers::getPremulRGBAInfo(fGlobalRect.width(),
                                                      fGlobalRect.height());
-    mBitmap.allocPixels(info);
+    if(!PixelBufferPool::sTryAllocPixels(mBitmap, info)) {
+        RuntimeThrow("Could not allocate memory for a box bitmap");
+    }
     mBitmap.eraseColor(eraseColor());
     SkCanvas canvas(mBitmap);
     transformRenderCanvas(canvas);
@@ -161,11 +166,14 @@ void BoxRenderData::process() {
     drawSk(&canvas);
 
     fRenderedImage = SkiaHelpers::transferDataToSkImage(mBitmap);
+    updateMemoryTag();
 }
 
 void BoxRenderData::beforeProcessing(const Hardware hw) {
     Q_UNUSED(hw)
     Q_ASSERT(mStep != Step::EFFECTS);
+    mOwnerName = traceOwner();
+    mMemoryTag.setOwner(mOwnerName);
     setupRenderData();
     if(!mDataSet) dataSet();
     if(isZero4Dec(fOpacity)) finishedProcessing();
@@ -180,6 +188,13 @@ void BoxRenderData::afterProcessing() {
     } else if(mCopySource) {
         mCopySource->addImageCopy(std::move(fRenderedImage));
     }
+    updateMemoryTag();
+}
+
+void BoxRenderData::updateMemoryTag() {
+    if(!fRenderedImage) return mMemoryTag.setBytes(0);
+    mMemoryTag.setBytes(qint64(fRenderedImage->width())*
+                        fRenderedImage->height()*4);
 }
 
 void BoxRenderData::afterQued() {
@@ -202,12 +217,29 @@ void BoxRenderData::queTaskNow() {
     TaskScheduler::instance()->queCpuTask(ref<eTask>());
 }
 
+qreal BoxRenderData::estimatedCost() const {
+    // roughly proportional to the number of pixels touched
+    const qreal megaPixels = qreal(fGlobalRect.width())*
+                             fGlobalRect.height()/1000000.;
+    return 1 + megaPixels*(1 + mEffectsRenderer.remaining());
+}
+
+qreal BoxRenderData::renderCostMs() const {
+    return processingNs()/1000000.;
+}
+
+QString BoxRenderData::traceOwner() const {
+    return fParentBox ? fParentBox->prp_getName() : QString();
+}
+
 bool BoxRenderData::nextStep() {
+    const bool gpu = TaskScheduler::sGpuAvailable();
+    if(!gpu) mEffectsRenderer.skipGpuOnly();
     const bool result = !mEffectsRenderer.isEmpty() &&
                         fRenderedImage;
     if(result) {
         mStep = Step::EFFECTS;
-        if(hardwareSupport() == HardwareSupport::cpuOnly) {
+        if(!gpu || hardwareSupport() == HardwareSupport::cpuOnly) {
             mEffectsRenderer.processCpu(this);
         } else {
             GpuTaskExecutor::sAddTask(ref<eTask>());
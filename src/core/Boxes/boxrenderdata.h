@@ -35,6 +35,7 @@ class BoundingBox;
 class ShaderProgramCallerBase;
 #include "smartPointers/ememory.h"
 #include "effectsrenderer.h"
+#include "memoryaccounting.h"
 
 class RenderDataCustomizerFunctor;
 struct CORE_EXPORT BoxRenderData : public eTask {
@@ -80,6 +81,14 @@ public:
     void processGpu(QGL33 * const gl, SwitchableContext &context);
     void process();
 
+    qreal estimatedCost() const;
+    //! @brief Measured time it took to render this data, in milliseconds.
+    virtual qreal renderCostMs() const;
+    QString traceOwner() const;
+    qreal traceFrame() const { return fRelFrame; }
+    //! @brief traceOwner as of beforeProcessing, safe to read from workers.
+    const QString& ownerName() const { return mOwnerName; }
+
     stdsptr<BoxRenderData> makeCopy();
     sk_sp<SkImage> requestImageCopy();
 
@@ -135,12 +144,16 @@ protected:
     bool mDelayDataSet = false;
     bool mDataSet = false;
 private:
+    void updateMemoryTag();
+
     void addImageCopy(const sk_sp<SkImage>& img) {
         mImageCopies << img;
     }
 
     Step mStep = Step::BOX_IMAGE;
     EffectsRenderer mEffectsRenderer;
+    MemoryAccounting::Tag mMemoryTag{MemoryAccounting::Category::rendering};
+    QString mOwnerName;
     stdptr<BoxRenderData> mCopySource;
     QList<sk_sp<SkImage>> mImageCopies;
 };
@@ -393,6 +393,15 @@ void ContainerBox::queTasks() {
     else BoundingBox::queTasks();
 }
 
+void ContainerBox::prefetchFrame(const qreal relFrame) {
+    const qreal absFrame = prp_relFrameToAbsFrameF(relFrame);
+    for(const auto &child : mContainedBoxes) {
+        const qreal childRelFrame = child->prp_absFrameToRelFrameF(absFrame);
+        if(!child->isFrameFVisibleAndInDurationRect(childRelFrame)) continue;
+        child->prefetchFrame(childRelFrame);
+    }
+}
+
 void ContainerBox::promoteToLayer()
 {
     if (!isGroup()) { return; }
@@ -150,6 +150,7 @@ public:
 
     void queChildrenTasks();
     void queTasks();
+    void prefetchFrame(const qreal relFrame);
 
     void writeAllContained(eWriteStream &dst) const;
     void writeAllContainedXEV(const stdsptr<XevZipFileSaver>& fileSaver,
@@ -70,6 +70,14 @@ void EffectsRenderer::setBaseGlobalRect(SkIRect &currRect,
     }
 }
 
+void EffectsRenderer::skipGpuOnly() {
+    while(mCurrentId < mEffects.count()) {
+        const auto& effect = mEffects.at(mCurrentId);
+        if(effect->hardwareSupport() != HardwareSupport::gpuOnly) break;
+        mCurrentId++;
+    }
+}
+
 HardwareSupport EffectsRenderer::nextHardwareSupport() const
 {
     //Q_ASSERT(!isEmpty());
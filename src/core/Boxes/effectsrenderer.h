@@ -44,6 +44,10 @@ public:
     void processCpu(BoxRenderData * const boxData);
 
     bool isEmpty() const { return mCurrentId >= mEffects.count(); }
+    int remaining() const { return mEffects.count() - mCurrentId; }
+
+    //! @brief Drops pending GPU only effects, used when there is no GPU.
+    void skipGpuOnly();
 
     void setBaseGlobalRect(SkIRect& currRect,
                            const SkIRect& skMaxBounds) const;
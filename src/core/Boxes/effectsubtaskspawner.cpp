@@ -27,9 +27,11 @@
 #include "boxrenderdata.h"
 #include "Private/Tasks/taskscheduler.h"
 #include "skia/skiaincludes.h"
+#include "pixelbufferpool.h"
 #include "RasterEffects/rastereffect.h"
 #include "RasterEffects/rastereffectcaller.h"
 #include "Private/Tasks/taskexecutor.h"
+#include "Private/Tasks/tasktracer.h"
 
 class EffectSubTaskSpawner_priv {
 public:
@@ -59,10 +61,13 @@ private:
 void EffectSubTaskSpawner_priv::initialize() {
     SkPixmap pixmap;
     const auto& srcImg = mData->fRenderedImage;
-    mSrcRasterImg = srcImg->makeRasterImage();
+    mSrcRasterImg = PixelBufferPool::sMakeRasterImage(srcImg);
     mSrcRasterImg->peekPixels(&pixmap);
     mSrcBitmap.installPixels(pixmap);
-    if(mUseDst) mDstBitmap.allocPixels(mSrcBitmap.info());
+    if(mUseDst && !PixelBufferPool::sTryAllocPixels(mDstBitmap,
+                                                    mSrcBitmap.info())) {
+        mDstBitmap.allocPixels(mSrcBitmap.info());
+    }
     spawn();
 }
 
@@ -84,6 +89,10 @@ void EffectSubTaskSpawner_priv::splitSpawn(CpuRenderData& data,
                 CpuRenderTools tools{mSrcBitmap, dstBitmap};
                 mEffectCaller->processCpu(tools, data);
             }, decRemaining, decRemaining);
+        if(TaskTracer::sEnabled()) {
+            TaskTracer::sSetup(*subTask, "EffectSubTask",
+                               mData->ownerName(), mData->traceFrame());
+        }
         CpuTaskExecutor::sAddTask(subTask);
         return;
     }
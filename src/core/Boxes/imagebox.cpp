@@ -26,6 +26,7 @@
 #include "Boxes/imagebox.h"
 
 #include <QMenu>
+#include <cmath>
 
 #include "FileCacheHandlers/imagecachehandler.h"
 #include "fileshandler.h"
@@ -139,10 +140,16 @@ void ImageBox::setupRenderData(const qreal relFrame, const QMatrix& parentM,
     if (!mFileHandler) { mFileHandler.assign(mPath); }
     BoundingBox::setupRenderData(relFrame, parentM, data, scene);
     const auto imgData = static_cast<ImageBoxRenderData*>(data);
-    if (mFileHandler->hasImage()) {
-        imgData->setContainer(mFileHandler->getImageContainer());
+    // decode no more pixels than end up on screen
+    const QMatrix& m = imgData->fTotalTransform;
+    const qreal sx = std::sqrt(m.m11()*m.m11() + m.m12()*m.m12());
+    const qreal sy = std::sqrt(m.m21()*m.m21() + m.m22()*m.m22());
+    const qreal scale = qMax(sx, sy)*imgData->fResolution;
+    imgData->fLevel = mFileHandler->levelForScale(scale);
+    if (mFileHandler->hasImage(imgData->fLevel)) {
+        imgData->loadImageFromHandler();
     } else {
-        const auto loader = mFileHandler->scheduleLoad();
+        const auto loader = mFileHandler->scheduleLoad(imgData->fLevel);
         if (loader) { loader->addDependent(imgData); }
     }
 }
@@ -182,6 +189,7 @@ void ImageBox::saveSVG(SvgExporter& exp, DomEleTask* const eleTask) const {
 
 void ImageBoxRenderData::loadImageFromHandler() {
     if(fSrcCacheHandler) {
-        setContainer(fSrcCacheHandler->getImageContainer());
+        setContainer(fSrcCacheHandler->getImageContainer(fLevel));
+        fSourceSize = fSrcCacheHandler->sourceSize();
     }
 }
@@ -40,6 +40,7 @@ struct CORE_EXPORT ImageBoxRenderData : public ImageContainerRenderData {
     void loadImageFromHandler();
 
     const qptr<ImageFileHandler> fSrcCacheHandler;
+    int fLevel = 0;
 };
 
 class CORE_EXPORT ImageBox : public BoundingBox {
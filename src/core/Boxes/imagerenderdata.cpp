@@ -30,14 +30,29 @@ ImageRenderData::ImageRenderData(BoundingBox * const parentBoxT) :
     mDelayDataSet = true;
 }
 
+QSize ImageRenderData::imageSize() const {
+    if(!fImage) return QSize(0, 0);
+    if(fImageFormat != CompactFrame::Format::rgba) return fImageSize;
+    return QSize(fImage->width(), fImage->height());
+}
+
+QSize ImageRenderData::sourceSize() const {
+    if(!fSourceSize.isEmpty()) return fSourceSize;
+    return imageSize();
+}
+
+bool ImageRenderData::scaledImage() const {
+    return fImage && sourceSize() != imageSize();
+}
+
 void ImageRenderData::updateRelBoundingRect() {
-    if(fImage) fRelBoundingRect =
-            QRectF(0, 0, fImage->width(), fImage->height());
-    else fRelBoundingRect = QRectF(0, 0, 0, 0);
+    fRelBoundingRect = QRectF(QPointF(0, 0), sourceSize());
 }
 
 void ImageRenderData::setupRenderData() {
     if(!fImage) loadImageFromHandler();
+    // compact frames are expanded on a worker thread, in drawSk
+    if(CompactFrame::sNeedsUnpacking(fImageFormat)) return;
     if(!fForceRasterize && !hasEffects()) setupDirectDraw();
 }
 
@@ -47,6 +62,11 @@ void ImageRenderData::setupDirectDraw() {
     updateGlobalRect();
     fRenderTransform.reset();
     fRenderTransform.translate(fRelBoundingRect.x(), fRelBoundingRect.y());
+    if(scaledImage()) {
+        const QSize size = imageSize();
+        fRenderTransform.scale(fRelBoundingRect.width()/size.width(),
+                               fRelBoundingRect.height()/size.height());
+    }
     fRenderTransform *= fScaledTransform;
     fRenderTransform.translate(-fGlobalRect.x(), -fGlobalRect.y());
     fUseRenderTransform = true;
@@ -56,25 +76,47 @@ void ImageRenderData::setupDirectDraw() {
 }
 
 void ImageRenderData::drawSk(SkCanvas * const canvas) {
+    const bool unpack = CompactFrame::sNeedsUnpacking(fImageFormat);
+    const auto image = unpack ? CompactFrame::sUnpack(fImage, fImageFormat,
+                                                      fImageSize.width(),
+                                                      fImageSize.height()) :
+                                fImage;
+    if(!image) return;
     const float x = static_cast<float>(fRelBoundingRect.x());
     const float y = static_cast<float>(fRelBoundingRect.y());
-    if(fFilterQuality > kNone_SkFilterQuality) {
+    if(scaledImage()) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setFilterQuality(qMax(fFilterQuality, kLow_SkFilterQuality));
+        const auto dst = SkRect::MakeXYWH(
+                    x, y, static_cast<float>(fRelBoundingRect.width()),
+                    static_cast<float>(fRelBoundingRect.height()));
+        canvas->drawImageRect(image, dst, &paint);
+    } else if(fFilterQuality > kNone_SkFilterQuality) {
         SkPaint paint;
         paint.setAntiAlias(true);
         paint.setFilterQuality(fFilterQuality);
-        canvas->drawImage(fImage, x, y, &paint);
-    } else if(fImage) canvas->drawImage(fImage, x, y);
+        canvas->drawImage(image, x, y, &paint);
+    } else canvas->drawImage(image, x, y);
 }
 
 void ImageContainerRenderData::setContainer(ImageCacheContainer *container) {
     if(!container) return;
     mSrcContainer = container;
-    fImage = container->requestImageCopy();
+    fImageFormat = container->format();
+    if(fImageFormat == CompactFrame::Format::rgba) {
+        fImage = container->requestImageCopy();
+    } else {
+        // only read when drawn, no copy needed
+        fImage = container->getImage();
+        fImageSize = container->frameSize();
+    }
 }
 
 void ImageContainerRenderData::afterProcessing() {
     BoxRenderData::afterProcessing();
-    if(mSrcContainer && fImage) {
+    if(mSrcContainer && fImage &&
+       fImageFormat == CompactFrame::Format::rgba) {
         mSrcContainer->addImageCopy(fImage);
     }
 }
@@ -37,7 +37,16 @@ struct CORE_EXPORT ImageRenderData : public BoxRenderData {
     void setupRenderData() final;
 
     sk_sp<SkImage> fImage;
+    //! @brief Layout of fImage, compact frames are expanded when drawn.
+    CompactFrame::Format fImageFormat = CompactFrame::Format::rgba;
+    //! @brief Size of the frame in fImage if it is compact.
+    QSize fImageSize;
+    //! @brief Size fImage stands for, empty if it is at full resolution.
+    QSize fSourceSize;
 private:
+    QSize imageSize() const;
+    QSize sourceSize() const;
+    bool scaledImage() const;
     void setupDirectDraw();
 
     void drawSk(SkCanvas * const canvas);
@@ -35,6 +35,14 @@ void ContainerBoxRenderData::transformRenderCanvas(SkCanvas &canvas) const {
     canvas.translate(toSkScalar(-fGlobalRect.x()),
                      toSkScalar(-fGlobalRect.y()));
 }
+qreal ContainerBoxRenderData::renderCostMs() const {
+    qreal result = BoxRenderData::renderCostMs();
+    for(const auto &child : fChildrenRenderData) {
+        result += child->renderCostMs();
+    }
+    return result;
+}
+
 #include "pointhelpers.h"
 void ContainerBoxRenderData::updateRelBoundingRect() {
     fRelBoundingRect = QRectF();
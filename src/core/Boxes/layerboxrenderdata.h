@@ -67,6 +67,8 @@ public:
     ContainerBoxRenderData(BoundingBox * const parentBox);
 
     QList<ChildRenderData> fChildrenRenderData;
+
+    qreal renderCostMs() const;
 protected:
     void drawSk(SkCanvas * const canvas);
     void transformRenderCanvas(SkCanvas& canvas) const final;
@@ -83,6 +83,8 @@ void VideoBox::fileHandlerConnector(ConnContext &conn, VideoFileHandler *obj) {
                         this, &ImageBox::prp_afterWholeInfluenceRangeChanged);
         conn << connect(newDataHandler, &VideoDataHandler::frameCountUpdated,
                         this, &VideoBox::updateAnimationRange);
+        conn << connect(obj, &VideoFileHandler::proxyChanged,
+                        this, [this, obj]() { proxyChanged(obj); });
     }
 }
 
@@ -96,11 +98,27 @@ void VideoBox::fileHandlerAfterAssigned(VideoFileHandler *obj) {
     } else cacheHandler = nullptr;
     setAnimationFramesHandler(frameHandler);
     getAnimationDurationRect()->setRasterCacheHandler(cacheHandler);
+    proxyChanged(obj);
 
     soundDataChanged();
     animationDataChanged();
 }
 
+void VideoBox::proxyChanged(VideoFileHandler *obj) {
+    const auto srcHandler = obj ? obj->getFrameHandler() : nullptr;
+    const auto proxyHandler = obj ? obj->getProxyHandler() : nullptr;
+    qsptr<AnimationFrameHandler> frameHandler;
+    if(srcHandler && proxyHandler) {
+        try {
+            frameHandler = enve::make_shared<VideoFrameHandler>(proxyHandler);
+        } catch(const std::exception& e) {
+            gPrintExceptionCritical(e);
+        }
+    }
+    const QSize srcSize = srcHandler ? srcHandler->getDim() : QSize();
+    setProxyFramesHandler(frameHandler, srcSize);
+}
+
 void VideoBox::writeBoundingBox(eWriteStream& dst) const {
     AnimationBox::writeBoundingBox(dst);
     dst.writeFilePath(mFileHandler->path());
@@ -140,6 +158,22 @@ void VideoBox::changeSourceFile() {
     if(!path.isEmpty()) setFilePath(path);
 }
 
+void VideoBox::setupCanvasMenu(PropertyMenu * const menu)
+{
+    if (menu->hasActionsForType<VideoBox>()) { return; }
+    menu->addedActionsForType<VideoBox>();
+
+    const PropertyMenu::PlainSelectedOp<VideoBox> proxyOp =
+    [](VideoBox * box) { box->createProxy(); };
+    menu->addPlainAction(QIcon::fromTheme("video"), tr("Create Proxy"), proxyOp);
+
+    AnimationBox::setupCanvasMenu(menu);
+}
+
+void VideoBox::createProxy() {
+    if(mFileHandler) mFileHandler->createProxy();
+}
+
 void VideoBox::setStretch(const qreal stretch) {
     AnimationBox::setStretch(stretch);
     mSound->setStretch(stretch);
@@ -46,6 +46,9 @@ public:
         FrameRange range;
     };
     void changeSourceFile();
+    void setupCanvasMenu(PropertyMenu * const menu);
+    //! @brief Builds the preview proxy of the source in the background
+    void createProxy();
 
     void writeBoundingBox(eWriteStream& dst) const;
     void readBoundingBox(eReadStream& src);
@@ -63,6 +66,7 @@ private:
     void soundDataChanged();
     void fileHandlerConnector(ConnContext& conn, VideoFileHandler* obj);
     void fileHandlerAfterAssigned(VideoFileHandler* obj);
+    void proxyChanged(VideoFileHandler* obj);
 
     qsptr<eVideoSound> mSound;
     FileHandlerObjRef<VideoFileHandler> mFileHandler;
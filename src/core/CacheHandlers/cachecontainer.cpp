@@ -37,10 +37,27 @@ CacheContainer::~CacheContainer() {
 
 int CacheContainer::free_RAM_k() {
     const int bytes = getByteCount();
+    mMemoryTag.setBytes(0);
     noDataLeft_k();
     return bytes;
 }
 
+void CacheContainer::setRecomputeCost(const qreal costMs) {
+    mRecomputeCost = qMax(0.01, costMs);
+    if(mHandledByMemoryHandler)
+        MemoryDataHandler::sInstance->priorityChanged(this);
+}
+
+void CacheContainer::setMemoryOwner(const MemoryAccounting::Category category,
+                                    const QString &owner) {
+    mMemoryTag.setCategory(category);
+    mMemoryTag.setOwner(owner);
+}
+
+void CacheContainer::updateMemoryTag() {
+    mMemoryTag.setBytes(accountedBytes());
+}
+
 void CacheContainer::addToMemoryManagment() {
     if(mHandledByMemoryHandler || mInUse) return;
     MemoryDataHandler::sInstance->addContainer(this);
@@ -25,7 +25,10 @@
 
 #ifndef MINIMALCACHECONTAINER_H
 #define MINIMALCACHECONTAINER_H
+#include <map>
+
 #include "smartPointers/stdselfref.h"
+#include "memoryaccounting.h"
 
 class CORE_EXPORT CacheContainer : public StdSelfRef {
     friend class UsePointerBase;
@@ -47,16 +50,34 @@ public:
     { return mHandledByMemoryHandler; }
 
     bool inUse() const { return mInUse; }
+
+    //! @brief Time it took to produce the cached data, in milliseconds.
+    qreal recomputeCost() const { return mRecomputeCost; }
+    void setRecomputeCost(const qreal costMs);
+    //! @brief Frames between the cached data and where it is needed next.
+    virtual int distanceFromFocus() const { return 0; }
+
+    void setMemoryOwner(const MemoryAccounting::Category category,
+                        const QString& owner);
 protected:
     void addToMemoryManagment();
     void removeFromMemoryManagment();
     void updateInMemoryManagment();
+    //! @brief Has to be called whenever getByteCount changes.
+    void updateMemoryTag();
+    //! @brief Bytes reported to MemoryAccounting, zero for data
+    //! that is accounted for elsewhere.
+    virtual qint64 accountedBytes() { return getByteCount(); }
 private:
     void incInUse();
     void decInUse();
 
     bool mHandledByMemoryHandler = false;
     int mInUse = 0;
+    qreal mRecomputeCost = 1;
+    qreal mEvictionBase = 0;
+    std::multimap<qreal, CacheContainer*>::iterator mEvictionPos;
+    MemoryAccounting::Tag mMemoryTag{MemoryAccounting::Category::other};
 };
 
 #endif // MINIMALCACHECONTAINER_H
@@ -0,0 +1,377 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "compactframe.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "skia/skiahelpers.h"
+#include "Private/esettings.h"
+#include "ReadWrite/ewritestream.h"
+#include "ReadWrite/ereadstream.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define COMPACT_SSE2
+    #include <emmintrin.h>
+#elif defined(__aarch64__)
+    #define COMPACT_NEON
+    #include <arm_neon.h>
+#endif
+
+using Format = CompactFrame::Format;
+
+namespace {
+
+struct Planes {
+    Planes(const int width, const int height) :
+        fChromaWidth((width + 1)/2),
+        fChromaHeight((height + 1)/2),
+        fStride(2*fChromaWidth) {}
+
+    int packedHeight(const int height, const bool alpha) const {
+        return height + fChromaHeight + (alpha ? height : 0);
+    }
+
+    const int fChromaWidth;
+    const int fChromaHeight;
+    const int fStride;
+};
+
+inline uint8_t clampByte(const int v) {
+    return static_cast<uint8_t>(std::min(std::max(v, 0), 255));
+}
+
+inline void rgbOf(const uint32_t px, int &r, int &g, int &b) {
+    r = px & 0xFF;
+    g = (px >> 8) & 0xFF;
+    b = (px >> 16) & 0xFF;
+}
+
+// 6 bit fixed point, the SIMD paths compute exactly the same values
+inline void yuvToRgb(const int y, const int u, const int v,
+                     int &r, int &g, int &b) {
+    r = y + ((90*v + 32) >> 6);
+    g = y - ((22*u + 46*v + 32) >> 6);
+    b = y + ((113*u + 32) >> 6);
+}
+
+void unpackRowScalar(const uint8_t * const y, const uint8_t * const u,
+                     const uint8_t * const v, const uint8_t * const a,
+                     const int first, const int n, uint32_t * const dst) {
+    for(int i = first; i < n; i++) {
+        int r, g, b;
+        yuvToRgb(y[i], u[i/2] - 128, v[i/2] - 128, r, g, b);
+        const int alpha = a ? a[i] : 255;
+        const uint32_t r8 = std::min<int>(clampByte(r), alpha);
+        const uint32_t g8 = std::min<int>(clampByte(g), alpha);
+        const uint32_t b8 = std::min<int>(clampByte(b), alpha);
+        dst[i] = r8 | g8 << 8 | b8 << 16 | static_cast<uint32_t>(alpha) << 24;
+    }
+}
+
+#ifdef COMPACT_SSE2
+int unpackRowSse2(const uint8_t * const y, const uint8_t * const u,
+                  const uint8_t * const v, const uint8_t * const a,
+                  const int n, uint32_t * const dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c32 = _mm_set1_epi16(32);
+    const __m128i c90 = _mm_set1_epi16(90);
+    const __m128i c22 = _mm_set1_epi16(22);
+    const __m128i c46 = _mm_set1_epi16(46);
+    const __m128i c113 = _mm_set1_epi16(113);
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        const __m128i y16 = _mm_unpacklo_epi8(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i)), zero);
+        int32_t u4, v4;
+        memcpy(&u4, u + i/2, 4);
+        memcpy(&v4, v + i/2, 4);
+        // every chroma sample covers two pixels of the row
+        __m128i u8 = _mm_cvtsi32_si128(u4);
+        __m128i v8 = _mm_cvtsi32_si128(v4);
+        u8 = _mm_unpacklo_epi8(u8, u8);
+        v8 = _mm_unpacklo_epi8(v8, v8);
+        const __m128i u16 = _mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), c128);
+        const __m128i v16 = _mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), c128);
+
+        const __m128i dr = _mm_srai_epi16(_mm_add_epi16(
+                    _mm_mullo_epi16(v16, c90), c32), 6);
+        const __m128i dg = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(
+                    _mm_mullo_epi16(u16, c22), _mm_mullo_epi16(v16, c46)), c32), 6);
+        const __m128i db = _mm_srai_epi16(_mm_add_epi16(
+                    _mm_mullo_epi16(u16, c113), c32), 6);
+        const __m128i r16 = _mm_add_epi16(y16, dr);
+        const __m128i g16 = _mm_sub_epi16(y16, dg);
+        const __m128i b16 = _mm_add_epi16(y16, db);
+
+        __m128i r8 = _mm_packus_epi16(r16, r16);
+        __m128i g8 = _mm_packus_epi16(g16, g16);
+        __m128i b8 = _mm_packus_epi16(b16, b16);
+        __m128i a8;
+        if(a) {
+            a8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i));
+            r8 = _mm_min_epu8(r8, a8);
+            g8 = _mm_min_epu8(g8, a8);
+            b8 = _mm_min_epu8(b8, a8);
+        } else a8 = _mm_set1_epi8(static_cast<char>(0xFF));
+
+        const __m128i rg = _mm_unpacklo_epi8(r8, g8);
+        const __m128i ba = _mm_unpacklo_epi8(b8, a8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4),
+                         _mm_unpackhi_epi16(rg, ba));
+    }
+    return i;
+}
+#endif
+
+#ifdef COMPACT_NEON
+int unpackRowNeon(const uint8_t * const y, const uint8_t * const u,
+                  const uint8_t * const v, const uint8_t * const a,
+                  const int n, uint32_t * const dst) {
+    const int16x8_t c128 = vdupq_n_s16(128);
+    const int16x8_t c32 = vdupq_n_s16(32);
+    int i = 0;
+    for(; i + 16 <= n; i += 16) {
+        const uint8x16_t yv = vld1q_u8(y + i);
+        const uint8x8_t u8 = vld1_u8(u + i/2);
+        const uint8x8_t v8 = vld1_u8(v + i/2);
+        // every chroma sample covers two pixels of the row
+        const uint8x8x2_t uu = vzip_u8(u8, u8);
+        const uint8x8x2_t vv = vzip_u8(v8, v8);
+        uint8x8_t r8[2], g8[2], b8[2];
+        for(int h = 0; h < 2; h++) {
+            const uint8x8_t yh = h ? vget_high_u8(yv) : vget_low_u8(yv);
+            const int16x8_t y16 = vreinterpretq_s16_u16(vmovl_u8(yh));
+            const int16x8_t u16 = vsubq_s16(
+                        vreinterpretq_s16_u16(vmovl_u8(uu.val[h])), c128);
+            const int16x8_t v16 = vsubq_s16(
+                        vreinterpretq_s16_u16(vmovl_u8(vv.val[h])), c128);
+            const int16x8_t dr = vshrq_n_s16(vaddq_s16(
+                        vmulq_n_s16(v16, 90), c32), 6);
+            const int16x8_t dg = vshrq_n_s16(vaddq_s16(vaddq_s16(
+                        vmulq_n_s16(u16, 22), vmulq_n_s16(v16, 46)), c32), 6);
+            const int16x8_t db = vshrq_n_s16(vaddq_s16(
+                        vmulq_n_s16(u16, 113), c32), 6);
+            r8[h] = vqmovun_s16(vaddq_s16(y16, dr));
+            g8[h] = vqmovun_s16(vsubq_s16(y16, dg));
+            b8[h] = vqmovun_s16(vaddq_s16(y16, db));
+        }
+        uint8x16x4_t px;
+        px.val[0] = vcombine_u8(r8[0], r8[1]);
+        px.val[1] = vcombine_u8(g8[0], g8[1]);
+        px.val[2] = vcombine_u8(b8[0], b8[1]);
+        if(a) {
+            px.val[3] = vld1q_u8(a + i);
+            px.val[0] = vminq_u8(px.val[0], px.val[3]);
+            px.val[1] = vminq_u8(px.val[1], px.val[3]);
+            px.val[2] = vminq_u8(px.val[2], px.val[3]);
+        } else px.val[3] = vdupq_n_u8(255);
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + i), px);
+    }
+    return i;
+}
+#endif
+
+sk_sp<SkImage> packRgb565(const SkPixmap &src) {
+    const auto info = SkImageInfo::Make(src.width(), src.height(),
+                                        kRGB_565_SkColorType,
+                                        kOpaque_SkAlphaType);
+    SkBitmap btmp;
+    if(!btmp.tryAllocPixels(info)) return nullptr;
+    if(!src.readPixels(btmp.pixmap())) return nullptr;
+    return SkiaHelpers::transferDataToSkImage(btmp);
+}
+
+sk_sp<SkImage> packYuv(const SkPixmap &src, const bool alpha) {
+    const int width = src.width();
+    const int height = src.height();
+    const Planes planes(width, height);
+    const auto info = SkImageInfo::MakeA8(planes.fStride,
+                                          planes.packedHeight(height, alpha));
+    SkBitmap btmp;
+    if(!btmp.tryAllocPixels(info)) return nullptr;
+    for(int row = 0; row < height; row++) {
+        const auto s = src.addr32(0, row);
+        const auto dstY = btmp.getAddr8(0, row);
+        for(int x = 0; x < width; x++) {
+            int r, g, b;
+            rgbOf(s[x], r, g, b);
+            dstY[x] = static_cast<uint8_t>((77*r + 150*g + 29*b + 128) >> 8);
+        }
+        if(!alpha) continue;
+        const auto dstA = btmp.getAddr8(0, height + planes.fChromaHeight + row);
+        for(int x = 0; x < width; x++) {
+            dstA[x] = static_cast<uint8_t>(s[x] >> 24);
+        }
+    }
+    for(int row = 0; row < planes.fChromaHeight; row++) {
+        const auto s0 = src.addr32(0, 2*row);
+        const auto s1 = src.addr32(0, std::min(2*row + 1, height - 1));
+        const auto dstU = btmp.getAddr8(0, height + row);
+        const auto dstV = dstU + planes.fChromaWidth;
+        for(int i = 0; i < planes.fChromaWidth; i++) {
+            const int x0 = 2*i;
+            const int x1 = std::min(x0 + 1, width - 1);
+            int r = 2, g = 2, b = 2;
+            for(const uint32_t px : {s0[x0], s0[x1], s1[x0], s1[x1]}) {
+                int pr, pg, pb;
+                rgbOf(px, pr, pg, pb);
+                r += pr; g += pg; b += pb;
+            }
+            r >>= 2; g >>= 2; b >>= 2;
+            dstU[i] = clampByte(((-43*r - 85*g + 128*b + 128) >> 8) + 128);
+            dstV[i] = clampByte(((128*r - 107*g - 21*b + 128) >> 8) + 128);
+        }
+    }
+    return SkiaHelpers::transferDataToSkImage(btmp);
+}
+
+}
+
+Format CompactFrame::sFormatFor(const bool opaque) {
+    const auto& sett = eSettings::instance();
+    if(opaque && sett.fDraftPreviewCache) return Format::rgb565;
+    if(sett.fCompactPreviewCache || sett.fDraftPreviewCache) {
+        return opaque ? Format::yuv420 : Format::yuva420;
+    }
+    return Format::rgba;
+}
+
+bool CompactFrame::sNeedsUnpacking(const Format format) {
+    return format == Format::yuv420 || format == Format::yuva420;
+}
+
+sk_sp<SkImage> CompactFrame::sPack(const SkPixmap &src, const Format format) {
+    if(src.colorType() != kRGBA_8888_SkColorType) return nullptr;
+    if(src.width() <= 0 || src.height() <= 0) return nullptr;
+    switch(format) {
+    case Format::yuv420:
+        return packYuv(src, false);
+    case Format::yuva420:
+        return packYuv(src, true);
+    case Format::rgb565:
+        return packRgb565(src);
+    default:
+        return nullptr;
+    }
+}
+
+sk_sp<SkImage> CompactFrame::sPackPlanes(const uint8_t * const planes[4],
+                                         const int linesizes[4],
+                                         const int width, const int height) {
+    if(width <= 0 || height <= 0) return nullptr;
+    const bool alpha = planes[3];
+    const Planes layout(width, height);
+    const auto info = SkImageInfo::MakeA8(layout.fStride,
+                                          layout.packedHeight(height, alpha));
+    SkBitmap btmp;
+    if(!btmp.tryAllocPixels(info)) return nullptr;
+    for(int row = 0; row < height; row++) {
+        memcpy(btmp.getAddr8(0, row), planes[0] + row*linesizes[0],
+               static_cast<size_t>(width));
+        if(!alpha) continue;
+        memcpy(btmp.getAddr8(0, height + layout.fChromaHeight + row),
+               planes[3] + row*linesizes[3], static_cast<size_t>(width));
+    }
+    const auto chromaWidth = static_cast<size_t>(layout.fChromaWidth);
+    for(int row = 0; row < layout.fChromaHeight; row++) {
+        const auto dstU = btmp.getAddr8(0, height + row);
+        memcpy(dstU, planes[1] + row*linesizes[1], chromaWidth);
+        memcpy(dstU + chromaWidth, planes[2] + row*linesizes[2], chromaWidth);
+    }
+    return SkiaHelpers::transferDataToSkImage(btmp);
+}
+
+sk_sp<SkImage> CompactFrame::sUnpack(const sk_sp<SkImage> &packed,
+                                     const Format format,
+                                     const int width, const int height) {
+    if(!packed || format == Format::rgba) return packed;
+    SkBitmap btmp;
+    const auto info = SkiaHelpers::getPremulRGBAInfo(width, height);
+    if(!btmp.tryAllocPixels(info)) return nullptr;
+    if(format == Format::rgb565) {
+        if(!packed->readPixels(btmp.pixmap(), 0, 0)) return nullptr;
+        return SkiaHelpers::transferDataToSkImage(btmp);
+    }
+    SkPixmap src;
+    if(!packed->peekPixels(&src)) return nullptr;
+    const bool alpha = format == Format::yuva420;
+    const Planes planes(width, height);
+    if(src.width() != planes.fStride ||
+       src.height() != planes.packedHeight(height, alpha)) return nullptr;
+    for(int row = 0; row < height; row++) {
+        const auto y = src.addr8(0, row);
+        const auto u = src.addr8(0, height + row/2);
+        const auto v = u + planes.fChromaWidth;
+        const auto a = alpha ?
+                    src.addr8(0, height + planes.fChromaHeight + row) : nullptr;
+        const auto dst = btmp.getAddr32(0, row);
+        int done = 0;
+#if defined(COMPACT_SSE2)
+        done = unpackRowSse2(y, u, v, a, width, dst);
+#elif defined(COMPACT_NEON)
+        done = unpackRowNeon(y, u, v, a, width, dst);
+#endif
+        unpackRowScalar(y, u, v, a, done, width, dst);
+    }
+    return SkiaHelpers::transferDataToSkImage(btmp);
+}
+
+void CompactFrame::sWrite(const sk_sp<SkImage> &packed, eWriteStream &dst) {
+    SkPixmap src;
+    if(!packed->peekPixels(&src)) RuntimeThrow("Could not peek frame pixels");
+    const int width = src.width();
+    const int height = src.height();
+    dst << width;
+    dst << height;
+    const qint64 rowBytes = qint64(width)*src.info().bytesPerPixel();
+    for(int row = 0; row < height; row++) {
+        dst.write(src.addr(0, row), rowBytes);
+    }
+}
+
+sk_sp<SkImage> CompactFrame::sRead(eReadStream &src, const Format format) {
+    int width, height;
+    src >> width;
+    src >> height;
+    SkImageInfo info;
+    if(format == Format::rgb565) {
+        info = SkImageInfo::Make(width, height, kRGB_565_SkColorType,
+                                 kOpaque_SkAlphaType);
+    } else if(sNeedsUnpacking(format)) {
+        info = SkImageInfo::MakeA8(width, height);
+    } else info = SkiaHelpers::getPremulRGBAInfo(width, height);
+    SkBitmap btmp;
+    if(!btmp.tryAllocPixels(info)) {
+        RuntimeThrow("Could not allocate memory for a frame");
+    }
+    const qint64 rowBytes = qint64(width)*info.bytesPerPixel();
+    for(int row = 0; row < height; row++) {
+        src.read(btmp.getAddr(0, row), rowBytes);
+    }
+    return SkiaHelpers::transferDataToSkImage(btmp);
+}
@@ -0,0 +1,79 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef COMPACTFRAME_H
+#define COMPACTFRAME_H
+
+#include "skia/skiaincludes.h"
+#include "core_global.h"
+
+class eWriteStream;
+class eReadStream;
+
+// Smaller layouts for scene frames that are only played back
+// and for decoded video frames.
+// Packed frames stay SkImages, so the cache counts, frees and
+// references them like any other frame.
+//
+// yuv420  - full range BT.601, 1.5 bytes per pixel, opaque frames
+// yuva420 - yuv420 plus a full resolution alpha plane, 2.5 bytes per pixel
+// rgb565  - 2 bytes per pixel, opaque frames, drawn by Skia as is
+//
+// YUV frames are kept as a single A8 image: luma rows, then rows with
+// the U and V planes side by side, then the alpha rows if any.
+namespace CompactFrame {
+    enum class Format {
+        rgba, yuv420, yuva420, rgb565
+    };
+
+    // Layout to keep a preview frame in, follows the preview cache settings.
+    CORE_EXPORT
+    Format sFormatFor(const bool opaque);
+    // True if the packed image can not be drawn as it is.
+    CORE_EXPORT
+    bool sNeedsUnpacking(const Format format);
+
+    // src has to be premultiplied kRGBA_8888_SkColorType.
+    // Returns nullptr if the frame could not be packed.
+    CORE_EXPORT
+    sk_sp<SkImage> sPack(const SkPixmap& src, const Format format);
+    // Packs full range 4:2:0 planes, e.g. of a decoded video frame,
+    // into yuv420, or into yuva420 if planes[3] is not nullptr.
+    CORE_EXPORT
+    sk_sp<SkImage> sPackPlanes(const uint8_t * const planes[4],
+                               const int linesizes[4],
+                               const int width, const int height);
+    // Expands a packed frame of the given size back to premultiplied RGBA.
+    // Uses SSE2 or NEON when available.
+    CORE_EXPORT
+    sk_sp<SkImage> sUnpack(const sk_sp<SkImage>& packed, const Format format,
+                           const int width, const int height);
+
+    // Raw rows of a packed frame, for the disk cache.
+    CORE_EXPORT
+    void sWrite(const sk_sp<SkImage>& packed, eWriteStream& dst);
+    CORE_EXPORT
+    sk_sp<SkImage> sRead(eReadStream& src, const Format format);
+};
+
+#endif // COMPACTFRAME_H
@@ -0,0 +1,187 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "framecompressor.h"
+
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+#include "skia/skiahelpers.h"
+#include "exceptions.h"
+
+enum RowType : uchar {
+    sameAsPrevious,
+    runs
+};
+
+static const int sMaxRun = 0x7fff;
+static const quint16 sRepeatFlag = 0x8000;
+
+namespace {
+    class Writer {
+    public:
+        Writer(uchar* const dst, const qint64 size) :
+            mDst(dst), mPos(dst), mEnd(dst + size) {}
+
+        bool put(const void* const src, const qint64 size) {
+            if(mEnd - mPos < size) return false;
+            memcpy(mPos, src, static_cast<size_t>(size));
+            mPos += size;
+            return true;
+        }
+
+        qint64 size() const { return mPos - mDst; }
+    private:
+        uchar* const mDst;
+        uchar* mPos;
+        uchar* const mEnd;
+    };
+
+    class Reader {
+    public:
+        Reader(const uchar* const src, const qint64 size) :
+            mPos(src), mEnd(src + size) {}
+
+        void get(void* const dst, const qint64 size) {
+            if(mEnd - mPos < size) RuntimeThrow("Corrupted compressed frame");
+            memcpy(dst, mPos, static_cast<size_t>(size));
+            mPos += size;
+        }
+    private:
+        const uchar* mPos;
+        const uchar* const mEnd;
+    };
+}
+
+static bool sWriteLiteral(Writer& dst, const quint32* const src,
+                          const int count) {
+    int done = 0;
+    while(done < count) {
+        const quint16 n = static_cast<quint16>(qMin(sMaxRun, count - done));
+        if(!dst.put(&n, sizeof(quint16))) return false;
+        if(!dst.put(src + done, n*4)) return false;
+        done += n;
+    }
+    return true;
+}
+
+static bool sWriteRow(Writer& dst, const quint32* const row,
+                      const int width) {
+    int literalStart = 0;
+    int i = 0;
+    while(i < width) {
+        const quint32 value = row[i];
+        int run = 1;
+        while(i + run < width && run < sMaxRun && row[i + run] == value) run++;
+        if(run < 3) {
+            i += run;
+            continue;
+        }
+        if(!sWriteLiteral(dst, row + literalStart, i - literalStart)) {
+            return false;
+        }
+        const quint16 n = static_cast<quint16>(run) | sRepeatFlag;
+        if(!dst.put(&n, sizeof(quint16))) return false;
+        if(!dst.put(&value, 4)) return false;
+        i += run;
+        literalStart = i;
+    }
+    return sWriteLiteral(dst, row + literalStart, width - literalStart);
+}
+
+QByteArray FrameCompressor::sCompress(const SkPixmap &pix) {
+    // sDecompress always rebuilds premultiplied RGBA
+    if(pix.colorType() != kRGBA_8888_SkColorType ||
+       pix.alphaType() != kPremul_SkAlphaType) return QByteArray();
+    const int width = pix.width();
+    const int height = pix.height();
+    const qint64 rawSize = static_cast<qint64>(width)*height*4;
+    if(rawSize <= 0 || rawSize/2 > std::numeric_limits<int>::max()) {
+        return QByteArray();
+    }
+    QByteArray result(static_cast<int>(rawSize/2), Qt::Uninitialized);
+    Writer dst(reinterpret_cast<uchar*>(result.data()), result.size());
+    if(!dst.put(&width, sizeof(int))) return QByteArray();
+    if(!dst.put(&height, sizeof(int))) return QByteArray();
+    const quint32* prevRow = nullptr;
+    for(int y = 0; y < height; y++) {
+        const auto row = static_cast<const quint32*>(pix.addr(0, y));
+        if(prevRow && memcmp(prevRow, row, static_cast<size_t>(width)*4) == 0) {
+            const uchar type = RowType::sameAsPrevious;
+            if(!dst.put(&type, 1)) return QByteArray();
+        } else {
+            const uchar type = RowType::runs;
+            if(!dst.put(&type, 1)) return QByteArray();
+            if(!sWriteRow(dst, row, width)) return QByteArray();
+        }
+        prevRow = row;
+    }
+    result.resize(static_cast<int>(dst.size()));
+    result.squeeze();
+    return result;
+}
+
+sk_sp<SkImage> FrameCompressor::sDecompress(const QByteArray &data) {
+    Reader src(reinterpret_cast<const uchar*>(data.constData()), data.size());
+    int width;
+    int height;
+    src.get(&width, sizeof(int));
+    src.get(&height, sizeof(int));
+    if(width <= 0 || height <= 0) RuntimeThrow("Corrupted compressed frame");
+    SkBitmap btmp;
+    const auto info = SkiaHelpers::getPremulRGBAInfo(width, height);
+    if(!btmp.tryAllocPixels(info)) {
+        RuntimeThrow("Could not allocate memory for a decompressed frame");
+    }
+    const quint32* prevRow = nullptr;
+    for(int y = 0; y < height; y++) {
+        const auto row = static_cast<quint32*>(btmp.pixmap().writable_addr(0, y));
+        uchar type;
+        src.get(&type, 1);
+        if(type == RowType::sameAsPrevious) {
+            if(!prevRow) RuntimeThrow("Corrupted compressed frame");
+            memcpy(row, prevRow, static_cast<size_t>(width)*4);
+        } else {
+            int x = 0;
+            while(x < width) {
+                quint16 n;
+                src.get(&n, sizeof(quint16));
+                const int count = n & sMaxRun;
+                if(count == 0 || x + count > width) {
+                    RuntimeThrow("Corrupted compressed frame");
+                }
+                if(n & sRepeatFlag) {
+                    quint32 value;
+                    src.get(&value, 4);
+                    std::fill(row + x, row + x + count, value);
+                } else {
+                    src.get(row + x, count*4);
+                }
+                x += count;
+            }
+        }
+        prevRow = row;
+    }
+    return SkiaHelpers::transferDataToSkImage(btmp);
+}
@@ -21,13 +21,25 @@
 #
 */
 
-// Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
+#ifndef FRAMECOMPRESSOR_H
+#define FRAMECOMPRESSOR_H
 
-#include "tmpdeleter.h"
-#include "imagecachecontainer.h"
-#include "skia/skiahelpers.h"
+#include <QByteArray>
 
-TmpDeleter::TmpDeleter(const qsptr<QTemporaryFile> &file) :
-    mTmpFile(file) {}
+#include "skia/skiaincludes.h"
+#include "core_global.h"
 
-void TmpDeleter::process() { mTmpFile.reset(); }
+// Lossless run length coding of premultiplied RGBA frames,
+// rows equal to the previous row are stored as a single byte.
+// Flat motion graphics frames shrink a lot while encoding and decoding
+// stay close to memcpy speed.
+namespace FrameCompressor {
+    // Returns an empty array if the frame is not premultiplied RGBA or
+    // does not compress to at most half of its raw size.
+    CORE_EXPORT
+    QByteArray sCompress(const SkPixmap& pix);
+    CORE_EXPORT
+    sk_sp<SkImage> sDecompress(const QByteArray& data);
+};
+
+#endif // FRAMECOMPRESSOR_H
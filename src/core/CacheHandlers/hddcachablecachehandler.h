@@ -98,11 +98,30 @@ public:
         mUsedRange.clearRange();
     }
 
+    const iValueRange& useRange() const {
+        return mUsedRange.range();
+    }
+
+    void setFocusFrame(const int relFrame) {
+        mFocusFrame = relFrame;
+    }
+
+    //! @brief Frames between range and the used range,
+    //! or the focus frame if no range is in use.
+    int distanceFromFocus(const FrameRange& range) const {
+        const auto focus = mUsedRange.validRange() ?
+                    mUsedRange.range() : FrameRange{mFocusFrame, mFocusFrame};
+        if(range.fMax < focus.fMin) return focus.fMin - range.fMax;
+        if(range.fMin > focus.fMax) return range.fMin - focus.fMax;
+        return 0;
+    }
+
     auto begin() const { return mConts.begin(); }
-    auto end() const { return mConts.begin(); }
+    auto end() const { return mConts.end(); }
 private:
     RangeMap<stdsptr<Cont>> mConts;
     UsedRange mUsedRange;
+    int mFocusFrame = 0;
 };
 
 #endif // HddCACHABLECACHEHANDLER_H
@@ -24,31 +24,40 @@
 // Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
 
 #include "hddcachablecont.h"
+#include "Private/esettings.h"
 
 HddCachableCont::HddCachableCont() {}
 
-HddCachableCont::~HddCachableCont() {
-    if(mTmpFile) scheduleDeleteTmpFile();
-}
+HddCachableCont::~HddCachableCont() {}
 
 int HddCachableCont::free_RAM_k() {
-    const int bytes = clearMemory();
-    setDataInMemory(false);
-    if(!mTmpFile && !mTmpSaveTask) noDataLeft_k();
+    const auto& sett = eSettings::instance();
+    int bytes = 0;
+    if(storesDataInMemory()) {
+        const bool compressed = storesCompressedData();
+        if(!compressed && !mHddSlab && sett.fRamCacheCompression) {
+            scheduleCompress();
+        }
+        if(!compressed && !mCompressTask && sett.fHddCache) {
+            scheduleSaveToTmpFile();
+        }
+        bytes = clearMemory();
+        setDataInMemory(false);
+        // the compressed copy is freed (or spilled to disk) later on
+        if(compressed && !inUse()) addToMemoryManagment();
+    } else if(storesCompressedData()) {
+        if(sett.fHddCache) scheduleSaveToTmpFile();
+        bytes = clearCompressedMemory();
+    }
+    updateMemoryTag();
+    if(hasNoData()) noDataLeft_k();
     return bytes;
 }
 
-eTask *HddCachableCont::scheduleDeleteTmpFile() {
-    if(!mTmpFile) return nullptr;
-    const auto updatable = enve::make_shared<TmpDeleter>(mTmpFile);
-    mTmpFile.reset();
-    updatable->queTask();
-    return updatable.get();
-}
-
 eTask *HddCachableCont::scheduleSaveToTmpFile() {
-    if(mTmpSaveTask || mTmpFile) return nullptr;
+    if(mTmpSaveTask || mHddSlab) return nullptr;
     mTmpSaveTask = createTmpFileDataSaver();
+    if(!mTmpSaveTask) return nullptr;
     mTmpSaveTask->queTask();
     return mTmpSaveTask.get();
 }
@@ -56,30 +65,81 @@ eTask *HddCachableCont::scheduleSaveToTmpFile() {
 eTask *HddCachableCont::scheduleLoadFromTmpFile() {
     if(storesDataInMemory()) return nullptr;
     if(mTmpLoadTask) return mTmpLoadTask.get();
-    if(!mTmpSaveTask && !mTmpFile) return nullptr;
+    const bool compressed = storesCompressedData() || mCompressTask;
+    if(!compressed && !mTmpSaveTask && !mHddSlab) return nullptr;
 
     mTmpLoadTask = createTmpFileDataLoader();
-    if(mTmpSaveTask)
+    if(mCompressTask) {
+        mCompressTask->addDependent(mTmpLoadTask.get());
+    } else if(mTmpSaveTask && !compressed) {
         mTmpSaveTask->addDependent(mTmpLoadTask.get());
+    }
     mTmpLoadTask->queTask();
     return mTmpLoadTask.get();
 }
 
-void HddCachableCont::setDataSavedToTmpFile(const qsptr<QTemporaryFile> &tmpFile) {
+void HddCachableCont::scheduleCompress() {
+    mCompressTask = createRamCompressor();
+    if(mCompressTask) mCompressTask->queTask();
+}
+
+void HddCachableCont::setDataSavedToTmpFile(const stdsptr<HddSlab> &slab) {
     mTmpSaveTask.reset();
-    mTmpFile = tmpFile;
+    mHddSlab = slab;
+    // the eviction notification might have run before the func was set
+    if(mHddSlab && mHddSlab->evicted()) mHddSlab.reset();
+    if(mHddSlab) {
+        const stdptr<HddCachableCont> thisPtr = this;
+        HddSlab* const slabPtr = slab.get();
+        mHddSlab->setEvictedFunc([thisPtr, slabPtr]() {
+            if(thisPtr) thisPtr->hddSlabEvicted(slabPtr);
+        });
+    }
+    if(hasNoData()) noDataLeft_k();
+}
+
+void HddCachableCont::afterDataLoadFailed() {
+    mTmpLoadTask.reset();
+    if(mHddSlab && mHddSlab->evicted()) mHddSlab.reset();
+    if(hasNoData()) noDataLeft_k();
+}
+
+void HddCachableCont::hddSlabEvicted(HddSlab * const slab) {
+    if(mHddSlab.get() != slab) return;
+    mHddSlab.reset();
+    if(hasNoData()) noDataLeft_k();
+}
+
+bool HddCachableCont::hasNoData() const {
+    return !storesDataInMemory() && !storesCompressedData() && !mHddSlab &&
+           !mTmpSaveTask && !mTmpLoadTask && !mCompressTask;
 }
 
 void HddCachableCont::afterDataLoadedFromTmpFile() {
     setDataInMemory(true);
     mTmpLoadTask.reset();
+    updateMemoryTag();
     if(!inUse()) addToMemoryManagment();
 }
 
+void HddCachableCont::afterDataCompressed(const bool success) {
+    mCompressTask.reset();
+    updateMemoryTag();
+    if(success) {
+        if(!storesDataInMemory() && !inUse()) addToMemoryManagment();
+    } else if(eSettings::instance().fHddCache) {
+        scheduleSaveToTmpFile();
+    }
+    if(hasNoData()) noDataLeft_k();
+}
+
 void HddCachableCont::afterDataReplaced() {
     setDataInMemory(true);
     updateInMemoryManagment();
-    if(mTmpFile) scheduleDeleteTmpFile();
+    mHddSlab.reset();
+    mCompressTask.reset();
+    clearCompressedMemory();
+    updateMemoryTag();
 }
 
 void HddCachableCont::setDataInMemory(const bool dataInMemory) {
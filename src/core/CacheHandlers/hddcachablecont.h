@@ -26,7 +26,8 @@
 #ifndef HddCACHABLECONT_H
 #define HddCACHABLECONT_H
 #include "cachecontainer.h"
-#include "tmpdeleter.h"
+#include "hddslabstore.h"
+#include "Tasks/updatable.h"
 class eTask;
 
 class CORE_EXPORT HddCachableCont : public CacheContainer {
@@ -34,30 +35,47 @@ protected:
     HddCachableCont();
     virtual int clearMemory() = 0;
     virtual stdsptr<eHddTask> createTmpFileDataSaver() = 0;
-    virtual stdsptr<eHddTask> createTmpFileDataLoader() = 0;
+    virtual stdsptr<eTask> createTmpFileDataLoader() = 0;
+
+    // Optional compressed in-memory tier between the live data
+    // and the disk cache, unused unless a compressor is provided.
+    virtual stdsptr<eTask> createRamCompressor() { return nullptr; }
+    virtual int clearCompressedMemory() { return 0; }
 public:
+    virtual bool storesCompressedData() const { return false; }
+    bool compressionPending() const { return mCompressTask.get(); }
+    bool loadPending() const { return mTmpLoadTask.get(); }
+    bool isCurrentCompressor(const eTask* const task) const
+    { return mCompressTask.get() == task; }
+
     ~HddCachableCont();
 
     int free_RAM_k() final;
 
-    eTask* scheduleDeleteTmpFile();
     eTask* scheduleSaveToTmpFile();
     eTask* scheduleLoadFromTmpFile();
 
-    void setDataSavedToTmpFile(const qsptr<QTemporaryFile> &tmpFile);
+    void setDataSavedToTmpFile(const stdsptr<HddSlab> &slab);
+    void afterDataLoadFailed();
 
     bool storesDataInMemory() const { return mDataInMemory; }
-    qsptr<QTemporaryFile> getTmpFile() const { return mTmpFile; }
+    const stdsptr<HddSlab>& getHddSlab() const { return mHddSlab; }
 protected:
     void afterDataLoadedFromTmpFile();
+    void afterDataCompressed(const bool success);
     void afterDataReplaced();
     void setDataInMemory(const bool dataInMemory);
 
-    qsptr<QTemporaryFile> mTmpFile;
+    stdsptr<HddSlab> mHddSlab;
 private:
+    void hddSlabEvicted(HddSlab* const slab);
+    bool hasNoData() const;
+    void scheduleCompress();
+
     bool mDataInMemory = false;
     stdsptr<eTask> mTmpLoadTask;
     stdsptr<eTask> mTmpSaveTask;
+    stdsptr<eTask> mCompressTask;
 };
 
 #endif // HddCACHABLECONT_H
@@ -32,6 +32,12 @@ void HddCachableRangeCont::noDataLeft_k() {
     mParentCacheHandler_k->remove(thisRef);
 }
 
+int HddCachableRangeCont::distanceFromFocus() const {
+    // e.g. still images, which are not tied to a frame
+    if(!mParentCacheHandler_k) return 0;
+    return mParentCacheHandler_k->distanceFromFocus(mRange);
+}
+
 int HddCachableRangeCont::getRangeMin() const {
     return mRange.fMin;
 }
@@ -26,7 +26,6 @@
 #ifndef HddCACHABLERANGECONT_H
 #define HddCACHABLERANGECONT_H
 #include "hddcachablecont.h"
-#include "tmpdeleter.h"
 #include "framerange.h"
 class eTask;
 class HddCachableCacheHandler;
@@ -40,6 +39,7 @@ protected:
     virtual int clearMemory() = 0;
 public:
     void noDataLeft_k();
+    int distanceFromFocus() const;
 
     int getRangeMin() const;
     const FrameRange& getRange() const { return mRange; }
@@ -0,0 +1,300 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "hddslabstore.h"
+
+#include <QDir>
+#include <QDebug>
+#include <QCoreApplication>
+
+#include "Private/esettings.h"
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#endif
+
+static const qint64 sAlignment = 4096;
+static const qint64 sChunkSize = 64*1024*1024;
+
+static qint64 sAligned(const qint64 size) {
+    return ((size + sAlignment - 1)/sAlignment)*sAlignment;
+}
+
+HddSlab::HddSlab(const std::shared_ptr<HddSlabStore>& store,
+                 const int chunk, const qint64 offset,
+                 const qint64 size, uchar * const data) :
+    mStore(store), mChunk(chunk), mOffset(offset),
+    mSize(size), mData(data) {}
+
+HddSlab::~HddSlab() {
+    mStore->release(this);
+}
+
+bool HddSlab::evicted() const {
+    std::lock_guard<std::mutex> lock(mStore->mMutex);
+    return mEvicted;
+}
+
+bool HddSlab::pin() {
+    return mStore->pin(this);
+}
+
+void HddSlab::unpin() {
+    mStore->unpin(this);
+}
+
+void HddSlab::shrink(const qint64 size) {
+    mStore->shrink(this, size);
+}
+
+HddSlabDevice::HddSlabDevice(uchar * const data, const qint64 size) :
+    mData(data), mSize(size) {}
+
+bool HddSlabDevice::seek(const qint64 pos) {
+    if(pos < 0 || pos > mSize) return false;
+    QIODevice::seek(pos);
+    mPos = pos;
+    return true;
+}
+
+qint64 HddSlabDevice::readData(char *data, qint64 maxSize) {
+    const qint64 bytes = qMin(maxSize, mSize - mPos);
+    if(bytes <= 0) return 0;
+    memcpy(data, mData + mPos, static_cast<size_t>(bytes));
+    mPos += bytes;
+    return bytes;
+}
+
+qint64 HddSlabDevice::writeData(const char *data, qint64 maxSize) {
+    if(mPos + maxSize > mSize) {
+        mOverflowed = true;
+        return -1;
+    }
+    memcpy(mData + mPos, data, static_cast<size_t>(maxSize));
+    mPos += maxSize;
+    return maxSize;
+}
+
+HddSlabStore::~HddSlabStore() {
+    for(const auto& chunk : mChunks) mFile.unmap(chunk.fData);
+}
+
+HddSlabStore *HddSlabStore::sInstance() {
+    static const std::shared_ptr<HddSlabStore> store(new HddSlabStore);
+    return store.get();
+}
+
+stdsptr<HddSlab> HddSlabStore::allocate(const qint64 size) {
+    if(size <= 0) return nullptr;
+    const qint64 alignedSize = sAligned(size);
+    const qint64 cap = eSettings::instance().fHddCacheMBCap.fValue*
+            static_cast<qint64>(1024*1024);
+    if(cap > 0 && alignedSize > cap) return nullptr;
+
+    stdsptr<HddSlab> slab;
+    std::vector<stdsptr<HddSlab>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(!mFile.isOpen() && !openFile()) return nullptr;
+        if(cap > 0) evictLru(alignedSize, cap, evicted);
+        // everything left is being read or written
+        const bool full = cap > 0 && mUsed + alignedSize > cap;
+        int chunkId;
+        qint64 offset;
+        uchar* const data = full ? nullptr :
+                                   takeSpace(alignedSize, chunkId, offset);
+        // evictions can leave whole chunks at the end of the file free
+        if(!evicted.empty()) trimChunks();
+        if(data) {
+            slab = std::make_shared<HddSlab>(shared_from_this(), chunkId,
+                                             offset, alignedSize, data);
+            slab->mSelf = slab;
+            slab->mPins = 1;
+            slab->mLruIt = mLru.insert(mLru.end(), slab.get());
+            mUsed += alignedSize;
+        }
+    }
+
+    const auto app = QCoreApplication::instance();
+    if(app) {
+        for(const auto& evictedSlab : evicted) {
+            QMetaObject::invokeMethod(app, [evictedSlab]() {
+                const auto& func = evictedSlab->mEvictedFunc;
+                if(func) func();
+            }, Qt::QueuedConnection);
+        }
+    }
+    return slab;
+}
+
+qint64 HddSlabStore::usedBytes() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mUsed;
+}
+
+qint64 HddSlabStore::fileBytes() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFileSize;
+}
+
+bool HddSlabStore::openFile() {
+    const auto& folder = eSettings::instance().fHddCacheFolder;
+    const QString dir = folder.isEmpty() ? QDir::tempPath() : folder;
+    mFile.setFileTemplate(QDir(dir).filePath("friction_cache_XXXXXX"));
+    if(mFile.open()) return true;
+    qWarning() << "Could not open disk cache file in" << dir;
+    return false;
+}
+
+uchar *HddSlabStore::takeSpace(const qint64 size,
+                               int &chunkId, qint64 &offset) {
+    for(int i = 0; i < static_cast<int>(mChunks.size()); i++) {
+        auto& chunk = mChunks[static_cast<size_t>(i)];
+        for(auto it = chunk.fFree.begin(); it != chunk.fFree.end(); it++) {
+            if(it->second < size) continue;
+            const qint64 freeOffset = it->first;
+            const qint64 remaining = it->second - size;
+            chunk.fFree.erase(it);
+            if(remaining > 0) chunk.fFree[freeOffset + size] = remaining;
+            chunkId = i;
+            offset = freeOffset;
+            return chunk.fData + freeOffset;
+        }
+    }
+    if(!addChunk(size)) return nullptr;
+    return takeSpace(size, chunkId, offset);
+}
+
+bool HddSlabStore::addChunk(const qint64 minSize) {
+    const qint64 size = qMax(sChunkSize, minSize);
+    const qint64 newFileSize = mFileSize + size;
+#if defined(Q_OS_LINUX)
+    // reserve the blocks now, a full disk would otherwise
+    // only show up as SIGBUS when writing to the mapping
+    if(posix_fallocate(mFile.handle(), mFileSize, size) != 0) return false;
+#endif
+    if(!mFile.resize(newFileSize)) return false;
+    uchar* const data = mFile.map(mFileSize, size);
+    if(!data) {
+        mFile.resize(mFileSize);
+        return false;
+    }
+    Chunk chunk;
+    chunk.fOffset = mFileSize;
+    chunk.fSize = size;
+    chunk.fData = data;
+    chunk.fFree[0] = size;
+    mChunks.push_back(chunk);
+    mFileSize = newFileSize;
+    return true;
+}
+
+void HddSlabStore::freeSpace(const int chunkId, const qint64 offset,
+                             const qint64 size) {
+    auto& freeList = mChunks[static_cast<size_t>(chunkId)].fFree;
+    qint64 newOffset = offset;
+    qint64 newSize = size;
+    const auto next = freeList.lower_bound(offset);
+    if(next != freeList.end() && next->first == offset + size) {
+        newSize += next->second;
+        freeList.erase(next);
+    }
+    const auto prevNext = freeList.lower_bound(offset);
+    if(prevNext != freeList.begin()) {
+        const auto prev = std::prev(prevNext);
+        if(prev->first + prev->second == offset) {
+            newOffset = prev->first;
+            newSize += prev->second;
+            freeList.erase(prev);
+        }
+    }
+    freeList[newOffset] = newSize;
+    mUsed -= size;
+}
+
+void HddSlabStore::trimChunks() {
+    const qint64 oldFileSize = mFileSize;
+    while(!mChunks.empty()) {
+        const auto& last = mChunks.back();
+        if(last.fFree.size() != 1) break;
+        const auto& free = *last.fFree.begin();
+        if(free.first != 0 || free.second != last.fSize) break;
+        mFile.unmap(last.fData);
+        mFileSize = last.fOffset;
+        mChunks.pop_back();
+    }
+    if(mFileSize != oldFileSize) mFile.resize(mFileSize);
+}
+
+void HddSlabStore::evictLru(const qint64 required, const qint64 cap,
+                            std::vector<stdsptr<HddSlab>>& evicted) {
+    auto it = mLru.begin();
+    while(mUsed + required > cap && it != mLru.end()) {
+        HddSlab* const slab = *it;
+        if(slab->mPins > 0) {
+            it++;
+            continue;
+        }
+        // a slab that can not be locked is already being destroyed
+        const auto sp = slab->mSelf.lock();
+        if(!sp) {
+            it++;
+            continue;
+        }
+        it = mLru.erase(it);
+        slab->mEvicted = true;
+        freeSpace(slab->mChunk, slab->mOffset, slab->mSize);
+        evicted.push_back(sp);
+    }
+}
+
+bool HddSlabStore::pin(HddSlab * const slab) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(slab->mEvicted) return false;
+    slab->mPins++;
+    mLru.splice(mLru.end(), mLru, slab->mLruIt);
+    return true;
+}
+
+void HddSlabStore::unpin(HddSlab * const slab) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    slab->mPins--;
+}
+
+void HddSlabStore::shrink(HddSlab * const slab, const qint64 size) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Q_ASSERT(slab->mPins > 0);
+    const qint64 alignedSize = sAligned(qMax(size, qint64(1)));
+    if(slab->mEvicted || alignedSize >= slab->mSize) return;
+    freeSpace(slab->mChunk, slab->mOffset + alignedSize,
+              slab->mSize - alignedSize);
+    slab->mSize = alignedSize;
+}
+
+void HddSlabStore::release(HddSlab * const slab) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(slab->mEvicted) return;
+    mLru.erase(slab->mLruIt);
+    freeSpace(slab->mChunk, slab->mOffset, slab->mSize);
+    trimChunks();
+}
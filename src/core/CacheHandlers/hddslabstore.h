@@ -0,0 +1,158 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef HDDSLABSTORE_H
+#define HDDSLABSTORE_H
+
+#include <QIODevice>
+#include <QTemporaryFile>
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "core_global.h"
+#include "smartPointers/stdselfref.h"
+
+class HddSlabStore;
+
+// Region of the session cache file holding one saved container.
+// The region is released when the last reference goes away, or earlier
+// when the store evicts it to stay under the disk cache cap.
+class CORE_EXPORT HddSlab {
+    friend class HddSlabStore;
+public:
+    using EvictedFunc = std::function<void()>;
+
+    HddSlab(const std::shared_ptr<HddSlabStore>& store,
+            const int chunk, const qint64 offset,
+            const qint64 size, uchar* const data);
+    ~HddSlab();
+
+    qint64 size() const { return mSize; }
+    bool evicted() const;
+
+    // Returns the space past size to the store, only while pinned
+    // for writing, before the slab is handed to anyone else.
+    void shrink(const qint64 size);
+
+    // Has to be called before data() is accessed from a worker thread,
+    // fails if the slab was evicted in the meantime.
+    bool pin();
+    void unpin();
+
+    uchar* data() const { return mData; }
+
+    // main thread only, called (queued to the main thread) on eviction,
+    // check evicted() after setting it as the call might have been missed
+    void setEvictedFunc(const EvictedFunc& func) { mEvictedFunc = func; }
+private:
+    const std::shared_ptr<HddSlabStore> mStore;
+    const int mChunk;
+    const qint64 mOffset;
+    qint64 mSize;
+    uchar* const mData;
+
+    std::weak_ptr<HddSlab> mSelf;
+
+    // guarded by the store mutex
+    bool mEvicted = false;
+    int mPins = 0;
+    std::list<HddSlab*>::iterator mLruIt;
+
+    EvictedFunc mEvictedFunc;
+};
+
+// QIODevice over a slab, so eWriteStream/eReadStream can work directly
+// on the mapped file.
+class CORE_EXPORT HddSlabDevice : public QIODevice {
+public:
+    HddSlabDevice(uchar* const data, const qint64 size);
+
+    bool isSequential() const { return false; }
+    qint64 size() const { return mSize; }
+    bool seek(const qint64 pos);
+    // set if a write did not fit
+    bool overflowed() const { return mOverflowed; }
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+private:
+    uchar* const mData;
+    const qint64 mSize;
+    qint64 mPos = 0;
+    bool mOverflowed = false;
+};
+
+// One memory-mapped cache file per session, growing in chunks.
+// Each chunk keeps a first-fit free list, regions are handed out as
+// HddSlab. Least recently used unpinned slabs are evicted
+// when fHddCacheMBCap would be exceeded.
+class CORE_EXPORT HddSlabStore :
+        public std::enable_shared_from_this<HddSlabStore> {
+    friend class HddSlab;
+    HddSlabStore() {}
+public:
+    ~HddSlabStore();
+
+    static HddSlabStore* sInstance();
+
+    // Thread safe, returns nullptr if the space could not be reserved.
+    // The returned slab is pinned, unpin it once it has been written.
+    stdsptr<HddSlab> allocate(const qint64 size);
+
+    qint64 usedBytes() const;
+    qint64 fileBytes() const;
+private:
+    struct Chunk {
+        qint64 fOffset;
+        qint64 fSize;
+        uchar* fData;
+        std::map<qint64, qint64> fFree; // offset in chunk -> size
+    };
+
+    bool openFile();
+    uchar* takeSpace(const qint64 size, int& chunkId, qint64& offset);
+    bool addChunk(const qint64 minSize);
+    void freeSpace(const int chunkId, const qint64 offset, const qint64 size);
+    void trimChunks();
+    void evictLru(const qint64 required, const qint64 cap,
+                  std::vector<stdsptr<HddSlab>>& evicted);
+
+    bool pin(HddSlab* const slab);
+    void unpin(HddSlab* const slab);
+    void shrink(HddSlab* const slab, const qint64 size);
+    void release(HddSlab* const slab);
+
+    mutable std::mutex mMutex;
+    QTemporaryFile mFile;
+    std::vector<Chunk> mChunks;
+    qint64 mFileSize = 0;
+    qint64 mUsed = 0;
+    std::list<HddSlab*> mLru; // front is the least recently used
+};
+
+#endif // HDDSLABSTORE_H
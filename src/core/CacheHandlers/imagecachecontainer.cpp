@@ -24,13 +24,15 @@
 // Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
 
 #include "imagecachecontainer.h"
-#include "tmpdeleter.h"
 #include "canvas.h"
 #include "skia/skiahelpers.h"
+#include "Private/esettings.h"
 
 ImageCacheContainer::ImageCacheContainer(const FrameRange &range,
                                          HddCachableCacheHandler * const parent) :
-    HddCachableRangeCont(range, parent) {}
+    HddCachableRangeCont(range, parent) {
+    setMemoryOwner(MemoryAccounting::Category::mediaFrames, QString());
+}
 
 ImageCacheContainer::ImageCacheContainer(const sk_sp<SkImage> &img,
                                          const FrameRange &range,
@@ -40,30 +42,137 @@ ImageCacheContainer::ImageCacheContainer(const sk_sp<SkImage> &img,
 }
 
 void ImageCacheContainer::replaceImage(const sk_sp<SkImage> &img) {
+    mFormat = CompactFrame::Format::rgba;
+    mFrameWidth = img ? img->width() : 0;
+    mFrameHeight = img ? img->height() : 0;
     ImageDataHandler::replaceImage(img);
     afterDataReplaced();
 }
 
+void ImageCacheContainer::replaceImage(const sk_sp<SkImage> &packed,
+                                       const CompactFrame::Format format,
+                                       const int width, const int height) {
+    mFormat = format;
+    mFrameWidth = width;
+    mFrameHeight = height;
+    ImageDataHandler::replaceImage(packed);
+    afterDataReplaced();
+}
+
+sk_sp<SkImage> ImageCacheContainer::rgbaImage() const {
+    return CompactFrame::sUnpack(getImage(), mFormat,
+                                 mFrameWidth, mFrameHeight);
+}
+
 int ImageCacheContainer::getByteCount() {
-    return getImageByteCount();
+    return getImageByteCount() + mCompressed.size();
 }
 
 void ImageCacheContainer::setDataLoadedFromTmpFile(const sk_sp<SkImage> &img) {
-    replaceImage(img);
+    // keeps the compressed and disk copies for the next time it is freed
+    ImageDataHandler::replaceImage(img);
     afterDataLoadedFromTmpFile();
 }
 
+void ImageCacheContainer::setDataCompressed(const eTask * const compressor,
+                                            const QByteArray &data,
+                                            const sk_sp<SkImage> &source) {
+    if(!isCurrentCompressor(compressor)) return;
+    mCompressed = data;
+    // a pending load takes the frame back instead of decompressing it
+    if(data.isEmpty() && (eSettings::instance().fHddCache || loadPending())) {
+        mSpillImage = source;
+    }
+    afterDataCompressed(!data.isEmpty());
+}
+
+sk_sp<SkImage> ImageCacheContainer::takeSpillImage() {
+    sk_sp<SkImage> result;
+    std::swap(result, mSpillImage);
+    return result;
+}
+
 int ImageCacheContainer::clearMemory() {
     return ImageDataHandler::clearImageMemory();
 }
 
+int ImageCacheContainer::clearCompressedMemory() {
+    const int bytes = mCompressed.size();
+    mCompressed.clear();
+    return bytes;
+}
+
 stdsptr<eHddTask> ImageCacheContainer::createTmpFileDataSaver() {
-    return enve::make_shared<ImgSaver>(this, getImage());
+    if(hasImage()) {
+        return enve::make_shared<ImgSaver>(this, getImage(), mFormat);
+    }
+    if(mSpillImage) {
+        const auto saver = enve::make_shared<ImgSaver>(this, mSpillImage);
+        // still needed by a pending load
+        if(!loadPending()) mSpillImage.reset();
+        return saver;
+    }
+    if(storesCompressedData()) {
+        return enve::make_shared<ImgSaver>(this, mCompressed);
+    }
+    return nullptr;
 }
 
-stdsptr<eHddTask> ImageCacheContainer::createTmpFileDataLoader() {
-    const ImgLoader::Func func = [this](sk_sp<SkImage> img) {
+stdsptr<eTask> ImageCacheContainer::createTmpFileDataLoader() {
+    return createImageLoader([this](sk_sp<SkImage> img) {
         setDataLoadedFromTmpFile(img);
-    };
-    return enve::make_shared<ImgLoader>(mTmpFile, this, func);
+    });
+}
+
+stdsptr<eTask> ImageCacheContainer::createRamCompressor() {
+    if(!hasImage()) return nullptr;
+    // already compact, the run length coder only takes RGBA
+    if(mFormat != CompactFrame::Format::rgba) return nullptr;
+    return enve::make_shared<ImgCompressor>(this, getImage());
+}
+
+stdsptr<eTask> ImageCacheContainer::createImageLoader(const LoadedFunc &func) {
+    if(storesCompressedData() || compressionPending()) {
+        return enve::make_shared<ImgDecompressor>(this, func);
+    }
+    return enve::make_shared<ImgLoader>(mHddSlab, this, mFormat, func);
+}
+
+void ImgCompressor::process() {
+    SkPixmap pix;
+    if(!mImage->peekPixels(&pix)) return;
+    mCompressed = FrameCompressor::sCompress(pix);
+}
+
+void ImgCompressor::afterProcessing() {
+    if(mTarget) mTarget->setDataCompressed(this, mCompressed, mImage);
+}
+
+void ImgCompressor::afterCanceled() {
+    if(mTarget) mTarget->setDataCompressed(this, QByteArray(), mImage);
+}
+
+void ImgDecompressor::beforeProcessing(const Hardware) {
+    if(!mTarget) return;
+    mCompressed = mTarget->compressedData();
+    // the frame did not compress, the compressor handed it back
+    if(mCompressed.isEmpty()) mImage = mTarget->takeSpillImage();
+}
+
+void ImgDecompressor::process() {
+    if(mCompressed.isEmpty()) return;
+    mImage = FrameCompressor::sDecompress(mCompressed);
+}
+
+void ImgDecompressor::afterProcessing() {
+    // nothing to load from, cancels so the frame gets rendered again
+    if(!mImage) return cancel();
+    if(mFinishedFunc) mFinishedFunc(mImage);
+}
+
+void ImgDecompressor::afterCanceled() {
+    if(!mTarget) return;
+    // only kept for this load, the disk saver has its own reference
+    mTarget->takeSpillImage();
+    mTarget->afterDataLoadFailed();
 }
@@ -25,10 +25,13 @@
 
 #ifndef IMAGECACHECONTAINER_H
 #define IMAGECACHECONTAINER_H
+#include <QSize>
 #include "skia/skiaincludes.h"
 #include "skia/skiahelpers.h"
 #include "hddcachablerangecont.h"
 #include "imagedatahandler.h"
+#include "framecompressor.h"
+#include "compactframe.h"
 class Canvas;
 
 class CORE_EXPORT ImageCacheContainer : public HddCachableRangeCont,
@@ -41,13 +44,43 @@ protected:
                         const FrameRange &range,
                         HddCachableCacheHandler * const parent);
     stdsptr<eHddTask> createTmpFileDataSaver();
-    stdsptr<eHddTask> createTmpFileDataLoader();
+    stdsptr<eTask> createTmpFileDataLoader();
+    stdsptr<eTask> createRamCompressor();
     int clearMemory();
+    int clearCompressedMemory();
+
+    using LoadedFunc = std::function<void(sk_sp<SkImage> img)>;
+    stdsptr<eTask> createImageLoader(const LoadedFunc& func);
 public:
     int getByteCount();
 
+    bool storesCompressedData() const { return !mCompressed.isEmpty(); }
+    const QByteArray& compressedData() const { return mCompressed; }
+    //! @brief Frame the compressor could not shrink, if it is still kept
+    sk_sp<SkImage> takeSpillImage();
+
     void setDataLoadedFromTmpFile(const sk_sp<SkImage> &img);
+    void setDataCompressed(const eTask* const compressor,
+                           const QByteArray& data,
+                           const sk_sp<SkImage>& source);
     void replaceImage(const sk_sp<SkImage> &img);
+    //! @brief Replaces the frame with one packed in a compact layout.
+    void replaceImage(const sk_sp<SkImage> &packed,
+                      const CompactFrame::Format format,
+                      const int width, const int height);
+
+    CompactFrame::Format format() const { return mFormat; }
+    //! @brief The frame as premultiplied RGBA, unpacked if it is compact.
+    sk_sp<SkImage> rgbaImage() const;
+    //! @brief Size of the frame, also when it is compact.
+    QSize frameSize() const { return QSize(mFrameWidth, mFrameHeight); }
+private:
+    CompactFrame::Format mFormat = CompactFrame::Format::rgba;
+    int mFrameWidth = 0;
+    int mFrameHeight = 0;
+    QByteArray mCompressed;
+    // frame that did not compress, kept until the disk saver takes it
+    sk_sp<SkImage> mSpillImage;
 };
 
 
@@ -56,18 +89,34 @@ public:
 
 class CORE_EXPORT ImgSaver : public TmpSaver {
     e_OBJECT
-public:
-    typedef std::function<void(const qsptr<QTemporaryFile>&)> Func;
 protected:
     ImgSaver(ImageCacheContainer* const target,
-             const sk_sp<SkImage> &image) :
-        TmpSaver(target), mImage(image) {}
+             const sk_sp<SkImage> &image,
+             const CompactFrame::Format format = CompactFrame::Format::rgba) :
+        TmpSaver(target), mImage(image), mFormat(format) {}
+    ImgSaver(ImageCacheContainer* const target,
+             const QByteArray &compressed) :
+        TmpSaver(target), mCompressed(compressed),
+        mFormat(CompactFrame::Format::rgba) {}
 
     void write(eWriteStream& dst) {
-        SkiaHelpers::writeImg(mImage, dst);
+        const bool compressed = !mImage;
+        dst << compressed;
+        if(compressed) dst << mCompressed;
+        else if(mFormat != CompactFrame::Format::rgba) {
+            CompactFrame::sWrite(mImage, dst);
+        } else SkiaHelpers::writeImg(mImage, dst);
+    }
+
+    qint64 dataByteCount() const {
+        if(!mImage) return mCompressed.size();
+        return qint64(mImage->width())*mImage->height()*
+               mImage->imageInfo().bytesPerPixel();
     }
 private:
     const sk_sp<SkImage> mImage;
+    const QByteArray mCompressed;
+    const CompactFrame::Format mFormat;
 };
 
 class CORE_EXPORT ImgLoader : public TmpLoader {
@@ -77,20 +126,69 @@ public:
 
     const sk_sp<SkImage>& image() const { return mImage; }
 protected:
-    ImgLoader(const qsptr<QTemporaryFile> &file,
+    ImgLoader(const stdsptr<HddSlab> &slab,
               ImageCacheContainer* const target,
+              const CompactFrame::Format format,
               const Func& finishedFunc) :
-        TmpLoader(file, target), mFinishedFunc(finishedFunc) {}
+        TmpLoader(slab, target), mFormat(format),
+        mFinishedFunc(finishedFunc) {}
 
     void read(eReadStream& src) {
-        mImage = SkiaHelpers::readImg(src);
+        bool compressed;
+        src >> compressed;
+        if(compressed) {
+            QByteArray data;
+            src >> data;
+            mImage = FrameCompressor::sDecompress(data);
+        } else if(mFormat != CompactFrame::Format::rgba) {
+            mImage = CompactFrame::sRead(src, mFormat);
+        } else {
+            mImage = SkiaHelpers::readImg(src);
+        }
     }
-    void afterProcessing() {
+    void afterRead() {
         if(mFinishedFunc) mFinishedFunc(mImage);
     }
 private:
     sk_sp<SkImage> mImage;
+    const CompactFrame::Format mFormat;
     const Func mFinishedFunc;
 };
 
+class CORE_EXPORT ImgCompressor : public eCpuTask {
+    e_OBJECT
+protected:
+    ImgCompressor(ImageCacheContainer* const target,
+                  const sk_sp<SkImage> &image) :
+        mTarget(target), mImage(image) {
+        setPriority(eTaskPriority::cacheMaintenance);
+    }
+
+    void process();
+    void afterProcessing();
+    void afterCanceled();
+private:
+    const stdptr<ImageCacheContainer> mTarget;
+    const sk_sp<SkImage> mImage;
+    QByteArray mCompressed;
+};
+
+class CORE_EXPORT ImgDecompressor : public eCpuTask {
+    e_OBJECT
+protected:
+    ImgDecompressor(ImageCacheContainer* const target,
+                    const ImgLoader::Func& finishedFunc) :
+        mTarget(target), mFinishedFunc(finishedFunc) {}
+
+    void beforeProcessing(const Hardware);
+    void process();
+    void afterProcessing();
+    void afterCanceled();
+private:
+    const stdptr<ImageCacheContainer> mTarget;
+    const ImgLoader::Func mFinishedFunc;
+    QByteArray mCompressed;
+    sk_sp<SkImage> mImage;
+};
+
 #endif // IMAGECACHECONTAINER_H
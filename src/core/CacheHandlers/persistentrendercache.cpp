@@ -0,0 +1,146 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "persistentrendercache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDateTime>
+
+#include <mutex>
+
+#include "framecompressor.h"
+#include "skia/skiahelpers.h"
+#include "Private/esettings.h"
+#include "appsupport.h"
+
+static const char* const sMagic = "FRC1";
+
+bool PersistentRenderCache::sEnabled() {
+    return eSettings::instance().fPersistentRenderCache;
+}
+
+QString PersistentRenderCache::sFolder() {
+    const auto& folder = eSettings::instance().fPersistentRenderCacheFolder;
+    if(folder.isEmpty()) return AppSupport::getAppRenderCachePath();
+    return folder;
+}
+
+QString PersistentRenderCache::sEntryPath(const QByteArray &key) {
+    return QDir(sFolder()).filePath(QString::fromLatin1(key.toHex()) + ".frc");
+}
+
+bool PersistentRenderCache::sContains(const QByteArray &key) {
+    return QFile::exists(sEntryPath(key));
+}
+
+void PersistentRenderCache::sStore(const QByteArray &key,
+                                   const sk_sp<SkImage> &image) {
+    if(!image || sContains(key)) return;
+    enve::make_shared<PersistentFrameSaver>(key, image)->queTask();
+}
+
+// video proxies share the folder and the cap with the frames
+static const QStringList sEntryFilters{"*.frc", "*.proxy.mov"};
+
+void PersistentRenderCache::sEntryAdded(const qint64 bytes) {
+    static std::mutex sMutex;
+    static qint64 sTotalBytes = -1;
+    std::lock_guard<std::mutex> lock(sMutex);
+    const QDir dir(sFolder());
+    if(sTotalBytes < 0) {
+        sTotalBytes = 0;
+        const auto entries = dir.entryInfoList(sEntryFilters, QDir::Files);
+        for(const auto& entry : entries) sTotalBytes += entry.size();
+    } else {
+        sTotalBytes += bytes;
+    }
+    const qint64 cap = eSettings::instance().fPersistentRenderCacheMBCap.fValue*
+            static_cast<qint64>(1024*1024);
+    if(cap <= 0 || sTotalBytes <= cap) return;
+    // remove the least recently used entries down to 90% of the cap
+    const auto entries = dir.entryInfoList(sEntryFilters, QDir::Files,
+                                           QDir::Time | QDir::Reversed);
+    for(const auto& entry : entries) {
+        if(sTotalBytes <= cap*9/10) break;
+        if(QFile::remove(entry.absoluteFilePath())) {
+            sTotalBytes -= entry.size();
+        }
+    }
+}
+
+void PersistentFrameSaver::process() {
+    SkPixmap pix;
+    if(!mImage->peekPixels(&pix)) return;
+    const QString path = PersistentRenderCache::sEntryPath(mKey);
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) return;
+    const QByteArray compressed = FrameCompressor::sCompress(pix);
+    {
+        eWriteStream dst(&file);
+        dst.write(sMagic, 4);
+        dst << !compressed.isEmpty();
+        if(compressed.isEmpty()) SkiaHelpers::writePixmap(pix, dst);
+        else dst << compressed;
+    }
+    const qint64 bytes = file.size();
+    if(file.commit()) PersistentRenderCache::sEntryAdded(bytes);
+}
+
+// A missing or broken entry is a cache miss, entries can be removed
+// by sEntryAdded at any time. Without an image the frame gets rendered.
+void PersistentFrameLoader::process() {
+    const QString path = PersistentRenderCache::sEntryPath(mKey);
+    QFile file(path);
+    if(!file.open(QIODevice::ReadWrite)) return;
+    // keeps recently used entries from being removed
+    file.setFileTime(QDateTime::currentDateTime(),
+                     QFileDevice::FileModificationTime);
+    try {
+        char magic[4];
+        eReadStream src(&file);
+        src.read(magic, 4);
+        if(memcmp(magic, sMagic, 4) != 0) return;
+        bool compressed;
+        src >> compressed;
+        if(compressed) {
+            QByteArray data;
+            src >> data;
+            mImage = FrameCompressor::sDecompress(data);
+        } else {
+            mImage = SkiaHelpers::readImg(src);
+        }
+    } catch(...) {
+        mImage.reset();
+    }
+}
+
+void PersistentFrameLoader::afterProcessing() {
+    if(mImage && mLoaded) mLoaded(mImage);
+    else if(mFailed) mFailed();
+}
+
+void PersistentFrameLoader::afterCanceled() {
+    if(mFailed) mFailed();
+}
@@ -0,0 +1,86 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef PERSISTENTRENDERCACHE_H
+#define PERSISTENTRENDERCACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "Tasks/updatable.h"
+#include "skia/skiaincludes.h"
+
+// Rendered scene frames stored on disk between sessions.
+// Entries are keyed by a hash of everything the frame depends on,
+// see Canvas::persistentCacheKey, so they never have to be invalidated.
+// The oldest entries are removed once fPersistentRenderCacheMBCap is hit,
+// video proxies in the same folder count against it as well.
+class CORE_EXPORT PersistentRenderCache {
+public:
+    static bool sEnabled();
+    static QString sFolder();
+    static QString sEntryPath(const QByteArray& key);
+    static bool sContains(const QByteArray& key);
+
+    static void sStore(const QByteArray& key, const sk_sp<SkImage>& image);
+    //! @brief Counts a new file in sFolder() against the cap, thread safe
+    static void sEntryAdded(const qint64 bytes);
+};
+
+class CORE_EXPORT PersistentFrameSaver : public eHddTask {
+    e_OBJECT
+protected:
+    PersistentFrameSaver(const QByteArray& key,
+                         const sk_sp<SkImage>& image) :
+        mKey(key), mImage(image) {
+        setPriority(eTaskPriority::cacheMaintenance);
+    }
+
+    void process();
+private:
+    const QByteArray mKey;
+    const sk_sp<SkImage> mImage;
+};
+
+class CORE_EXPORT PersistentFrameLoader : public eCpuTask {
+    e_OBJECT
+public:
+    using LoadedFunc = std::function<void(const sk_sp<SkImage>&)>;
+    using FailedFunc = std::function<void()>;
+protected:
+    PersistentFrameLoader(const QByteArray& key,
+                          const LoadedFunc& loaded,
+                          const FailedFunc& failed) :
+        mKey(key), mLoaded(loaded), mFailed(failed) {}
+
+    void process();
+    void afterProcessing();
+    void afterCanceled();
+private:
+    const QByteArray mKey;
+    const LoadedFunc mLoaded;
+    const FailedFunc mFailed;
+    sk_sp<SkImage> mImage;
+};
+
+#endif // PERSISTENTRENDERCACHE_H
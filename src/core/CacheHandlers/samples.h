@@ -29,6 +29,7 @@
 #include "smartPointers/stdselfref.h"
 #include "smartPointers/ememory.h"
 #include "framerange.h"
+#include "memoryaccounting.h"
 
 #include "ReadWrite/ereadstream.h"
 #include "ReadWrite/ewritestream.h"
@@ -53,6 +54,7 @@ protected:
         fChannelLayout(channelLayout),
         fNChannels(av_get_channel_layout_nb_channels(channelLayout)),
         fSampleRange(range), fData(data) {
+        fMemoryTag.setBytes(byteCount());
     }
 
     Samples(const SampleRange& range,
@@ -77,6 +79,7 @@ protected:
             const auto totBytes = bytes * fNChannels;
             fData[0] = new uchar[totBytes];
         }
+        fMemoryTag.setBytes(byteCount());
     }
 
     Samples(const Samples * const src) :
@@ -143,6 +146,11 @@ public:
     const uint fNChannels;
     const SampleRange fSampleRange;
     uchar ** fData;
+    MemoryAccounting::Tag fMemoryTag{MemoryAccounting::Category::sound};
+
+    qint64 byteCount() const {
+        return qint64(fSampleRange.span())*fSampleSize*fNChannels;
+    }
 
     stdsptr<Samples> mid(const SampleRange& range) const {
         if(!range.isValid()) RuntimeThrow("Invalid range");
@@ -35,12 +35,61 @@ SceneFrameContainer::SceneFrameContainer(
     ImageCacheContainer(data->fRenderedImage, range, parent),
     fBoxState(data->fBoxStateId),
     fResolution(data->fResolution),
-    mScene(scene) {}
+    mScene(scene) {
+    setMemoryOwner(MemoryAccounting::Category::sceneFrames,
+                   scene ? scene->prp_getName() : QString());
+}
 
-stdsptr<eHddTask> SceneFrameContainer::createTmpFileDataLoader() {
-    const ImgLoader::Func func = [this](sk_sp<SkImage> img) {
+SceneFrameContainer::SceneFrameContainer(
+        Canvas * const scene,
+        const sk_sp<SkImage> &image,
+        const uint boxState,
+        const qreal resolution,
+        const FrameRange &range,
+        HddCachableCacheHandler * const parent) :
+    ImageCacheContainer(image, range, parent),
+    fBoxState(boxState),
+    fResolution(resolution),
+    mScene(scene) {
+    setMemoryOwner(MemoryAccounting::Category::sceneFrames,
+                   scene ? scene->prp_getName() : QString());
+}
+
+stdsptr<eTask> SceneFrameContainer::createTmpFileDataLoader() {
+    return createImageLoader([this](sk_sp<SkImage> img) {
         setDataLoadedFromTmpFile(img);
         if(mScene) mScene->setSceneFrame(ref<SceneFrameContainer>());
-    };
-    return enve::make_shared<ImgLoader>(mTmpFile, this, func);
+    });
+}
+
+void SceneFrameContainer::scheduleCompaction(const CompactFrame::Format format) {
+    if(format == CompactFrame::Format::rgba) return;
+    if(format() != CompactFrame::Format::rgba || !hasImage()) return;
+    mCompactor = enve::make_shared<FrameCompactor>(this, getImage(), format);
+    mCompactor->queTask();
+}
+
+void SceneFrameContainer::setDataCompacted(const eTask * const compactor,
+                                           const sk_sp<SkImage> &source,
+                                           const sk_sp<SkImage> &packed,
+                                           const CompactFrame::Format format) {
+    if(mCompactor.get() != compactor) return;
+    mCompactor.reset();
+    // the frame was freed or replaced in the meantime
+    if(!packed || getImage() != source) return;
+    replaceImage(packed, format, source->width(), source->height());
+}
+
+void FrameCompactor::process() {
+    SkPixmap pix;
+    if(!mImage->peekPixels(&pix)) return;
+    mPacked = CompactFrame::sPack(pix, mFormat);
+}
+
+void FrameCompactor::afterProcessing() {
+    if(mTarget) mTarget->setDataCompacted(this, mImage, mPacked, mFormat);
+}
+
+void FrameCompactor::afterCanceled() {
+    if(mTarget) mTarget->setDataCompacted(this, mImage, nullptr, mFormat);
 }
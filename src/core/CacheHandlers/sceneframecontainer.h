@@ -34,13 +34,45 @@ public:
                         const BoxRenderData* const data,
                         const FrameRange &range,
                         HddCachableCacheHandler * const parent);
+    SceneFrameContainer(Canvas * const scene,
+                        const sk_sp<SkImage>& image,
+                        const uint boxState,
+                        const qreal resolution,
+                        const FrameRange &range,
+                        HddCachableCacheHandler * const parent);
 
     uint fBoxState;
     const qreal fResolution;
+
+    //! @brief Packs the frame into a smaller layout on a worker thread.
+    void scheduleCompaction(const CompactFrame::Format format);
+    void setDataCompacted(const eTask* const compactor,
+                          const sk_sp<SkImage>& source,
+                          const sk_sp<SkImage>& packed,
+                          const CompactFrame::Format format);
 protected:
-    stdsptr<eHddTask> createTmpFileDataLoader();
+    stdsptr<eTask> createTmpFileDataLoader();
 private:
     const qptr<Canvas> mScene;
+    stdsptr<eTask> mCompactor;
+};
+
+class CORE_EXPORT FrameCompactor : public eCpuTask {
+    e_OBJECT
+protected:
+    FrameCompactor(SceneFrameContainer* const target,
+                   const sk_sp<SkImage> &image,
+                   const CompactFrame::Format format) :
+        mTarget(target), mImage(image), mFormat(format) {}
+
+    void process();
+    void afterProcessing();
+    void afterCanceled();
+private:
+    const stdptr<SceneFrameContainer> mTarget;
+    const sk_sp<SkImage> mImage;
+    const CompactFrame::Format mFormat;
+    sk_sp<SkImage> mPacked;
 };
 
 #endif // SCENEFRAMECONTAINER_H
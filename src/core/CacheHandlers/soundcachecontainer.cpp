@@ -38,11 +38,12 @@ SoundCacheContainer::SoundCacheContainer(const stdsptr<Samples>& samples,
 }
 
 stdsptr<eHddTask> SoundCacheContainer::createTmpFileDataSaver() {
+    if(!mSamples) return nullptr;
     return enve::make_shared<SoundContainerTmpFileDataSaver>(mSamples, this);
 }
 
-stdsptr<eHddTask> SoundCacheContainer::createTmpFileDataLoader() {
-    return enve::make_shared<SoundContainerTmpFileDataLoader>(mTmpFile, this);
+stdsptr<eTask> SoundCacheContainer::createTmpFileDataLoader() {
+    return enve::make_shared<SoundContainerTmpFileDataLoader>(mHddSlab, this);
 }
 
 int SoundCacheContainer::clearMemory() {
@@ -56,8 +56,10 @@ public:
     }
 protected:
     stdsptr<eHddTask> createTmpFileDataSaver();
-    stdsptr<eHddTask> createTmpFileDataLoader();
+    stdsptr<eTask> createTmpFileDataLoader();
     int clearMemory();
+    // the samples carry their own memory tag
+    qint64 accountedBytes() { return 0; }
 
     stdsptr<Samples> mSamples;
 };
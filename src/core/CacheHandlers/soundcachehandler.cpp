@@ -39,8 +39,9 @@ stdsptr<Samples> SoundHandler::getSamplesForSecond(const int secondId) {
 
 void SoundHandler::secondReaderFinished(
         const int secondId,
-        const stdsptr<Samples>& samples) {
-    if(samples) mDataHandler->secondReaderFinished(secondId, samples);
+        const stdsptr<Samples>& samples,
+        const qreal costMs) {
+    if(samples) mDataHandler->secondReaderFinished(secondId, samples, costMs);
     removeSecondReader(secondId);
 }
 
@@ -72,10 +72,12 @@ public:
     }
 
     void secondReaderFinished(const int secondId,
-                             const stdsptr<Samples>& samples) {
-        mSecondsCache.add(enve::make_shared<SoundCacheContainer>(
-                              samples, iValueRange{secondId, secondId},
-                              &mSecondsCache));
+                             const stdsptr<Samples>& samples,
+                             const qreal costMs) {
+        const auto cont = enve::make_shared<SoundCacheContainer>(
+                    samples, iValueRange{secondId, secondId}, &mSecondsCache);
+        cont->setRecomputeCost(costMs);
+        mSecondsCache.add(cont);
     }
 private:
     QList<int> mSecondsBeingRead;
@@ -99,7 +101,8 @@ public:
     stdsptr<Samples> getSamplesForSecond(const int secondId);
 
     void secondReaderFinished(const int secondId,
-                              const stdsptr<Samples>& samples);
+                              const stdsptr<Samples>& samples,
+                              const qreal costMs);
     void secondReaderCanceled(const int secondId) {
         removeSecondReader(secondId);
     }
@@ -27,15 +27,15 @@
 #include "soundcachecontainer.h"
 
 SoundContainerTmpFileDataLoader::SoundContainerTmpFileDataLoader(
-        const qsptr<QTemporaryFile> &file,
+        const stdsptr<HddSlab> &slab,
         SoundCacheContainer *target) :
-    TmpLoader(file, target), mTarget(target) {}
+    TmpLoader(slab, target), mTarget(target) {}
 
 void SoundContainerTmpFileDataLoader::read(eReadStream& src) {
     mSamples = Samples::sRead(src);
 }
 
-void SoundContainerTmpFileDataLoader::afterProcessing() {
+void SoundContainerTmpFileDataLoader::afterRead() {
     mTarget->setDataLoadedFromTmpFile(mSamples);
 }
 
@@ -47,3 +47,8 @@ SoundContainerTmpFileDataSaver::SoundContainerTmpFileDataSaver(
 void SoundContainerTmpFileDataSaver::write(eWriteStream& dst) {
     mSamples->write(dst);
 }
+
+qint64 SoundContainerTmpFileDataSaver::dataByteCount() const {
+    return qint64(mSamples->fSampleRange.span())*mSamples->fSampleSize*
+           mSamples->fNChannels;
+}
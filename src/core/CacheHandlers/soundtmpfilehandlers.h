@@ -25,10 +25,8 @@
 
 #ifndef SOUNDTMPFILEHANDLERS_H
 #define SOUNDTMPFILEHANDLERS_H
-#include "tmpdeleter.h"
 #include "soundcachecontainer.h"
 #include "Tasks/updatable.h"
-#include <QTemporaryFile>
 #include "skia/skiaincludes.h"
 #include "tmpsaver.h"
 #include "tmploader.h"
@@ -37,10 +35,10 @@ class SoundCacheContainer;
 class CORE_EXPORT SoundContainerTmpFileDataLoader : public TmpLoader {
     e_OBJECT
 public:
-    SoundContainerTmpFileDataLoader(const qsptr<QTemporaryFile> &file,
+    SoundContainerTmpFileDataLoader(const stdsptr<HddSlab> &slab,
                                     SoundCacheContainer *target);
     void read(eReadStream& src);
-    void afterProcessing();
+    void afterRead();
 protected:
     const stdptr<SoundCacheContainer> mTarget;
     stdsptr<Samples> mSamples;
@@ -52,6 +50,7 @@ public:
     SoundContainerTmpFileDataSaver(const stdsptr<Samples> &samples,
                                    SoundCacheContainer * const target);
     void write(eWriteStream& dst);
+    qint64 dataByteCount() const;
 private:
     const stdsptr<Samples> mSamples;
 };
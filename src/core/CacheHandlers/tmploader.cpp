@@ -25,21 +25,36 @@
 
 #include "tmploader.h"
 
-TmpLoader::TmpLoader(const qsptr<QTemporaryFile> &file,
+TmpLoader::TmpLoader(const stdsptr<HddSlab> &slab,
                      HddCachableCont * const target) :
-    mTmpFile(file), mTarget(target) {}
+    mSlab(slab), mTarget(target) {}
 
 void TmpLoader::process() {
-    if(!mTmpFile) return;
-    if(mTmpFile->open()) {
-        eReadStream src(mTmpFile.get());
+    // evicted by the disk cache cap, a cache miss and not an error
+    mSlabLost = !mSlab || !mSlab->pin();
+    if(mSlabLost) return;
+    HddSlabDevice device(mSlab->data(), mSlab->size());
+    device.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    try {
+        eReadStream src(&device);
         read(src);
-        mTmpFile->close();
-    } else {
-        RuntimeThrow("Could not open temporary file for reading.");
+    } catch(...) {
+        mSlab->unpin();
+        throw;
     }
+    mSlab->unpin();
 }
 
 void TmpLoader::beforeProcessing(const Hardware) {
-    if(mTarget && !mTmpFile) mTmpFile = mTarget->getTmpFile();
+    if(mTarget && !mSlab) mSlab = mTarget->getHddSlab();
+}
+
+void TmpLoader::afterProcessing() {
+    // cancels the dependent tasks too, so the data gets rendered again
+    if(mSlabLost) return cancel();
+    afterRead();
+}
+
+void TmpLoader::afterCanceled() {
+    if(mTarget) mTarget->afterDataLoadFailed();
 }
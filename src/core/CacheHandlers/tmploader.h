@@ -27,21 +27,25 @@
 #define TMPLOADER_H
 
 #include "Tasks/updatable.h"
-#include <QTemporaryFile>
 #include "hddcachablecont.h"
 
 #include "ReadWrite/ereadstream.h"
 
 class CORE_EXPORT TmpLoader : public eHddTask {
 public:
-    TmpLoader(const qsptr<QTemporaryFile> &file,
+    TmpLoader(const stdsptr<HddSlab> &slab,
               HddCachableCont * const target);
 
     virtual void read(eReadStream& src) = 0;
+    //! @brief Called instead of afterProcessing once the data was read
+    virtual void afterRead() = 0;
     void process();
     void beforeProcessing(const Hardware);
+    void afterProcessing() final;
+    void afterCanceled();
 private:
-    qsptr<QTemporaryFile> mTmpFile;
+    bool mSlabLost = false;
+    stdsptr<HddSlab> mSlab;
     const stdptr<HddCachableCont> mTarget;
 };
 
@@ -26,22 +26,38 @@
 #include "tmpsaver.h"
 
 TmpSaver::TmpSaver(HddCachableCont* const target) :
-    mTarget(target) {}
+    mTarget(target) {
+    setPriority(eTaskPriority::cacheMaintenance);
+}
 
 void TmpSaver::process() {
-    mTmpFile = qsptr<QTemporaryFile>(new QTemporaryFile());
-    if(mTmpFile->open()) {
-        eWriteStream dst(mTmpFile.get());
+    mSavingSuccessful = false;
+    // room for the headers, the rest is returned once written
+    const qint64 headerBytes = 4096;
+    mSlab = HddSlabStore::sInstance()->allocate(dataByteCount() + headerBytes);
+    if(!mSlab) return;
+    HddSlabDevice device(mSlab->data(), mSlab->size());
+    device.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    {
+        eWriteStream dst(&device);
         write(dst);
-        mTmpFile->close();
-        mSavingSuccessful = true;
-    } else {
-        mSavingSuccessful = false;
     }
+    if(device.overflowed()) {
+        mSlab->unpin();
+        mSlab.reset();
+        return;
+    }
+    mSlab->shrink(device.pos());
+    mSlab->unpin();
+    mSavingSuccessful = true;
 }
 
 void TmpSaver::afterProcessing() {
     if(!mTarget) return;
-    if(!mSavingSuccessful) return;
-    mTarget->setDataSavedToTmpFile(mTmpFile);
+    mTarget->setDataSavedToTmpFile(mSavingSuccessful ? mSlab : nullptr);
+}
+
+void TmpSaver::afterCanceled() {
+    if(!mTarget) return;
+    mTarget->setDataSavedToTmpFile(nullptr);
 }
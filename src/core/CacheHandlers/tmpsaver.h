@@ -27,7 +27,6 @@
 #define TMPSAVER_H
 
 #include "Tasks/updatable.h"
-#include <QTemporaryFile>
 #include "hddcachablecont.h"
 
 #include "ReadWrite/ewritestream.h"
@@ -38,13 +37,16 @@ public:
     TmpSaver(HddCachableCont * const target);
 
     virtual void write(eWriteStream& dst) = 0;
+    //! @brief Bytes of bulk data written by write, small headers excluded.
+    virtual qint64 dataByteCount() const = 0;
 
     void process();
     void afterProcessing();
+    void afterCanceled();
 private:
     const stdptr<HddCachableCont> mTarget;
     bool mSavingSuccessful = false;
-    qsptr<QTemporaryFile> mTmpFile;
+    stdsptr<HddSlab> mSlab;
 };
 
 
@@ -93,13 +93,13 @@ private:
             task->addDependent({[ptr, relFrame, timeFrame, imageId]() {
                 if(!ptr) return;
                 const auto cont = ptr->mSrc->getFrameAtOrBeforeFrame(relFrame);
-                if(cont) ptr->saveSurfaceValues(timeFrame, cont->getImage(), imageId);
+                if(cont) ptr->saveSurfaceValues(timeFrame, cont->rgbaImage(), imageId);
             }, nullptr});
             addTask(task->ref<eTask>());
             return true;
         } else {
             const auto cont = mSrc->getFrameAtOrBeforeFrame(relFrame);
-            if(cont) saveSurfaceValues(timeFrame, cont->getImage(), imageId);
+            if(cont) saveSurfaceValues(timeFrame, cont->rgbaImage(), imageId);
             return false;
         }
     }
@@ -31,6 +31,8 @@
 #include "GUI/edialogs.h"
 #include "filesourcescache.h"
 
+#include "include/codec/SkAndroidCodec.h"
+
 ImageFileDataHandler::ImageFileDataHandler() {}
 
 void ImageFileDataHandler::afterSourceChanged()
@@ -45,70 +47,143 @@ void ImageFileDataHandler::afterSourceChanged()
 }
 
 void ImageFileDataHandler::clearCache() {
-    mImage.reset();
-    mImageLoader.reset();
+    for (int i = 0; i <= sMaxLevel; i++) {
+        mImages[i].reset();
+        mImageLoaders[i].reset();
+    }
+    mSourceSize = QSize();
 }
 
-eTask *ImageFileDataHandler::scheduleLoad()
+eTask *ImageFileDataHandler::scheduleLoad(const int level)
 {
-    if (mImage) {
-        const auto task = mImage->scheduleLoadFromTmpFile();
+    if (level < 0 || level > sMaxLevel) { return nullptr; }
+    const auto& image = mImages[level];
+    if (image) {
+        const auto task = image->scheduleLoadFromTmpFile();
         if (task) { return task; }
     }
-    if (mImageLoader) { return mImageLoader.get(); }
+    auto& loader = mImageLoaders[level];
+    if (loader) { return loader.get(); }
     switch (mType) {
     /*case Type::ora:
-        mImageLoader = enve::make_shared<OraLoader>(mFilePath, this);
+        loader = enve::make_shared<OraLoader>(mFilePath, this);
         break;*/
     case Type::image:
-        mImageLoader = enve::make_shared<ImageLoader>(mFilePath, this);
+        loader = enve::make_shared<ImageLoader>(mFilePath, this, level);
         break;
     default:
         return nullptr;
     }
-    if (mImageLoader) { mImageLoader->queTask(); }
-    return mImageLoader.get();
+    if (loader) { loader->queTask(); }
+    return loader.get();
+}
+
+ImageFileDataHandler::ImageCacheContainerX*
+    ImageFileDataHandler::imageInMemory(const int level) const
+{
+    if (level < 0 || level > sMaxLevel) { return nullptr; }
+    // a finer level is only better looking, never worse
+    for (int i = level; i >= 0; i--) {
+        const auto& image = mImages[i];
+        if (image && image->hasImage()) { return image.get(); }
+    }
+    return nullptr;
+}
+
+bool ImageFileDataHandler::hasImage(const int level) const
+{
+    return imageInMemory(level);
+}
+
+sk_sp<SkImage> ImageFileDataHandler::getImage(const int level) const
+{
+    const auto image = imageInMemory(level);
+    if (!image) { return nullptr; }
+    return image->getImage();
 }
 
-bool ImageFileDataHandler::hasImage() const
+ImageCacheContainer* ImageFileDataHandler::getImageContainer(const int level)
 {
-    if (!mImage) { return false; }
-    return mImage->hasImage();
+    const auto image = imageInMemory(level);
+    if (image) { return image; }
+    if (level < 0 || level > sMaxLevel) { return nullptr; }
+    return mImages[level].get();
 }
 
-sk_sp<SkImage> ImageFileDataHandler::getImage() const
+int ImageFileDataHandler::levelForScale(const qreal scale) const
 {
-    if (!mImage) { return nullptr; }
-    return mImage->getImage();
+    if (mType != Type::image) { return 0; }
+    int level = 0;
+    qreal levelScale = 1;
+    while (level < sMaxLevel && 0.5*levelScale >= scale) {
+        levelScale *= 0.5;
+        level++;
+    }
+    return level;
 }
 
-void ImageFileDataHandler::replaceImage(const sk_sp<SkImage> &img)
+void ImageFileDataHandler::replaceImage(const int level,
+                                        const sk_sp<SkImage> &img,
+                                        const QSize &sourceSize,
+                                        const qreal costMs)
 {
     if (img) {
-        mImage = enve::make_shared<ImageCacheContainerX>(img, this);
-    } else { mImage.reset(); }
-    mImageLoader.reset();
+        mImages[level] = enve::make_shared<ImageCacheContainerX>(img, this, level);
+        mImages[level]->setRecomputeCost(costMs);
+        if (sourceSize.isValid()) { mSourceSize = sourceSize; }
+    } else { mImages[level].reset(); }
+    mImageLoaders[level].reset();
 }
 
 ImageLoader::ImageLoader(const QString &filePath,
-                         ImageFileDataHandler * const handler)
+                         ImageFileDataHandler * const handler,
+                         const int level)
     : mTargetHandler(handler)
-    , mFilePath(filePath) {}
+    , mFilePath(filePath)
+    , mLevel(level) {}
 
 void ImageLoader::process()
 {
     const sk_sp<SkData> data = SkData::MakeFromFileName(mFilePath.toUtf8().data());
-    mImage = SkImage::MakeFromEncoded(data);
+    if (!data) { return; }
+    const auto codec = mLevel > 0 ? SkAndroidCodec::MakeFromData(data) : nullptr;
+    if (!codec) {
+        mImage = SkImage::MakeFromEncoded(data);
+        if (mImage) { mSourceSize = QSize(mImage->width(), mImage->height()); }
+        return;
+    }
+    const auto srcInfo = codec->getInfo();
+    mSourceSize = QSize(srcInfo.width(), srcInfo.height());
+    // lets the codec scale while decoding, e.g. DCT scaling for JPEG
+    const int sampleSize = 1 << mLevel;
+    const auto dims = codec->getSampledDimensions(sampleSize);
+    const auto info = SkiaHelpers::getPremulRGBAInfo(dims.width(),
+                                                     dims.height());
+    SkBitmap bitmap;
+    if (!bitmap.tryAllocPixels(info)) { return; }
+    SkAndroidCodec::AndroidOptions options;
+    options.fSampleSize = sampleSize;
+    const auto result = codec->getAndroidPixels(info, bitmap.getPixels(),
+                                                bitmap.rowBytes(), &options);
+    if (result != SkCodec::kSuccess &&
+        result != SkCodec::kIncompleteInput) { return; }
+    mImage = SkiaHelpers::transferDataToSkImage(bitmap);
 }
 
 void ImageLoader::afterProcessing()
 {
-    if (mTargetHandler) { mTargetHandler->replaceImage(mImage); }
+    if (mTargetHandler) {
+        mTargetHandler->replaceImage(mLevel, mImage, mSourceSize,
+                                     processingNs()/1000000.);
+    }
 }
 
 void ImageLoader::afterCanceled()
 {
-    if (mTargetHandler) { mTargetHandler->replaceImage(mImage); }
+    if (mTargetHandler) {
+        mTargetHandler->replaceImage(mLevel, mImage, mSourceSize,
+                                     processingNs()/1000000.);
+    }
 }
 
 /*void OraLoader::process()
@@ -38,7 +38,8 @@ class CORE_EXPORT ImageLoader : public eHddTask
 
 protected:
     ImageLoader(const QString &filePath,
-                ImageFileDataHandler * const handler);
+                ImageFileDataHandler * const handler,
+                const int level = 0);
 
 public:
     void process();
@@ -48,7 +49,10 @@ public:
 protected:
     const qptr<ImageFileDataHandler> mTargetHandler;
     const QString mFilePath;
+    //! @brief Pyramid level, the image is decoded at 1/2^level scale.
+    const int mLevel;
     sk_sp<SkImage> mImage;
+    QSize mSourceSize;
 };
 
 /*class CORE_EXPORT OraLoader : public ImageLoader
@@ -76,40 +80,59 @@ class CORE_EXPORT ImageFileDataHandler : public FileDataCacheHandler
         e_OBJECT
     protected:
         ImageCacheContainerX(const sk_sp<SkImage> &img,
-                             ImageFileDataHandler* const handler)
+                             ImageFileDataHandler* const handler,
+                             const int level)
         : ImageCacheContainer(img, FrameRange::EMINMAX, nullptr)
-        , mHandler(handler) {}
+        , mHandler(handler)
+        , mLevel(level)
+        {
+            setMemoryOwner(MemoryAccounting::Category::mediaFrames,
+                           handler->getFilePath());
+        }
 
         void noDataLeft_k()
         {
             ImageCacheContainer::noDataLeft_k();
             if (!mHandler) { return; }
-            mHandler->mImage.reset();
+            mHandler->mImages[mLevel].reset();
         }
 
     private:
         const qptr<ImageFileDataHandler> mHandler;
+        const int mLevel;
     };
 
 protected:
     ImageFileDataHandler();
 
 public:
+    //! @brief Coarsest pyramid level, 1/16 of the source size.
+    static const int sMaxLevel = 4;
+
     void afterSourceChanged();
     void clearCache();
 
-    eTask *scheduleLoad();
+    eTask *scheduleLoad(const int level = 0);
 
-    bool hasImage() const;
-    sk_sp<SkImage> getImage() const;
-    ImageCacheContainer* getImageContainer() { return mImage.get(); }
+    //! @brief True if the level, or a finer one, is in memory.
+    bool hasImage(const int level = 0) const;
+    sk_sp<SkImage> getImage(const int level = 0) const;
+    ImageCacheContainer* getImageContainer(const int level = 0);
+
+    //! @brief Coarsest level that still has at least the given scale.
+    int levelForScale(const qreal scale) const;
+    //! @brief Full resolution size, invalid until something was decoded.
+    QSize sourceSize() const { return mSourceSize; }
 
 private:
-    void replaceImage(const sk_sp<SkImage> &img);
+    void replaceImage(const int level, const sk_sp<SkImage> &img,
+                      const QSize &sourceSize, const qreal costMs);
+    ImageCacheContainerX* imageInMemory(const int level) const;
 
-    stdsptr<ImageCacheContainerX> mImage;
+    stdsptr<ImageCacheContainerX> mImages[sMaxLevel + 1];
+    stdsptr<ImageLoader> mImageLoaders[sMaxLevel + 1];
     Type mType = Type::none;
-    stdsptr<ImageLoader> mImageLoader;
+    QSize mSourceSize;
 };
 
 class CORE_EXPORT ImageFileHandler : public FileCacheHandler
@@ -129,28 +152,40 @@ protected:
 public:
     void replace();
 
-    eTask * scheduleLoad()
+    eTask * scheduleLoad(const int level = 0)
     {
         if (!mDataHandler) { return nullptr; }
-        return mDataHandler->scheduleLoad();
+        return mDataHandler->scheduleLoad(level);
     }
 
-    bool hasImage() const
+    bool hasImage(const int level = 0) const
     {
         if (!mDataHandler) { return false; }
-        return mDataHandler->hasImage();
+        return mDataHandler->hasImage(level);
     }
 
-    sk_sp<SkImage> getImage() const
+    sk_sp<SkImage> getImage(const int level = 0) const
     {
         if (!mDataHandler) { return nullptr; }
-        return mDataHandler->getImage();
+        return mDataHandler->getImage(level);
     }
 
-    ImageCacheContainer* getImageContainer() const
+    ImageCacheContainer* getImageContainer(const int level = 0) const
     {
         if (!mDataHandler) { return nullptr; }
-        return mDataHandler->getImageContainer();
+        return mDataHandler->getImageContainer(level);
+    }
+
+    int levelForScale(const qreal scale) const
+    {
+        if (!mDataHandler) { return 0; }
+        return mDataHandler->levelForScale(scale);
+    }
+
+    QSize sourceSize() const
+    {
+        if (!mDataHandler) { return QSize(); }
+        return mDataHandler->sourceSize();
     }
 
 private:
@@ -35,7 +35,8 @@ void SoundReader::beforeProcessing(const Hardware) {
 
 void SoundReader::afterProcessing() {
     mOpenedAudio->unlock();
-    mCacheHandler->secondReaderFinished(mSecondId, mSamples);
+    mCacheHandler->secondReaderFinished(mSecondId, mSamples,
+                                        processingNs()/1000000.);
 }
 
 void SoundReader::afterCanceled() {
@@ -213,4 +214,5 @@ void SoundReader::readFrame() {
     mSamples = enve::make_shared<Samples>(audioData, audioDataRange,
                                           dstSampleRate,
                                           dstSampleFormat, dstChLayout);
+    mSamples->fMemoryTag.setOwner(mOpenedAudio->fPath);
 }
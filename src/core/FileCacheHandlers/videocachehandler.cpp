@@ -24,6 +24,10 @@
 // Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
 
 #include "videocachehandler.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+
 #include "Boxes/boxrendercontainer.h"
 #include "Boxes/videobox.h"
 #include "CacheHandlers/imagecachecontainer.h"
@@ -32,6 +36,10 @@
 #include "filesourcescache.h"
 
 #include "videoframeloader.h"
+#include "videoproxy.h"
+#include "Private/Tasks/taskscheduler.h"
+#include "Private/Tasks/execcontroller.h"
+#include "Private/esettings.h"
 
 VideoFrameHandler::VideoFrameHandler(VideoDataHandler * const cacheHandler) :
     mDataHandler(cacheHandler) {
@@ -47,9 +55,13 @@ ImageCacheContainer* VideoFrameHandler::getFrameAtOrBeforeFrame(const int relFra
 }
 
 void VideoFrameHandler::frameLoaderFinished(const int frame,
-                                            const sk_sp<SkImage>& image) {
-    mDataHandler->frameLoaderFinished(frame, image);
+                                            const sk_sp<SkImage>& image,
+                                            const CompactFrame::Format format,
+                                            const QSize& size,
+                                            const qreal costMs) {
+    mDataHandler->frameLoaderFinished(frame, image, format, size, costMs);
     removeFrameLoader(frame);
+    if(image) schedulePrefetch();
 }
 
 void VideoFrameHandler::frameLoaderCanceled(const int frameId) {
@@ -100,11 +112,46 @@ void VideoFrameHandler::removeFrameLoader(const int frame) {
     mNeededFrames.erase(frame);
 }
 
+void VideoFrameHandler::schedulePrefetch() {
+    // the frames that were asked for come first
+    if(!mNeededFrames.empty()) return;
+    if(mPrefetchFrame >= 0 && getFrameLoader(mPrefetchFrame)) return;
+    const auto& seekIndex = mDataHandler->getSeekIndex();
+    if(!seekIndex) return;
+    const int frameCount = getFrameCount();
+    const int maxFrames = VideoFrameLoader::sMaxExcessFrames(
+                mVideoStreamsData->fWidth, mVideoStreamsData->fHeight);
+    // first frame missing next to the playhead, in the playing direction
+    int frame = mLastRequestedFrame + mPlayDirection;
+    while(frame >= 0 && frame < frameCount &&
+          (getFrameAtFrame(frame) || getFrameLoader(frame))) {
+        if(qAbs(frame - mLastRequestedFrame) > maxFrames) return;
+        frame += mPlayDirection;
+    }
+    if(frame < 0 || frame >= frameCount) return;
+    int target = frame;
+    if(mPlayDirection > 0) {
+        // decode up to the end of the group of pictures
+        const auto next = seekIndex->keyframeAfter(frame);
+        target = next ? next->fFrame - 1 : frameCount - 1;
+        target = qMin(target, frame + maxFrames - 1);
+    }
+    // the frames decoded on the way to target are kept with it
+    const auto loader = enve::make_shared<VideoFrameLoader>(
+                    this, mVideoStreamsData, target);
+    loader->setPriority(eTaskPriority::lookAhead);
+    mDataHandler->addFrameLoader(target, loader);
+    mPrefetchFrame = target;
+    loader->queTask();
+}
+
 void VideoFrameHandler::openVideoStream()
 {
     const auto filePath = mDataHandler->getFilePath();
     mVideoStreamsData = VideoStreamsData::sOpen(filePath);
-    mDataHandler->setFrameCount(mVideoStreamsData->fFrameCount);
+    const auto& seekIndex = mDataHandler->getSeekIndex();
+    mDataHandler->setFrameCount(seekIndex ? seekIndex->frameCount() :
+                                            mVideoStreamsData->fFrameCount);
     mDataHandler->setFps(mVideoStreamsData->fFps);
     mDataHandler->setDim(QSize(mVideoStreamsData->fWidth,
                                mVideoStreamsData->fHeight));
@@ -113,6 +160,10 @@ void VideoFrameHandler::openVideoStream()
 eTask* VideoFrameHandler::scheduleFrameLoad(const int frame) {
     if(frame < 0 || frame >= getFrameCount())
         RuntimeThrow("Frame outside of range " + std::to_string(frame));
+    if(frame != mLastRequestedFrame) {
+        mPlayDirection = frame > mLastRequestedFrame ? 1 : -1;
+        mLastRequestedFrame = frame;
+    }
     const auto currLoader = getFrameLoader(frame);
     if(currLoader) return currLoader;
     if(mDataHandler->getFrameAtFrame(frame)) return nullptr;
@@ -162,10 +213,102 @@ void VideoFileHandler::replace() {
     }
 }
 
+void VideoFileHandler::createProxy() {
+    startProxyTranscode(false);
+}
+
+// One thread transcodes the proxies of all files one after another,
+// importing many large files does not start as many full-file transcodes.
+// Released once no file has a transcode queued anymore.
+static stdsptr<DecoderExecController> sProxyDecoder() {
+    static std::weak_ptr<DecoderExecController> sDecoder;
+    auto decoder = sDecoder.lock();
+    if(!decoder) {
+        const auto scheduler = TaskScheduler::instance();
+        if(!scheduler) return nullptr;
+        decoder = scheduler->createDecoder("Proxies");
+        sDecoder = decoder;
+    }
+    return decoder;
+}
+
+void VideoFileHandler::startProxyTranscode(const bool onlyWorthwhile) {
+    if(mProxyHandler || mProxyTranscoder || fileMissing()) return;
+    if(!mProxyDecoder) mProxyDecoder = sProxyDecoder();
+    if(!mProxyDecoder) return;
+    const qptr<VideoFileHandler> ptr = this;
+    const int generation = mProxyGeneration;
+    const auto finished = [ptr, generation](const bool done) {
+        if(!ptr || ptr->mProxyGeneration != generation) return;
+        ptr->mProxyTranscoder.reset();
+        ptr->mProxyDecoder.reset();
+        if(done) ptr->loadProxy(false);
+    };
+    mProxyTranscoder = enve::make_shared<VideoProxyTranscoder>(
+                path(), mProxyDecoder.get(), onlyWorthwhile, finished);
+    mProxyTranscoder->queTask();
+}
+
+void VideoFileHandler::loadProxy(const bool create) {
+    const QString proxyPath = VideoProxy::sPath(path());
+    QFile proxyFile(proxyPath);
+    if(proxyFile.open(QIODevice::ReadWrite)) {
+        // keeps proxies in use from being removed by the cache cap
+        proxyFile.setFileTime(QDateTime::currentDateTime(),
+                              QFileDevice::FileModificationTime);
+        proxyFile.close();
+        mProxyHandler = VideoDataHandler::sGetCreateDataHandler<
+                            VideoDataHandler>(proxyPath);
+    } else {
+        mProxyHandler.reset();
+    }
+    emit proxyChanged();
+    // on import only sources larger than a proxy get one
+    if(create && !mProxyHandler) startProxyTranscode(true);
+}
+
+void VideoFileHandler::stopProxyTranscode() {
+    mProxyGeneration++;
+    if(mProxyTranscoder) mProxyTranscoder->abort();
+    mProxyTranscoder.reset();
+    mProxyDecoder.reset();
+}
+
 void VideoDataHandler::afterSourceChanged() {
+    mSeekIndex.reset();
     for(const auto& handler : mFrameHandlers) {
         handler->afterSourceChanged();
     }
+    buildSeekIndex();
+}
+
+void VideoDataHandler::buildSeekIndex() {
+    const QString path = getFilePath();
+    if(path.isEmpty()) return;
+    const qptr<VideoDataHandler> ptr = this;
+    const auto finished = [ptr, path](const stdsptr<VideoSeekIndex>& index) {
+        if(!ptr || !index || ptr->getFilePath() != path) return;
+        ptr->mSeekIndex = index;
+        if(index->frameCount() != ptr->mFrameCount) {
+            ptr->mFrameCount = index->frameCount();
+            emit ptr->frameCountUpdated(ptr->mFrameCount);
+        }
+    };
+    enve::make_shared<VideoSeekIndexBuilder>(
+                path, getDecoder(), finished)->queTask();
+}
+
+const stdsptr<const VideoSeekIndex>& VideoDataHandler::getSeekIndex() const {
+    return mSeekIndex;
+}
+
+DecoderExecController* VideoDataHandler::getDecoder() {
+    if(!mDecoder) {
+        const auto scheduler = TaskScheduler::instance();
+        if(!scheduler) return nullptr;
+        mDecoder = scheduler->createDecoder(QFileInfo(getFilePath()).fileName());
+    }
+    return mDecoder.get();
 }
 
 const HddCachableCacheHandler &VideoDataHandler::getCacheHandler() const {
@@ -192,10 +335,19 @@ void VideoDataHandler::removeFrameLoader(const int frame) {
 }
 
 void VideoDataHandler::frameLoaderFinished(const int frame,
-                                           const sk_sp<SkImage> &image) {
+                                           const sk_sp<SkImage> &image,
+                                           const CompactFrame::Format format,
+                                           const QSize& size,
+                                           const qreal costMs) {
     if(image) {
-        mFramesCache.add(enve::make_shared<ImageCacheContainer>(
-                             image, FrameRange{frame, frame}, &mFramesCache));
+        const auto cont = enve::make_shared<ImageCacheContainer>(
+                    FrameRange{frame, frame}, &mFramesCache);
+        cont->setRecomputeCost(costMs);
+        if(format == CompactFrame::Format::rgba) cont->replaceImage(image);
+        else cont->replaceImage(image, format, size.width(), size.height());
+        cont->setMemoryOwner(MemoryAccounting::Category::mediaFrames,
+                             getFilePath());
+        mFramesCache.add(cont);
     } else {
         mFrameCount = frame;
         emit frameCountUpdated(mFrameCount);
@@ -265,15 +417,23 @@ bool hasSound(const char* path) {
     return false;
 }
 
+VideoFileHandler::~VideoFileHandler() {
+    stopProxyTranscode();
+}
+
 void VideoFileHandler::reload() {
+    stopProxyTranscode();
     if(fileMissing()) {
         mDataHandler.reset();
         mSoundHandler.reset();
+        mProxyHandler.reset();
+        emit proxyChanged();
         return;
     }
     const QString& path = this->path();
     mDataHandler = VideoDataHandler::sGetCreateDataHandler<VideoDataHandler>(path);
     mDataHandler->reload();
+    loadProxy(eSettings::instance().fAutoVideoProxies);
     if(hasSound(path.toUtf8().data())) {
         mSoundHandler = SoundDataHandler::sGetCreateDataHandler<SoundDataHandler>(path);
         mSoundHandler->reload();
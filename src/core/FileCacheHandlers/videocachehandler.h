@@ -28,13 +28,17 @@
 
 #include "animationcachehandler.h"
 #include "videostreamsdata.h"
+#include "videoseekindex.h"
 #include "filecachehandler.h"
 #include "CacheHandlers/hddcachablecachehandler.h"
+#include "CacheHandlers/compactframe.h"
 
 #include <set>
 
 class VideoFrameLoader;
 class VideoFrameHandler;
+class VideoProxyTranscoder;
+class DecoderExecController;
 
 class CORE_EXPORT VideoDataHandler : public FileDataCacheHandler {
     Q_OBJECT
@@ -49,7 +53,9 @@ public:
     void addFrameLoader(const int frameId, const stdsptr<VideoFrameLoader>& loader);
     VideoFrameLoader * getFrameLoader(const int frame) const;
     void removeFrameLoader(const int frame);
-    void frameLoaderFinished(const int frame, const sk_sp<SkImage>& image);
+    void frameLoaderFinished(const int frame, const sk_sp<SkImage>& image,
+                             const CompactFrame::Format format,
+                             const QSize& size, const qreal costMs);
     eTask* scheduleFrameHddCacheLoad(const int frame);
     ImageCacheContainer* getFrameAtFrame(const int relFrame) const;
     ImageCacheContainer* getFrameAtOrBeforeFrame(const int relFrame) const;
@@ -59,6 +65,10 @@ public:
     void setFps(const qreal fps);
     const QSize getDim();
     void setDim(const QSize dim);
+    //! @brief Keyframe index of the file, nullptr until it is built
+    const stdsptr<const VideoSeekIndex>& getSeekIndex() const;
+    //! @brief Thread decoding the frames of this file
+    DecoderExecController* getDecoder();
 signals:
     void frameCountUpdated(int);
 private:
@@ -70,6 +80,10 @@ private:
     QList<int> mFramesBeingLoaded;
     QList<stdsptr<VideoFrameLoader>> mFrameLoaders;
     HddCachableCacheHandler mFramesCache;
+    stdsptr<const VideoSeekIndex> mSeekIndex;
+    stdsptr<DecoderExecController> mDecoder;
+
+    void buildSeekIndex();
 };
 
 class CORE_EXPORT VideoFrameHandler : public AnimationFrameHandler {
@@ -86,7 +100,9 @@ public:
 
     void afterSourceChanged();
 
-    void frameLoaderFinished(const int frame, const sk_sp<SkImage>& image);
+    void frameLoaderFinished(const int frame, const sk_sp<SkImage>& image,
+                             const CompactFrame::Format format,
+                             const QSize& size, const qreal costMs);
     void frameLoaderCanceled(const int frameId);
     void frameLoaderFailed(const int frameId);
 
@@ -97,10 +113,14 @@ protected:
     VideoFrameLoader * addFrameLoader(const int frameId);
     VideoFrameLoader * addFrameConverter(const int frameId, AVFrame * const frame);
     void removeFrameLoader(const int frame);
+    void schedulePrefetch();
 
     void openVideoStream();
 private:
     std::set<int> mNeededFrames;
+    int mLastRequestedFrame = 0;
+    int mPlayDirection = 1;
+    int mPrefetchFrame = -1;
 
     VideoDataHandler* const mDataHandler;
     stdsptr<VideoStreamsData> mVideoStreamsData;
@@ -108,11 +128,14 @@ private:
 #include "CacheHandlers/soundcachehandler.h"
 class CORE_EXPORT VideoFileHandler : public FileCacheHandler {
     e_OBJECT
+    Q_OBJECT
 protected:
     VideoFileHandler() {}
 
     void reload();
 public:
+    ~VideoFileHandler();
+
     void replace();
 
     VideoDataHandler* getFrameHandler() const {
@@ -122,9 +145,26 @@ public:
     SoundDataHandler* getSoundHandler() const {
         return mSoundHandler.get();
     }
+
+    //! @brief Reduced copy of the file for previews, nullptr if none is built
+    VideoDataHandler* getProxyHandler() const {
+        return mProxyHandler.get();
+    }
+    //! @brief Transcodes the proxy in the background unless it exists
+    void createProxy();
+signals:
+    void proxyChanged();
 private:
+    void loadProxy(const bool create);
+    void startProxyTranscode(const bool onlyWorthwhile);
+    void stopProxyTranscode();
+
     qsptr<VideoDataHandler> mDataHandler;
     qsptr<SoundDataHandler> mSoundHandler;
+    qsptr<VideoDataHandler> mProxyHandler;
+    stdsptr<VideoProxyTranscoder> mProxyTranscoder;
+    stdsptr<DecoderExecController> mProxyDecoder; // shared by all files
+    int mProxyGeneration = 0;
 };
 
 #endif // VIDEOCACHEHANDLER_H
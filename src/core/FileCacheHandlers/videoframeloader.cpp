@@ -27,12 +27,16 @@
 #include "videocachehandler.h"
 #include "Private/Tasks/taskscheduler.h"
 #include "Private/Tasks/taskexecutor.h"
+#include "Private/esettings.h"
 
 VideoFrameLoader::VideoFrameLoader(VideoFrameHandler * const cacheHandler,
                                    const stdsptr<VideoStreamsData> &openedVideo,
                                    const int frameId) :
     mCacheHandler(cacheHandler), mOpenedVideo(openedVideo),
-    mFrameId(frameId) {}
+    mSeekIndex(cacheHandler ? cacheHandler->getDataHandler()->getSeekIndex() :
+                              nullptr),
+    mFrameId(frameId),
+    mMemoryTag(MemoryAccounting::Category::decoding, openedVideo->fPath) {}
 
 VideoFrameLoader::VideoFrameLoader(VideoFrameHandler * const cacheHandler,
                                    const stdsptr<VideoStreamsData> &openedVideo,
@@ -50,6 +54,10 @@ VideoFrameLoader::~VideoFrameLoader() {
 }
 
 void VideoFrameLoader::convertFrame() {
+    mLoadedSize = QSize(mFrameToConvert->width, mFrameToConvert->height);
+    if(mLoadedFormat != CompactFrame::Format::rgba) {
+        return convertFrameToPlanes();
+    }
     const auto info = SkiaHelpers::getPremulRGBAInfo(
                 mFrameToConvert->width, mFrameToConvert->height);
     SkBitmap bitmap;
@@ -73,15 +81,44 @@ void VideoFrameLoader::convertFrame() {
     cleanUp();
 }
 
+void VideoFrameLoader::convertFrameToPlanes() {
+    const bool alpha = mLoadedFormat == CompactFrame::Format::yuva420;
+    AVFrame* planes = av_frame_alloc();
+    if(!planes) return cleanUp();
+    planes->width = mFrameToConvert->width;
+    planes->height = mFrameToConvert->height;
+    planes->format = alpha ? AV_PIX_FMT_YUVA420P : AV_PIX_FMT_YUV420P;
+    // sws may write past the plane width, so it gets its own padded planes
+    if(av_frame_get_buffer(planes, 32) >= 0) {
+        sws_scale(mSwsContext, mFrameToConvert->data,
+                  mFrameToConvert->linesize, 0, mFrameToConvert->height,
+                  planes->data, planes->linesize);
+        mLoadedFrame = CompactFrame::sPackPlanes(planes->data,
+                                                 planes->linesize,
+                                                 planes->width,
+                                                 planes->height);
+    }
+    av_frame_free(&planes);
+    cleanUp();
+}
+
 int frameId(AVFrame * const decodedFrame,
             AVStream * const videoStream,
             const qreal fps) {
-    int64_t pts = decodedFrame->best_effort_timestamp;
-    pts = av_rescale_q(pts, videoStream->time_base, {1, AV_TIME_BASE});
-    const qreal frameApprox = pts/1000000.*fps;
-    const int frameRound = qRound(frameApprox);
-    if(frameRound - frameApprox > 0.4) return frameRound - 1;
-    return frameRound;
+    return VideoSeekIndex::sFrameAt(decodedFrame->best_effort_timestamp,
+                                    videoStream->time_base, fps);
+}
+
+bool seekKeyframe(const VideoSeekIndex::Keyframe& keyframe,
+                  AVFormatContext * const formatContext,
+                  const int videoStreamIndex,
+                  AVCodecContext * const codecContext) {
+    const int64_t ts = keyframe.fPts != AV_NOPTS_VALUE ? keyframe.fPts :
+                                                         keyframe.fDts;
+    if(av_seek_frame(formatContext, videoStreamIndex, ts,
+                     AVSEEK_FLAG_BACKWARD) < 0) return false;
+    avcodec_flush_buffers(codecContext);
+    return true;
 }
 
 void seek(const int tryN, const int frameId, const qreal fps,
@@ -120,9 +157,26 @@ void VideoFrameLoader::readFrame() {
     //const auto swsContext = mOpenedVideo->fSwsContext;
     const qreal fps = mOpenedVideo->fFps;
 
+    // with an index the whole group of pictures is kept, up to a budget
+    const int maxExcess = mSeekIndex ?
+                sMaxExcessFrames(codecContext->width, codecContext->height) : 20;
     int seekTry = 0;
-    if(mOpenedVideo->fLastFrame >= mFrameId ||
-       mFrameId - mOpenedVideo->fLastFrame > fps) {
+    const auto keyframe = mSeekIndex ?
+                mSeekIndex->keyframeAtOrBefore(mFrameId) : nullptr;
+    if(keyframe) {
+        // decode forward as long as the frame is in the current group
+        // of pictures, otherwise start from the keyframe preceding it
+        if(mOpenedVideo->fLastFrame >= mFrameId ||
+           mOpenedVideo->fLastFrame < keyframe->fFrame) {
+            // falls back to the fps based seek on failure
+            if(!seekKeyframe(*keyframe, formatContext,
+                             videoStreamIndex, codecContext)) {
+                seek(seekTry++, mFrameId, fps, formatContext,
+                     videoStreamIndex, videoStream, codecContext);
+            }
+        }
+    } else if(mOpenedVideo->fLastFrame >= mFrameId ||
+              mFrameId - mOpenedVideo->fLastFrame > fps) {
         seek(seekTry++, mFrameId, fps, formatContext,
              videoStreamIndex, videoStream, codecContext);
     }
@@ -183,7 +237,7 @@ void VideoFrameLoader::readFrame() {
             setFrameToConvert(decodedFrame, codecContext);
             decodedFrame = av_frame_alloc();
             break;
-        } else if(qAbs(mFrameId - currFrame) < 20) {
+        } else if(qAbs(mFrameId - currFrame) < maxExcess) {
             mExcessFrames.append({currFrame, decodedFrame});
             decodedFrame = av_frame_alloc();
         } else av_frame_unref(decodedFrame);
@@ -195,7 +249,9 @@ void VideoFrameLoader::readFrame() {
 
 void VideoFrameLoader::afterProcessing() {
     if(!mCacheHandler) return;
-    mCacheHandler->frameLoaderFinished(mFrameId, mLoadedFrame);
+    mCacheHandler->frameLoaderFinished(mFrameId, mLoadedFrame,
+                                       mLoadedFormat, mLoadedSize,
+                                       processingNs()/1000000.);
     for(auto& excess : mExcessFrames) {
         if(mCacheHandler->getFrameAtFrame(excess.first)) {
             av_frame_unref(excess.second);
@@ -213,10 +269,14 @@ void VideoFrameLoader::afterProcessing() {
         } else {
             const auto newFL = mCacheHandler->addFrameConverter(
                         excess.first, excess.second);
+            if(priority() > eTaskPriority::interactive) {
+                newFL->setPriority(priority());
+            }
             newFL->queTask();
         }
     }
     mExcessFrames.clear();
+    updateMemoryTag();
 }
 
 void VideoFrameLoader::afterCanceled() {
@@ -239,11 +299,40 @@ bool VideoFrameLoader::handleException() {
 }
 
 void VideoFrameLoader::queTaskNow() {
+    const auto scheduler = TaskScheduler::instance();
     if(mFrameToConvert) {
-        TaskScheduler::instance()->queCpuTask(ref<eTask>());
-    } else {
-        TaskScheduler::instance()->queHddTask(ref<eTask>());
+        scheduler->queCpuTask(ref<eTask>());
+        return;
     }
+    const auto decoder = mCacheHandler ?
+                mCacheHandler->getDataHandler()->getDecoder() : nullptr;
+    if(decoder) scheduler->queDecoderTask(ref<eTask>(), decoder);
+    else scheduler->queHddTask(ref<eTask>());
+}
+
+static SwsContext* planesSwsContext(AVCodecContext * const codecContext,
+                                    CompactFrame::Format& format) {
+    const auto desc = av_pix_fmt_desc_get(codecContext->pix_fmt);
+    const bool alpha = desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+    const auto ctx = sws_alloc_context();
+    if(!ctx) return nullptr;
+    av_opt_set_int(ctx, "srcw", codecContext->width, 0);
+    av_opt_set_int(ctx, "srch", codecContext->height, 0);
+    av_opt_set_int(ctx, "src_format", codecContext->pix_fmt, 0);
+    av_opt_set_int(ctx, "dstw", codecContext->width, 0);
+    av_opt_set_int(ctx, "dsth", codecContext->height, 0);
+    av_opt_set_int(ctx, "dst_format", alpha ? AV_PIX_FMT_YUVA420P :
+                                              AV_PIX_FMT_YUV420P, 0);
+    av_opt_set_int(ctx, "sws_flags", SWS_BICUBIC, 0);
+    // CompactFrame planes are full range
+    av_opt_set_int(ctx, "dst_range", 1, 0);
+    if(sws_init_context(ctx, nullptr, nullptr) < 0) {
+        sws_freeContext(ctx);
+        return nullptr;
+    }
+    format = alpha ? CompactFrame::Format::yuva420 :
+                     CompactFrame::Format::yuv420;
+    return ctx;
 }
 
 void VideoFrameLoader::setFrameToConvert(
@@ -251,6 +340,11 @@ void VideoFrameLoader::setFrameToConvert(
         AVCodecContext * const codecContext) {
     cleanUp();
     mFrameToConvert = frame;
+    if(eSettings::instance().fCompactVideoCache) {
+        mSwsContext = planesSwsContext(codecContext, mLoadedFormat);
+        if(mSwsContext) return updateMemoryTag();
+    }
+    mLoadedFormat = CompactFrame::Format::rgba;
     mSwsContext = sws_getContext(codecContext->width,
                                  codecContext->height,
                                  codecContext->pix_fmt,
@@ -258,6 +352,7 @@ void VideoFrameLoader::setFrameToConvert(
                                  codecContext->height,
                                  AV_PIX_FMT_RGBA, SWS_BICUBIC,
                                  nullptr, nullptr, nullptr);
+    updateMemoryTag();
 }
 
 void VideoFrameLoader::process() {
@@ -266,6 +361,7 @@ void VideoFrameLoader::process() {
     } else {
         readFrame();
     }
+    updateMemoryTag();
 }
 
 bool VideoFrameLoader::nextStep() {
@@ -276,6 +372,17 @@ bool VideoFrameLoader::nextStep() {
     return false;
 }
 
+int VideoFrameLoader::sMaxExcessFrames(const int width, const int height) {
+    const qint64 frameBytes = qMax(qint64(1), qint64(width)*height*4);
+    // an eighth of the RAM cache budget at most
+    const qint64 budget = qint64(eSettings::sRamMBCap().fValue)*1024*1024/8;
+    return int(qBound(qint64(20), budget/frameBytes, qint64(300)));
+}
+
+QString VideoFrameLoader::traceOwner() const {
+    return mOpenedVideo->fPath;
+}
+
 void VideoFrameLoader::cleanUp() {
     if(mFrameToConvert) {
         av_frame_unref(mFrameToConvert);
@@ -287,3 +394,23 @@ void VideoFrameLoader::cleanUp() {
         mSwsContext = nullptr;
     }
 }
+
+static qint64 frameBytes(const AVFrame * const frame) {
+    qint64 bytes = 0;
+    for(int i = 0; i < AV_NUM_DATA_POINTERS; i++) {
+        if(frame->buf[i]) bytes += frame->buf[i]->size;
+    }
+    return bytes;
+}
+
+void VideoFrameLoader::updateMemoryTag() {
+    qint64 bytes = 0;
+    if(mFrameToConvert) bytes += frameBytes(mFrameToConvert);
+    for(const auto& excess : mExcessFrames) {
+        bytes += frameBytes(excess.second);
+    }
+    if(mLoadedFrame) bytes += qint64(mLoadedFrame->width())*
+                              mLoadedFrame->height()*
+                              mLoadedFrame->imageInfo().bytesPerPixel();
+    mMemoryTag.setBytes(bytes);
+}
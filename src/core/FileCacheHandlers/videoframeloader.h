@@ -28,6 +28,8 @@
 #include "Tasks/updatable.h"
 #include "skia/skiaincludes.h"
 #include "videocachehandler.h"
+#include "memoryaccounting.h"
+#include "CacheHandlers/compactframe.h"
 extern "C" {
     #include <libavutil/opt.h>
     #include <libavcodec/avcodec.h>
@@ -52,6 +54,12 @@ public:
 
     void process();
     bool nextStep();
+
+    QString traceOwner() const;
+    qreal traceFrame() const { return mFrameId; }
+
+    //! @brief Decoded frames kept on the way to the wanted one
+    static int sMaxExcessFrames(const int width, const int height);
 protected:
     void afterProcessing();
     void afterCanceled();
@@ -65,16 +73,22 @@ private:
     void setFrameToConvert(AVFrame * const frame,
                            AVCodecContext * const codecContext);
     void convertFrame();
+    void convertFrameToPlanes();
+    void updateMemoryTag();
 
     const qptr<VideoFrameHandler> mCacheHandler;
     const stdsptr<VideoStreamsData> mOpenedVideo;
+    const stdsptr<const VideoSeekIndex> mSeekIndex;
     const int mFrameId;
     sk_sp<SkImage> mLoadedFrame;
+    CompactFrame::Format mLoadedFormat = CompactFrame::Format::rgba;
+    QSize mLoadedSize;
 
     QList<std::pair<int, AVFrame*>> mExcessFrames;
 
     AVFrame * mFrameToConvert = nullptr;
     struct SwsContext * mSwsContext = nullptr;
+    MemoryAccounting::Tag mMemoryTag;
 };
 
 #endif // VIDEOFRAMELOADER_H
@@ -0,0 +1,288 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "videoproxy.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "videoseekindex.h"
+#include "CacheHandlers/persistentrendercache.h"
+#include "Private/Tasks/taskscheduler.h"
+#include "Private/esettings.h"
+extern "C" {
+    #include <libavcodec/avcodec.h>
+    #include <libavformat/avformat.h>
+    #include <libavutil/pixdesc.h>
+    #include <libswscale/swscale.h>
+}
+
+// previews rarely need more, larger sources are halved until they fit
+static const int sMaxProxyWidth = 1920;
+
+QString VideoProxy::sPath(const QString& videoPath) {
+    const QString name = VideoSeekIndex::sCacheKey(videoPath) + ".proxy.mov";
+    return QDir(PersistentRenderCache::sFolder()).filePath(name);
+}
+
+QSize VideoProxy::sSize(const QSize& source) {
+    int div = 2;
+    while(source.width()/div > sMaxProxyWidth) div *= 2;
+    // even, as the frames are 4:2:0
+    return QSize(qMax(2, source.width()/div/2*2),
+                 qMax(2, source.height()/div/2*2));
+}
+
+bool VideoProxy::sWorthwhile(const QSize& source) {
+    return source.width() > sMaxProxyWidth;
+}
+
+namespace {
+
+struct Transcode {
+    ~Transcode() {
+        if(fScaled) av_frame_free(&fScaled);
+        if(fDecoded) av_frame_free(&fDecoded);
+        if(fEncoded) av_packet_free(&fEncoded);
+        if(fPacket) av_packet_free(&fPacket);
+        if(fSwsContext) sws_freeContext(fSwsContext);
+        if(fDecoder) avcodec_free_context(&fDecoder);
+        if(fEncoder) avcodec_free_context(&fEncoder);
+        if(fOutput) {
+            if(fOutput->pb) avio_closep(&fOutput->pb);
+            avformat_free_context(fOutput);
+        }
+        if(fInput) avformat_close_input(&fInput);
+    }
+
+    bool openInput(const QString& path);
+    bool openOutput(const QString& path);
+    bool decodePacket(const AVPacket* const packet,
+                      const std::atomic<bool>& abort);
+    bool writeDecoded();
+    bool encode(AVFrame* const frame);
+
+    AVFormatContext* fInput = nullptr;
+    AVFormatContext* fOutput = nullptr;
+    AVStream* fSrcStream = nullptr;
+    AVStream* fDstStream = nullptr;
+    AVCodecContext* fDecoder = nullptr;
+    AVCodecContext* fEncoder = nullptr;
+    SwsContext* fSwsContext = nullptr;
+    AVPacket* fPacket = nullptr;
+    AVPacket* fEncoded = nullptr;
+    AVFrame* fDecoded = nullptr;
+    AVFrame* fScaled = nullptr;
+    qreal fFps = 0;
+    int fNextFrame = 0;
+};
+
+bool Transcode::openInput(const QString& path) {
+    const auto stdString = path.toStdString();
+    if(avformat_open_input(&fInput, stdString.c_str(),
+                           nullptr, nullptr) != 0) {
+        return false;
+    }
+    if(avformat_find_stream_info(fInput, nullptr) < 0) return false;
+    // same stream VideoStreamsData decodes
+    for(uint i = 0; i < fInput->nb_streams; i++) {
+        AVStream * const iStream = fInput->streams[i];
+        if(!fSrcStream &&
+           iStream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            fSrcStream = iStream;
+        } else {
+            iStream->discard = AVDISCARD_ALL;
+        }
+    }
+    if(!fSrcStream || fSrcStream->avg_frame_rate.den == 0) return false;
+    fFps = av_q2d(fSrcStream->avg_frame_rate);
+    const auto pars = fSrcStream->codecpar;
+    // MJPEG has no alpha, such sources keep decoding the original
+    const auto desc = av_pix_fmt_desc_get(AVPixelFormat(pars->format));
+    if(desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA)) return false;
+    const auto codec = avcodec_find_decoder(pars->codec_id);
+    if(!codec) return false;
+    fDecoder = avcodec_alloc_context3(codec);
+    if(!fDecoder) return false;
+    if(avcodec_parameters_to_context(fDecoder, pars) < 0) return false;
+    const int maxThreads = eSettings::sCpuThreadsCapped() - 1;
+    if(maxThreads > 0) fDecoder->thread_count = qMin(16, maxThreads);
+    fDecoder->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    if(avcodec_open2(fDecoder, codec, nullptr) < 0) return false;
+    fPacket = av_packet_alloc();
+    fDecoded = av_frame_alloc();
+    return fPacket && fDecoded;
+}
+
+bool Transcode::openOutput(const QString& path) {
+    const auto stdString = path.toStdString();
+    avformat_alloc_output_context2(&fOutput, nullptr, "mov",
+                                   stdString.c_str());
+    if(!fOutput) return false;
+    const auto codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    if(!codec) return false;
+    fDstStream = avformat_new_stream(fOutput, nullptr);
+    fEncoder = avcodec_alloc_context3(codec);
+    if(!fDstStream || !fEncoder) return false;
+
+    const QSize size = VideoProxy::sSize({fDecoder->width, fDecoder->height});
+    const AVRational rate = fSrcStream->avg_frame_rate;
+    fEncoder->width = size.width();
+    fEncoder->height = size.height();
+    fEncoder->pix_fmt = AV_PIX_FMT_YUVJ420P;
+    fEncoder->color_range = AVCOL_RANGE_JPEG;
+    fEncoder->time_base = av_inv_q(rate);
+    fEncoder->framerate = rate;
+    fEncoder->flags |= AV_CODEC_FLAG_QSCALE;
+    fEncoder->global_quality = FF_QP2LAMBDA*3;
+    if(fOutput->oformat->flags & AVFMT_GLOBALHEADER) {
+        fEncoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    if(avcodec_open2(fEncoder, codec, nullptr) < 0) return false;
+    if(avcodec_parameters_from_context(fDstStream->codecpar, fEncoder) < 0) {
+        return false;
+    }
+    fDstStream->time_base = fEncoder->time_base;
+    fDstStream->avg_frame_rate = rate;
+
+    if(avio_open(&fOutput->pb, stdString.c_str(), AVIO_FLAG_WRITE) < 0) {
+        return false;
+    }
+    if(avformat_write_header(fOutput, nullptr) < 0) return false;
+
+    fEncoded = av_packet_alloc();
+    fScaled = av_frame_alloc();
+    if(!fEncoded || !fScaled) return false;
+    fScaled->width = fEncoder->width;
+    fScaled->height = fEncoder->height;
+    fScaled->format = fEncoder->pix_fmt;
+    return av_frame_get_buffer(fScaled, 32) >= 0;
+}
+
+bool Transcode::decodePacket(const AVPacket* const packet,
+                             const std::atomic<bool>& abort) {
+    // broken packets are skipped, like the frame loader does
+    if(avcodec_send_packet(fDecoder, packet) < 0) return true;
+    while(!abort && avcodec_receive_frame(fDecoder, fDecoded) >= 0) {
+        const bool ok = writeDecoded();
+        av_frame_unref(fDecoded);
+        if(!ok) return false;
+    }
+    return !abort;
+}
+
+bool Transcode::writeDecoded() {
+    const int64_t ts = fDecoded->best_effort_timestamp;
+    if(ts == AV_NOPTS_VALUE) return true;
+    const int frame = VideoSeekIndex::sFrameAt(ts, fSrcStream->time_base,
+                                               fFps);
+    if(frame < fNextFrame) return true;
+    // a minute long gap is a broken timestamp rather than a still
+    if(frame - fNextFrame > 60*qMax(1, qRound(fFps))) return true;
+
+    fSwsContext = sws_getCachedContext(
+                fSwsContext, fDecoded->width, fDecoded->height,
+                AVPixelFormat(fDecoded->format),
+                fScaled->width, fScaled->height,
+                AVPixelFormat(fScaled->format), SWS_AREA,
+                nullptr, nullptr, nullptr);
+    if(!fSwsContext) return false;
+    if(av_frame_make_writable(fScaled) < 0) return false;
+    sws_scale(fSwsContext, fDecoded->data, fDecoded->linesize,
+              0, fDecoded->height, fScaled->data, fScaled->linesize);
+    // the proxy has a frame for every frame number of the source
+    for(; fNextFrame <= frame; fNextFrame++) {
+        fScaled->pts = fNextFrame;
+        if(!encode(fScaled)) return false;
+    }
+    return true;
+}
+
+bool Transcode::encode(AVFrame* const frame) {
+    if(avcodec_send_frame(fEncoder, frame) < 0) return false;
+    while(true) {
+        const int ret = avcodec_receive_packet(fEncoder, fEncoded);
+        if(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+        if(ret < 0) return false;
+        av_packet_rescale_ts(fEncoded, fEncoder->time_base,
+                             fDstStream->time_base);
+        fEncoded->stream_index = fDstStream->index;
+        if(av_interleaved_write_frame(fOutput, fEncoded) < 0) return false;
+    }
+}
+
+}
+
+void VideoProxyTranscoder::queTaskNow() {
+    const auto scheduler = TaskScheduler::instance();
+    if(mDecoder) scheduler->queDecoderTask(ref<eTask>(), mDecoder);
+    else scheduler->queHddTask(ref<eTask>());
+}
+
+void VideoProxyTranscoder::process() {
+    // aborted while waiting behind the proxies of other files
+    if(mAbort) return;
+    const QString dstPath = VideoProxy::sPath(mVideoPath);
+    if(QFile::exists(dstPath)) {
+        mDone = true;
+        return;
+    }
+    // written aside, a proxy that exists is always complete
+    const QString partPath = dstPath + ".part";
+    QFile::remove(partPath);
+    mDone = transcode(partPath) && QFile::rename(partPath, dstPath);
+    if(mDone) PersistentRenderCache::sEntryAdded(QFileInfo(dstPath).size());
+    else QFile::remove(partPath);
+}
+
+bool VideoProxyTranscoder::transcode(const QString& dstPath) {
+    Transcode t;
+    if(!t.openInput(mVideoPath)) return false;
+    if(mOnlyWorthwhile &&
+       !VideoProxy::sWorthwhile({t.fDecoder->width, t.fDecoder->height})) {
+        return false;
+    }
+    if(!t.openOutput(dstPath)) return false;
+    while(!mAbort && av_read_frame(t.fInput, t.fPacket) >= 0) {
+        bool ok = true;
+        if(t.fPacket->stream_index == t.fSrcStream->index) {
+            ok = t.decodePacket(t.fPacket, mAbort);
+        }
+        av_packet_unref(t.fPacket);
+        if(!ok) return false;
+    }
+    if(mAbort) return false;
+    if(!t.decodePacket(nullptr, mAbort)) return false;
+    if(t.fNextFrame == 0 || !t.encode(nullptr)) return false;
+    if(av_write_trailer(t.fOutput) < 0) return false;
+    return avio_closep(&t.fOutput->pb) >= 0;
+}
+
+void VideoProxyTranscoder::afterProcessing() {
+    if(mFinished) mFinished(mDone);
+}
+
+void VideoProxyTranscoder::afterCanceled() {
+    if(mFinished) mFinished(false);
+}
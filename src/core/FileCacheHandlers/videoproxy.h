@@ -0,0 +1,87 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef VIDEOPROXY_H
+#define VIDEOPROXY_H
+
+#include <atomic>
+
+#include <QSize>
+#include <QPointer>
+
+#include "Tasks/updatable.h"
+
+class DecoderExecController;
+
+// Reduced resolution, intra-only MJPEG copy of a video file. Previews
+// below full resolution decode it instead of the source, every frame of
+// it decodes on its own and at a fraction of the pixels. Frame n of the
+// proxy is frame n of the source. Kept in the render cache folder, keyed
+// like the seek index of the source, and removed with its least recently
+// used entries. Proxies of changed sources are never used again.
+namespace VideoProxy {
+    //! @brief File the proxy of videoPath is written to
+    CORE_EXPORT
+    QString sPath(const QString& videoPath);
+    //! @brief Size of the proxy frames for source frames of size source
+    CORE_EXPORT
+    QSize sSize(const QSize& source);
+    //! @brief Whether sources of this size get a proxy on import
+    CORE_EXPORT
+    bool sWorthwhile(const QSize& source);
+}
+
+class CORE_EXPORT VideoProxyTranscoder : public eHddTask {
+    e_OBJECT
+public:
+    using FinishedFunc = std::function<void(bool)>;
+
+    //! @brief Stops the transcode at the next frame, from any thread
+    void abort() { mAbort = true; }
+protected:
+    //! @brief With onlyWorthwhile set, small sources get no proxy
+    VideoProxyTranscoder(const QString& videoPath,
+                         DecoderExecController* const decoder,
+                         const bool onlyWorthwhile,
+                         const FinishedFunc& finished) :
+        mVideoPath(videoPath), mDecoder(decoder),
+        mOnlyWorthwhile(onlyWorthwhile), mFinished(finished) {
+        setPriority(eTaskPriority::background);
+    }
+
+    void queTaskNow();
+    void process();
+    void afterProcessing();
+    void afterCanceled();
+private:
+    bool transcode(const QString& dstPath);
+
+    const QString mVideoPath;
+    const QPointer<DecoderExecController> mDecoder;
+    const bool mOnlyWorthwhile;
+    const FinishedFunc mFinished;
+    std::atomic<bool> mAbort{false};
+    bool mDone = false;
+};
+
+#endif // VIDEOPROXY_H
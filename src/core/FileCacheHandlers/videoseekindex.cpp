@@ -0,0 +1,207 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "videoseekindex.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QCryptographicHash>
+
+#include "CacheHandlers/persistentrendercache.h"
+#include "Private/Tasks/taskscheduler.h"
+#include "ReadWrite/ewritestream.h"
+#include "ReadWrite/ereadstream.h"
+extern "C" {
+    #include <libavformat/avformat.h>
+}
+
+static const char* const sMagic = "VSI2";
+
+void VideoSeekIndex::Keyframe::write(eWriteStream& dst) const {
+    dst << static_cast<uint64_t>(fPts);
+    dst << static_cast<uint64_t>(fDts);
+    dst << fFrame;
+}
+
+void VideoSeekIndex::Keyframe::read(eReadStream& src) {
+    uint64_t pts; src >> pts;
+    uint64_t dts; src >> dts;
+    fPts = static_cast<int64_t>(pts);
+    fDts = static_cast<int64_t>(dts);
+    src >> fFrame;
+}
+
+const VideoSeekIndex::Keyframe* VideoSeekIndex::keyframeAtOrBefore(
+        const int frame) const {
+    const auto it = std::upper_bound(
+                mKeyframes.begin(), mKeyframes.end(), frame,
+                [](const int frame, const Keyframe& key) {
+        return frame < key.fFrame;
+    });
+    if(it == mKeyframes.begin()) return nullptr;
+    return &*(it - 1);
+}
+
+const VideoSeekIndex::Keyframe* VideoSeekIndex::keyframeAfter(
+        const int frame) const {
+    const auto it = std::upper_bound(
+                mKeyframes.begin(), mKeyframes.end(), frame,
+                [](const int frame, const Keyframe& key) {
+        return frame < key.fFrame;
+    });
+    if(it == mKeyframes.end()) return nullptr;
+    return &*it;
+}
+
+int VideoSeekIndex::sFrameAt(const int64_t ts, const AVRational& timeBase,
+                             const qreal fps) {
+    const int64_t us = av_rescale_q(ts, timeBase, {1, AV_TIME_BASE});
+    const qreal frameApprox = us/1000000.*fps;
+    const int frameRound = qRound(frameApprox);
+    if(frameRound - frameApprox > 0.4) return frameRound - 1;
+    return frameRound;
+}
+
+QString VideoSeekIndex::sCacheKey(const QString& videoPath) {
+    const QFileInfo info(videoPath);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString VideoSeekIndex::sIndexPath(const QString& videoPath) {
+    const QString name = sCacheKey(videoPath) + ".vsi";
+    return QDir(PersistentRenderCache::sFolder()).filePath(name);
+}
+
+stdsptr<VideoSeekIndex> VideoSeekIndex::sLoad(const QString& videoPath) {
+    QFile file(sIndexPath(videoPath));
+    if(!file.open(QIODevice::ReadOnly)) return nullptr;
+    eReadStream src(&file);
+    char magic[4];
+    if(src.read(magic, 4) != 4 || memcmp(magic, sMagic, 4) != 0) {
+        return nullptr;
+    }
+    const auto result = std::make_shared<VideoSeekIndex>();
+    int count;
+    src >> result->mFrameCount;
+    src >> count;
+    const qint64 keyframeBytes = 2*sizeof(uint64_t) + sizeof(int);
+    if(count <= 0 || file.pos() + count*keyframeBytes > file.size()) {
+        return nullptr;
+    }
+    result->mKeyframes.resize(count);
+    for(auto& keyframe : result->mKeyframes) src >> keyframe;
+    return result;
+}
+
+void VideoSeekIndex::save(const QString& videoPath) const {
+    QSaveFile file(sIndexPath(videoPath));
+    if(!file.open(QIODevice::WriteOnly)) return;
+    {
+        eWriteStream dst(&file);
+        dst.write(sMagic, 4);
+        dst << mFrameCount;
+        dst << mKeyframes.count();
+        for(const auto& keyframe : mKeyframes) dst << keyframe;
+    }
+    file.commit();
+}
+
+stdsptr<VideoSeekIndex> VideoSeekIndex::sBuild(const QString& videoPath) {
+    const auto stdString = videoPath.toStdString();
+    AVFormatContext* formatContext = nullptr;
+    if(avformat_open_input(&formatContext, stdString.c_str(),
+                           nullptr, nullptr) != 0) {
+        return nullptr;
+    }
+    if(avformat_find_stream_info(formatContext, nullptr) < 0) {
+        avformat_close_input(&formatContext);
+        return nullptr;
+    }
+    // same stream VideoStreamsData decodes
+    AVStream* videoStream = nullptr;
+    for(uint i = 0; i < formatContext->nb_streams; i++) {
+        AVStream * const iStream = formatContext->streams[i];
+        if(!videoStream &&
+           iStream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            videoStream = iStream;
+        } else {
+            iStream->discard = AVDISCARD_ALL;
+        }
+    }
+    if(!videoStream || videoStream->avg_frame_rate.den == 0) {
+        avformat_close_input(&formatContext);
+        return nullptr;
+    }
+    const qreal fps = av_q2d(videoStream->avg_frame_rate);
+    const auto result = std::make_shared<VideoSeekIndex>();
+
+    AVPacket* packet = av_packet_alloc();
+    while(packet && av_read_frame(formatContext, packet) >= 0) {
+        if(packet->stream_index == videoStream->index) {
+            const int64_t ts = packet->pts != AV_NOPTS_VALUE ?
+                        packet->pts : packet->dts;
+            if(ts != AV_NOPTS_VALUE) {
+                const int frame = sFrameAt(ts, videoStream->time_base, fps);
+                result->mFrameCount = qMax(result->mFrameCount, frame + 1);
+                auto& keys = result->mKeyframes;
+                const bool key = packet->flags & AV_PKT_FLAG_KEY;
+                // keyframes are mostly in order, timestamps might not be
+                if(key && (keys.isEmpty() || keys.last().fFrame < frame)) {
+                    keys.append({packet->pts, packet->dts, frame});
+                }
+            }
+        }
+        av_packet_unref(packet);
+    }
+
+    if(packet) av_packet_free(&packet);
+    avformat_close_input(&formatContext);
+    if(result->mKeyframes.isEmpty()) return nullptr;
+    return result;
+}
+
+void VideoSeekIndexBuilder::queTaskNow() {
+    const auto scheduler = TaskScheduler::instance();
+    if(mDecoder) scheduler->queDecoderTask(ref<eTask>(), mDecoder);
+    else scheduler->queHddTask(ref<eTask>());
+}
+
+void VideoSeekIndexBuilder::process() {
+    mIndex = VideoSeekIndex::sLoad(mVideoPath);
+    if(mIndex) return;
+    mIndex = VideoSeekIndex::sBuild(mVideoPath);
+    if(mIndex) mIndex->save(mVideoPath);
+}
+
+void VideoSeekIndexBuilder::afterProcessing() {
+    if(mFinished) mFinished(mIndex);
+}
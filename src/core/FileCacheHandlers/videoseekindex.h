@@ -0,0 +1,103 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef VIDEOSEEKINDEX_H
+#define VIDEOSEEKINDEX_H
+
+#include <QVector>
+#include <QPointer>
+
+#include "Tasks/updatable.h"
+
+class DecoderExecController;
+class eWriteStream;
+class eReadStream;
+extern "C" {
+    #include <libavutil/rational.h>
+}
+
+// Keyframe positions of the video stream of a file. Lets the frame
+// loader seek straight to the group of pictures holding a frame instead
+// of guessing the timestamp from the frame rate. Built once per file in
+// the background and stored next to the persistent render cache, keyed
+// by the path, size and modification time of the file.
+class CORE_EXPORT VideoSeekIndex {
+public:
+    struct Keyframe {
+        int64_t fPts;
+        int64_t fDts;
+        int fFrame;
+
+        void write(eWriteStream& dst) const;
+        void read(eReadStream& src);
+    };
+
+    //! @brief Number of frames as numbered by the decoded timestamps
+    int frameCount() const { return mFrameCount; }
+    //! @brief Last keyframe at or before frame, nullptr if there is none
+    const Keyframe* keyframeAtOrBefore(const int frame) const;
+    //! @brief First keyframe after frame, nullptr if there is none
+    const Keyframe* keyframeAfter(const int frame) const;
+
+    //! @brief Frame number of timestamp ts, same rounding as the loader uses
+    static int sFrameAt(const int64_t ts, const AVRational& timeBase,
+                        const qreal fps);
+
+    //! @brief Names files derived from videoPath in the render cache folder
+    static QString sCacheKey(const QString& videoPath);
+
+    static stdsptr<VideoSeekIndex> sLoad(const QString& videoPath);
+    static stdsptr<VideoSeekIndex> sBuild(const QString& videoPath);
+    void save(const QString& videoPath) const;
+private:
+    static QString sIndexPath(const QString& videoPath);
+
+    int mFrameCount = 0;
+    QVector<Keyframe> mKeyframes;
+};
+
+// Reads every packet of the file, so it runs on the decoder thread of the
+// source (or on the hdd thread without one) rather than on a render worker.
+class CORE_EXPORT VideoSeekIndexBuilder : public eHddTask {
+    e_OBJECT
+public:
+    using FinishedFunc = std::function<void(const stdsptr<VideoSeekIndex>&)>;
+protected:
+    VideoSeekIndexBuilder(const QString& videoPath,
+                          DecoderExecController* const decoder,
+                          const FinishedFunc& finished) :
+        mVideoPath(videoPath), mDecoder(decoder), mFinished(finished) {
+        setPriority(eTaskPriority::cacheMaintenance);
+    }
+
+    void queTaskNow();
+    void process();
+    void afterProcessing();
+private:
+    const QString mVideoPath;
+    const QPointer<DecoderExecController> mDecoder;
+    const FinishedFunc mFinished;
+    stdsptr<VideoSeekIndex> mIndex;
+};
+
+#endif // VIDEOSEEKINDEX_H
@@ -138,6 +138,7 @@ void VideoStreamsData::open(const char * const path)
     if (maxThreads > 0) {
         fCodecContext->thread_count = maxThreads > 16 ? 16 : maxThreads;
     }
+    fCodecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
     if (avcodec_parameters_to_context(fCodecContext,
                                       vidCodecPars) < 0) {
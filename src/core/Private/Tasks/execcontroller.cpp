@@ -58,8 +58,9 @@ void ExecController::finishedTask(const stdsptr<eTask>& task) {
     emit finishedTaskSignal(task, this);
 }
 
-CpuExecController::CpuExecController(QObject* const parent) :
-    ExecController(new CpuTaskExecutor, parent) {
+CpuExecController::CpuExecController(const int queId,
+                                     QObject* const parent) :
+    ExecController(new CpuTaskExecutor(queId), parent) {
     start();
 }
 
@@ -87,3 +88,27 @@ HddExecController::HddExecController(QObject* const parent) :
     ExecController(new HddTaskExecutor, parent) {
     start();
 }
+
+DecoderExecController::DecoderExecController(const QString& name,
+                                             QObject* const parent) :
+    ExecController(new DecoderTaskExecutor(name), parent) {
+    start();
+}
+
+DecoderExecController::~DecoderExecController() {
+    stopAndWait();
+    delete mExecutor;
+}
+
+void DecoderExecController::addTask(const stdsptr<eTask>& task) {
+    static_cast<DecoderTaskExecutor*>(mExecutor)->addTask(task);
+}
+
+void DecoderExecController::stopAndCancel() {
+    const auto decoderExec = static_cast<DecoderTaskExecutor*>(mExecutor);
+    const auto tasks = decoderExec->stopAndTakeWaiting();
+    mThread->quit();
+    mThread->wait();
+    // never processed, so they are not reported as finished
+    for(const auto& task : tasks) task->cancelUnprocessed();
+}
@@ -36,6 +36,8 @@ protected:
 public:
     void stop();
     void stopAndWait();
+
+    ExecutorMetrics metrics() const { return mExecutor->metrics(); }
 signals:
     void processTaskSignal(const stdsptr<eTask>&);
     void finishedTaskSignal(const stdsptr<eTask>&, ExecController*);
@@ -50,7 +52,8 @@ private:
 
 class CORE_EXPORT CpuExecController : public ExecController {
 public:
-    CpuExecController(QObject * const parent = nullptr);
+    CpuExecController(const int queId,
+                      QObject * const parent = nullptr);
 };
 
 class CORE_EXPORT GpuExecController : public ExecController {
@@ -65,4 +68,17 @@ public:
     HddExecController(QObject * const parent = nullptr);
 };
 
+class CORE_EXPORT DecoderExecController : public ExecController {
+public:
+    DecoderExecController(const QString& name,
+                          QObject * const parent = nullptr);
+    ~DecoderExecController();
+
+    void addTask(const stdsptr<eTask>& task);
+    //! @brief Stops the thread and cancels the tasks it did not get to,
+    //! only tasks that were processed are reported as finished
+    //! (if they finished before a deleteLater() call).
+    void stopAndCancel();
+};
+
 #endif // EXECCONTROLLER_H
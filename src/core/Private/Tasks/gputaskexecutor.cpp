@@ -34,11 +34,11 @@ GpuTaskExecutor::GpuTaskExecutor() :
     TaskExecutor(sUseCount, sTasks) {}
 
 void GpuTaskExecutor::sAddTask(const stdsptr<eTask>& ready) {
-    sTasks.appendAndNotifyAll(ready);
+    sAddTasks({ready});
 }
 
 void GpuTaskExecutor::sAddTasks(const QList<stdsptr<eTask>>& ready) {
-    sTasks.appendAndNotifyAll(ready);
+    sTasks.insertSortedAndNotifyAll(ready, &eTask::sHigherPriority);
 }
 
 int GpuTaskExecutor::sUsageCount() {
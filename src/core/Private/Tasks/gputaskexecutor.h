@@ -45,6 +45,7 @@ public:
     std::exception_ptr handleException();
 private:
     void processTask(eTask& task);
+    QString traceThreadName() const { return "GPU"; }
     void start();
 
     void setException(const std::exception_ptr& exception);
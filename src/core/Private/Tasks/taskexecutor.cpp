@@ -24,22 +24,83 @@
 // Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
 
 #include "taskexecutor.h"
+#include "tasktracer.h"
 
 QAtomicInt TaskExecutor::sTaskFinishSignals = 0;
 
+static qint64 steadyNs() {
+    using namespace std::chrono;
+    const auto now = steady_clock::now().time_since_epoch();
+    return duration_cast<nanoseconds>(now).count();
+}
+
+ExecutorMetrics TaskExecutor::metrics() const {
+    ExecutorMetrics result;
+    const qint64 startNs = mStartNs;
+    if(startNs == 0) return result;
+    const qint64 nowNs = steadyNs();
+    // the task being processed counts as busy time already
+    const qint64 taskStartNs = mTaskStartNs;
+    const qint64 runningNs = taskStartNs == 0 ? 0 : nowNs - taskStartNs;
+    const qint64 totalNs = nowNs - startNs;
+    const qint64 busyNs = qMin(totalNs, mBusyNs + runningNs);
+    result.fBusyMs = busyNs/1000000;
+    result.fIdleMs = qMax(qint64(0), totalNs - busyNs)/1000000;
+    result.fProcessedTasks = mProcessedTasks;
+    return result;
+}
+
+bool TaskExecutor::takeTask(stdsptr<eTask>& task) {
+    return mTasks.waitTakeFirst(task, mStop);
+}
+
 void TaskExecutor::processTask(eTask& task) {
     task.process();
 }
 
+std::atomic<bool> CpuTaskExecutor::sWorkStealingEnabled{false};
 QAtomicList<stdsptr<eTask>> CpuTaskExecutor::sTasks;
+WorkStealingQue<stdsptr<eTask>> CpuTaskExecutor::sStealingTasks;
 QAtomicInt CpuTaskExecutor::sUseCount = 0;
 
+void CpuTaskExecutor::sSetupQues(const int nExecutors) {
+    sStealingTasks.setup(nExecutors);
+}
+
+void CpuTaskExecutor::sSetWorkStealing(const bool workStealing) {
+    if(sWorkStealingEnabled.exchange(workStealing) == workStealing) return;
+    if(workStealing) {
+        sStealingTasks.appendAndNotifyAll(sTasks.takeAll());
+        sTasks.notifyAll();
+    } else {
+        sTasks.insertSortedAndNotifyAll(sStealingTasks.takeAll(),
+                                        &eTask::sHigherPriority);
+        sStealingTasks.notifyAll();
+    }
+}
+
+bool CpuTaskExecutor::sWorkStealing() {
+    return sWorkStealingEnabled;
+}
+
 void CpuTaskExecutor::sAddTask(const stdsptr<eTask>& ready) {
-    sTasks.appendAndNotifyAll(ready);
+    sAddTasks({ready});
 }
 
 void CpuTaskExecutor::sAddTasks(const QList<stdsptr<eTask>>& ready) {
-    sTasks.appendAndNotifyAll(ready);
+    if(sWorkStealingEnabled) {
+        QList<stdsptr<eTask>> interactive;
+        QList<stdsptr<eTask>> other;
+        for(const auto& task : ready) {
+            if(task->priority() == eTaskPriority::interactive) {
+                interactive << task;
+            } else other << task;
+        }
+        sStealingTasks.prependAndNotifyAll(interactive);
+        sStealingTasks.appendAndNotifyAll(other);
+    } else {
+        sTasks.insertSortedAndNotifyAll(ready, &eTask::sHigherPriority);
+    }
 }
 
 int CpuTaskExecutor::sUsageCount() {
@@ -47,7 +108,17 @@ int CpuTaskExecutor::sUsageCount() {
 }
 
 int CpuTaskExecutor::sWaitingTasks() {
-    return sTasks.count();
+    return sTasks.count() + sStealingTasks.count();
+}
+
+bool CpuTaskExecutor::takeTask(stdsptr<eTask>& task) {
+    // short timeouts let the executor follow a runtime mode switch
+    while(!stopRequested()) {
+        if(sWorkStealingEnabled) {
+            if(sStealingTasks.waitTake(mQueId, task, 100ms)) return true;
+        } else if(sTasks.waitTakeFirstFor(task, 100ms)) return true;
+    }
+    return false;
 }
 
 void TaskExecutor::start() {
@@ -59,16 +130,22 @@ void TaskExecutor::stop() {
 }
 
 void TaskExecutor::processLoop() {
-    mStop = false;
+    if(mStartNs == 0) mStartNs = steadyNs();
+    TaskTracer::sSetThreadName(traceThreadName());
     while(!mStop) {
         stdsptr<eTask> task;
-        if(!mTasks.waitTakeFirst(task, mStop)) break;
+        if(!takeTask(task)) break;
+        const qint64 taskStartNs = steadyNs();
+        mTaskStartNs = taskStartNs;
         mUseCount++;
+        const qint64 traceStartUs = TaskTracer::sNowUs();
         try {
             processTask(*task);
         } catch(...) {
             task->setException(std::current_exception());
         }
+        task->addProcessingNs(steadyNs() - taskStartNs);
+        TaskTracer::sComplete(*task, "process", traceStartUs);
 
         const bool nextStep = !task->waitingToCancel() &&
                               task->nextStep();
@@ -77,18 +154,25 @@ void TaskExecutor::processLoop() {
             emit finishedTask(task);
         }
         mUseCount--;
+        const qint64 taskEndNs = steadyNs();
+        mTaskStartNs = 0;
+        mBusyNs += taskEndNs - taskStartNs;
+        mProcessedTasks++;
     }
+    // the loop only ends on stop, whose quit is lost
+    // if it came before the thread started its event loop
+    QThread::currentThread()->quit();
 }
 
 QAtomicList<stdsptr<eTask>> HddTaskExecutor::sTasks;
 QAtomicInt HddTaskExecutor::sUseCount = 0;
 
 void HddTaskExecutor::sAddTask(const stdsptr<eTask>& ready) {
-    sTasks.appendAndNotifyAll(ready);
+    sAddTasks({ready});
 }
 
 void HddTaskExecutor::sAddTasks(const QList<stdsptr<eTask>>& ready) {
-    sTasks.appendAndNotifyAll(ready);
+    sTasks.insertSortedAndNotifyAll(ready, &eTask::sHigherPriority);
 }
 
 int HddTaskExecutor::sUsageCount() {
@@ -98,3 +182,33 @@ int HddTaskExecutor::sUsageCount() {
 int HddTaskExecutor::sWaitingTasks() {
     return sTasks.count();
 }
+
+QAtomicInt DecoderTaskExecutor::sUseCount = 0;
+QAtomicInt DecoderTaskExecutor::sWaiting = 0;
+
+void DecoderTaskExecutor::addTask(const stdsptr<eTask>& ready) {
+    sWaiting++;
+    mTasks.insertSortedAndNotifyAll({ready}, &eTask::sHigherPriority);
+}
+
+void DecoderTaskExecutor::processTask(eTask& task) {
+    sWaiting--;
+    task.process();
+}
+
+QList<stdsptr<eTask>> DecoderTaskExecutor::stopAndTakeWaiting() {
+    stop();
+    const auto tasks = mTasks.takeAll();
+    sWaiting -= tasks.count();
+    // wakes the thread waiting for tasks
+    mTasks.notifyAll();
+    return tasks;
+}
+
+int DecoderTaskExecutor::sUsageCount() {
+    return sUseCount;
+}
+
+int DecoderTaskExecutor::sWaitingTasks() {
+    return sWaiting;
+}
@@ -27,9 +27,17 @@
 #define TASKEXECUTOR_H
 
 #include <QThread>
+#include <chrono>
 
 #include "Tasks/updatable.h"
 #include "../qatomiclist.h"
+#include "../workstealingque.h"
+
+struct CORE_EXPORT ExecutorMetrics {
+    qint64 fBusyMs = 0;
+    qint64 fIdleMs = 0;
+    int fProcessedTasks = 0;
+};
 
 class CORE_EXPORT TaskExecutor : public QObject {
     Q_OBJECT
@@ -42,14 +50,25 @@ public:
 
     virtual void start();
     void stop();
+
+    ExecutorMetrics metrics() const;
 signals:
     void finishedTask(const stdsptr<eTask>&);
 protected:
     void processLoop();
+
+    bool stopRequested() const { return mStop; }
 private:
+    virtual bool takeTask(stdsptr<eTask>& task);
     virtual void processTask(eTask& task);
+    virtual QString traceThreadName() const = 0;
+
+    std::atomic<bool> mStop{false};
 
-    std::atomic<bool> mStop;
+    std::atomic<qint64> mStartNs{0};
+    std::atomic<qint64> mBusyNs{0};
+    std::atomic<qint64> mTaskStartNs{0}; // 0 - no task being processed
+    std::atomic<int> mProcessedTasks{0};
 
     QAtomicInt& mUseCount;
     QAtomicList<stdsptr<eTask>>& mTasks;
@@ -57,15 +76,28 @@ private:
 
 class CORE_EXPORT CpuTaskExecutor : public TaskExecutor {
 public:
-    CpuTaskExecutor() : TaskExecutor(sUseCount, sTasks) {}
+    CpuTaskExecutor(const int queId) :
+        TaskExecutor(sUseCount, sTasks), mQueId(queId) {}
+
+    static void sSetupQues(const int nExecutors);
+    static void sSetWorkStealing(const bool workStealing);
+    static bool sWorkStealing();
 
     static void sAddTask(const stdsptr<eTask>& ready);
     static void sAddTasks(const QList<stdsptr<eTask>>& ready);
     static int sUsageCount();
     static int sWaitingTasks();
 private:
+    bool takeTask(stdsptr<eTask>& task);
+    QString traceThreadName() const
+    { return QString("CPU %1").arg(mQueId + 1); }
+
+    const int mQueId;
+
+    static std::atomic<bool> sWorkStealingEnabled;
     static QAtomicInt sUseCount;
     static QAtomicList<stdsptr<eTask>> sTasks;
+    static WorkStealingQue<stdsptr<eTask>> sStealingTasks;
 };
 
 class CORE_EXPORT HddTaskExecutor : public TaskExecutor {
@@ -77,8 +109,36 @@ public:
     static int sUsageCount();
     static int sWaitingTasks();
 private:
+    QString traceThreadName() const { return "HDD"; }
+
     static QAtomicInt sUseCount;
     static QAtomicList<stdsptr<eTask>> sTasks;
 };
 
+// Processes the tasks of a single media source on its own thread,
+// so decoding one source does not wait for other sources or the hdd que.
+class CORE_EXPORT DecoderTaskExecutor : public TaskExecutor {
+public:
+    DecoderTaskExecutor(const QString& name) :
+        TaskExecutor(sUseCount, mTasks), mName(name) {}
+
+    void addTask(const stdsptr<eTask>& ready);
+    //! @brief Stops after the current task,
+    //! returns the tasks that were not taken for processing yet.
+    QList<stdsptr<eTask>> stopAndTakeWaiting();
+
+    static int sUsageCount();
+    //! @brief Tasks waiting in all decoder threads
+    static int sWaitingTasks();
+private:
+    void processTask(eTask& task);
+    QString traceThreadName() const { return "Decoder " + mName; }
+
+    const QString mName;
+    QAtomicList<stdsptr<eTask>> mTasks;
+
+    static QAtomicInt sUseCount;
+    static QAtomicInt sWaiting;
+};
+
 #endif // TASKEXECUTOR_H
@@ -25,6 +25,7 @@
 
 #include "taskque.h"
 #include "Private/esettings.h"
+#include "taskscheduler.h"
 
 TaskQue::TaskQue() {}
 
@@ -40,9 +41,20 @@ int TaskQue::countQued() const {
            mGpuPreffered.count() + mGpuOnly.count();
 }
 
+void TaskQue::addCounts(TaskQueCounts& counts) const {
+    counts.fGpuOnly += mGpuOnly.count();
+    counts.fGpuPreffered += mGpuPreffered.count();
+    counts.fCpuPreffered += mCpuPreffered.count();
+    counts.fCpuOnly += mCpuOnly.count();
+}
+
 bool TaskQue::allDone() const { return countQued() == 0; }
 
 void TaskQue::addTask(const stdsptr<eTask> &task) {
+    if(!TaskScheduler::sGpuAvailable()) {
+        mCpuOnly << task;
+        return;
+    }
     const auto hwSupport = task->hardwareSupport();
     switch(eSettings::sInstance->fAccPreference) {
         case AccPreference::gpuStrongPreference:
@@ -121,40 +133,33 @@ void TaskQue::addTask(const stdsptr<eTask> &task) {
     }
 }
 
-stdsptr<eTask> TaskQue::takeQuedForCpuProcessing() {
-    for(int i = 0; i < mCpuOnly.count(); i++) {
-        const auto& task = mCpuOnly.at(i);
-        if(task->readyToBeProcessed())
-            return mCpuOnly.takeAt(i);
-    }
-    for(int i = 0; i < mCpuPreffered.count(); i++) {
-        const auto& task = mCpuPreffered.at(i);
-        if(task->readyToBeProcessed())
-            return mCpuPreffered.takeAt(i);
-    }
-    for(int i = 0; i < mGpuPreffered.count(); i++) {
-        const auto& task = mGpuPreffered.at(i);
-        if(task->readyToBeProcessed())
-            return mGpuPreffered.takeAt(i);
+stdsptr<eTask> TaskQue::sTakeReady(QList<stdsptr<eTask>>& list,
+                                   const eTaskPriority priority) {
+    // prefer the task gating the longest chain of dependent tasks
+    int bestId = -1;
+    qreal bestCost = 0;
+    for(int i = 0; i < list.count(); i++) {
+        const auto& task = list.at(i);
+        if(task->priority() != priority) continue;
+        if(!task->readyToBeProcessed()) continue;
+        const qreal cost = task->criticalPathCost();
+        if(bestId == -1 || cost > bestCost) {
+            bestId = i;
+            bestCost = cost;
+        }
     }
-    return nullptr;
+    if(bestId == -1) return nullptr;
+    return list.takeAt(bestId);
 }
 
-stdsptr<eTask> TaskQue::takeQuedForGpuProcessing() {
-    for(int i = 0; i < mGpuOnly.count(); i++) {
-        const auto& task = mGpuOnly.at(i);
-        if(task->readyToBeProcessed())
-            return mGpuOnly.takeAt(i);
-    }
-    for(int i = 0; i < mGpuPreffered.count(); i++) {
-        const auto& task = mGpuPreffered.at(i);
-        if(task->readyToBeProcessed())
-            return mGpuPreffered.takeAt(i);
-    }
-    for(int i = 0; i < mCpuPreffered.count(); i++) {
-        const auto& task = mCpuPreffered.at(i);
-        if(task->readyToBeProcessed())
-            return mCpuPreffered.takeAt(i);
-    }
-    return nullptr;
+stdsptr<eTask> TaskQue::takeQuedForCpuProcessing(const eTaskPriority priority) {
+    if(const auto task = sTakeReady(mCpuOnly, priority)) return task;
+    if(const auto task = sTakeReady(mCpuPreffered, priority)) return task;
+    return sTakeReady(mGpuPreffered, priority);
+}
+
+stdsptr<eTask> TaskQue::takeQuedForGpuProcessing(const eTaskPriority priority) {
+    if(const auto task = sTakeReady(mGpuOnly, priority)) return task;
+    if(const auto task = sTakeReady(mGpuPreffered, priority)) return task;
+    return sTakeReady(mCpuPreffered, priority);
 }
@@ -27,6 +27,13 @@
 #define TASKQUE_H
 #include "Tasks/updatable.h"
 
+struct CORE_EXPORT TaskQueCounts {
+    int fGpuOnly = 0;
+    int fGpuPreffered = 0;
+    int fCpuPreffered = 0;
+    int fCpuOnly = 0;
+};
+
 class CORE_EXPORT TaskQue {
     friend class TaskQueHandler;
 public:
@@ -37,12 +44,16 @@ public:
     ~TaskQue();
 protected:
     int countQued() const;
+    void addCounts(TaskQueCounts& counts) const;
     bool allDone() const;
     void addTask(const stdsptr<eTask>& task);
 
-    stdsptr<eTask> takeQuedForCpuProcessing();
-    stdsptr<eTask> takeQuedForGpuProcessing();
+    stdsptr<eTask> takeQuedForCpuProcessing(const eTaskPriority priority);
+    stdsptr<eTask> takeQuedForGpuProcessing(const eTaskPriority priority);
 private:
+    static stdsptr<eTask> sTakeReady(QList<stdsptr<eTask>>& list,
+                                     const eTaskPriority priority);
+
     QList<stdsptr<eTask>> mGpuOnly;
     QList<stdsptr<eTask>> mGpuPreffered;
     QList<stdsptr<eTask>> mCpuPreffered;
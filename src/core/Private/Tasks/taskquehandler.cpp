@@ -29,6 +29,12 @@ int TaskQueHandler::countQues() const { return mQues.count(); }
 
 bool TaskQueHandler::isEmpty() const { return mQues.isEmpty(); }
 
+TaskQueCounts TaskQueHandler::counts() const {
+    TaskQueCounts result;
+    for(const auto& que : mQues) que->addCounts(result);
+    return result;
+}
+
 void TaskQueHandler::clear() {
     mQues.clear();
     mCurrentQue = nullptr;
@@ -36,29 +42,28 @@ void TaskQueHandler::clear() {
 }
 
 stdsptr<eTask> TaskQueHandler::takeQuedForGpuProcessing() {
-    int queId = 0;
-    for(const auto& que : mQues) {
-        const auto task = que->takeQuedForGpuProcessing();
-        if(task) {
-            if(que->allDone()) queDone(que.get(), queId);
-            mTaskCount--;
-            return task;
-        }
-        queId++;
-    }
-    return nullptr;
+    return takeQued(&TaskQue::takeQuedForGpuProcessing);
 }
 
 stdsptr<eTask> TaskQueHandler::takeQuedForCpuProcessing() {
-    int queId = 0;
-    for(const auto& que : mQues) {
-        const auto task = que->takeQuedForCpuProcessing();
-        if(task) {
-            if(que->allDone()) queDone(que.get(), queId);
-            mTaskCount--;
-            return task;
+    return takeQued(&TaskQue::takeQuedForCpuProcessing);
+}
+
+stdsptr<eTask> TaskQueHandler::takeQued(const TakeFunc& takeFunc) {
+    const auto first = static_cast<int>(eTaskPriority::interactive);
+    const auto last = static_cast<int>(eTaskPriority::background);
+    for(int p = first; p <= last; p++) {
+        const auto priority = static_cast<eTaskPriority>(p);
+        int queId = 0;
+        for(const auto& que : mQues) {
+            const auto task = (que.get()->*takeFunc)(priority);
+            if(task) {
+                if(que->allDone()) queDone(que.get(), queId);
+                mTaskCount--;
+                return task;
+            }
+            queId++;
         }
-        queId++;
     }
     return nullptr;
 }
@@ -44,7 +44,11 @@ public:
     void endQue();
 
     int taskCount() const { return mTaskCount; }
+    TaskQueCounts counts() const;
 private:
+    using TakeFunc = stdsptr<eTask>(TaskQue::*)(const eTaskPriority);
+    stdsptr<eTask> takeQued(const TakeFunc& takeFunc);
+
     void queDone(const TaskQue * const que, const int queId);
 
     int mTaskCount = 0;
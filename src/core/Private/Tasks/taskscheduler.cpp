@@ -30,6 +30,7 @@
 #include "gputaskexecutor.h"
 #include "taskexecutor.h"
 #include "complextask.h"
+#include "tasktracer.h"
 #include "Private/document.h"
 #include "Boxes/boxrenderdata.h"
 
@@ -40,8 +41,13 @@ TaskScheduler::TaskScheduler() {
     sInstance = this;
     qRegisterMetaType<stdsptr<eTask>>();
     const int numberThreads = qMax(1, QThread::idealThreadCount());
+    CpuTaskExecutor::sSetupQues(numberThreads);
+    CpuTaskExecutor::sSetWorkStealing(eSettings::sInstance->fCpuWorkStealing);
+    connect(eSettings::sInstance, &eSettings::settingsChanged, this, [] {
+        CpuTaskExecutor::sSetWorkStealing(eSettings::sInstance->fCpuWorkStealing);
+    });
     for(int i = 0; i < numberThreads; i++) {
-        const auto taskExecutor = std::make_shared<CpuExecController>(this);
+        const auto taskExecutor = std::make_shared<CpuExecController>(i, this);
         connect(taskExecutor.get(), &ExecController::finishedTaskSignal,
                 this, &TaskScheduler::afterCpuGpuTaskFinished);
 
@@ -86,6 +92,10 @@ bool TaskScheduler::sAllQuedCpuTasksFinished() {
     return sInstance->allQuedCpuTasksFinished();
 }
 
+bool TaskScheduler::sGpuAvailable() {
+    return sInstance && sInstance->mGpuAvailable;
+}
+
 void TaskScheduler::sClearTasks() {
     sInstance->clearTasks();
 }
@@ -93,17 +103,40 @@ void TaskScheduler::sClearTasks() {
 void TaskScheduler::initializeGpu() {
     try {
         mGpuExec->initialize();
+        mGpuAvailable = true;
     } catch(...) {
         RuntimeThrow("Failed to initialize GPU execution controller.");
     }
 }
 
 void TaskScheduler::queHddTask(const stdsptr<eTask>& task) {
+    task->setDefaultPriority(mQuePriority);
     mQuedHddTasks << task;
     processNextQuedHddTask();
 }
 
+void TaskScheduler::queDecoderTask(const stdsptr<eTask>& task,
+                                   DecoderExecController* const decoder) {
+    task->setDefaultPriority(mQuePriority);
+    mQuedDecoderTasks.append({task, decoder});
+    processNextQuedDecoderTasks();
+}
+
+stdsptr<DecoderExecController> TaskScheduler::createDecoder(
+        const QString& name) {
+    const auto decoder = new DecoderExecController(name);
+    connect(decoder, &ExecController::finishedTaskSignal,
+            this, &TaskScheduler::afterDecoderTaskFinished);
+    // finished tasks queued before the release are still delivered
+    return stdsptr<DecoderExecController>(
+                decoder, [](DecoderExecController* const released) {
+        released->stopAndCancel();
+        released->deleteLater();
+    });
+}
+
 void TaskScheduler::queCpuTask(const stdsptr<eTask>& task) {
+    task->setDefaultPriority(mQuePriority);
     mQuedCGTasks.addTask(task);
     if(task->readyToBeProcessed()) {
         if(task->hardwareSupport() == HardwareSupport::cpuOnly ||
@@ -120,12 +153,17 @@ void TaskScheduler::clearTasks() {
         hddTask->cancel();
     mQuedHddTasks.clear();
 
+    for(const auto& decoderTask : mQuedDecoderTasks)
+        decoderTask.first->cancel();
+    mQuedDecoderTasks.clear();
+
     callAllTasksFinishedFunc();
 }
 
 bool TaskScheduler::overflowed() const {
     const int nQues = mQuedCGTasks.countQues();
-    const int maxQues = mAlwaysQue ? mCpuExecs.count() : 1;
+    const int maxQues = mMaxQues > 0 ? mMaxQues :
+                        (mAlwaysQue ? mCpuExecs.count() : 1);
     return nQues >= maxQues;
 }
 
@@ -150,10 +188,14 @@ bool TaskScheduler::shouldQueMoreHddTasks() const {
 void TaskScheduler::queTasks() {
     queScheduledCpuTasks();
     processNextQuedHddTask();
+    processNextQuedDecoderTasks();
 }
 
 void TaskScheduler::queScheduledCpuTasks() {
-    if(!mAlwaysQue && !shouldQueMoreCpuTasks()) return;
+    if(!mAlwaysQue && !shouldQueMoreCpuTasks()) {
+        if(overflowed()) mOverflowStalls++;
+        return;
+    }
     mCpuQueing = true;
     mQuedCGTasks.beginQue();
     for(const auto& it : Document::sInstance->fVisibleScenes) {
@@ -168,7 +210,9 @@ void TaskScheduler::queScheduledCpuTasks() {
 
 void TaskScheduler::afterHddTaskFinished(const stdsptr<eTask>& finishedTask) {
     TaskExecutor::sTaskFinishSignals--;
+    const qint64 traceStartUs = TaskTracer::sNowUs();
     finishedTask->finishedProcessing();
+    TaskTracer::sComplete(*finishedTask, "afterProcessing", traceStartUs);
     processNextTasks();
     if(!hddTaskBeingProcessed()) queTasks();
     callAllTasksFinishedFunc();
@@ -192,19 +236,58 @@ void TaskScheduler::processNextQuedHddTask() {
     emit hddUsageChanged(busyHddThreads());
 }
 
+void TaskScheduler::afterDecoderTaskFinished(const stdsptr<eTask>& task) {
+    TaskExecutor::sTaskFinishSignals--;
+    const qint64 traceStartUs = TaskTracer::sNowUs();
+    task->finishedProcessing();
+    TaskTracer::sComplete(*task, "afterProcessing", traceStartUs);
+    processNextTasks();
+    if(DecoderTaskExecutor::sUsageCount() == 0) queTasks();
+    callAllTasksFinishedFunc();
+}
+
+void TaskScheduler::processNextQuedDecoderTasks() {
+    bool finished = false;
+    for(int i = 0; i < mQuedDecoderTasks.count(); i++) {
+        const auto quedTask = mQuedDecoderTasks.at(i);
+        const auto& task = quedTask.first;
+        const auto& decoder = quedTask.second;
+        if(!decoder) {
+            mQuedDecoderTasks.removeAt(i--);
+            task->cancel();
+            continue;
+        }
+        if(!task->readyToBeProcessed()) continue;
+        task->aboutToProcess(Hardware::hdd);
+        mQuedDecoderTasks.removeAt(i--);
+        if(task->getState() > eTaskState::processing) {
+            finished = true;
+            continue;
+        }
+        decoder->addTask(task);
+    }
+    if(finished) processNextTasks();
+}
+
 void TaskScheduler::processNextTasks() {
     if(mCriticalMemoryState) return;
     processNextQuedHddTask();
+    processNextQuedDecoderTasks();
     processNextQuedGpuTask();
     processNextQuedCpuTask();
     if(mTaskUnderflowFunc) {
         if(shouldQueMoreCpuTasks() || shouldQueMoreHddTasks()) {
             mTaskUnderflowFunc();
+        } else if(overflowed()) {
+            mOverflowStalls++;
+        } else if(!mCpuQueing && hddBottleneck()) {
+            mHddStalls++;
         }
     }
 }
 
 bool TaskScheduler::processNextQuedGpuTask() {
+    eTaskBase::sInvalidateCriticalPaths();
     bool finished = false;
     QList<stdsptr<eTask>> tasks;
     const int count = 3 - GpuTaskExecutor::sWaitingTasks();
@@ -227,7 +310,9 @@ bool TaskScheduler::processNextQuedGpuTask() {
 
 void TaskScheduler::afterCpuGpuTaskFinished(const stdsptr<eTask>& task) {
     TaskExecutor::sTaskFinishSignals--;
+    const qint64 traceStartUs = TaskTracer::sNowUs();
     task->finishedProcessing();
+    TaskTracer::sComplete(*task, "afterProcessing", traceStartUs);
     processNextTasks();
     if(!cpuTasksBeingProcessed()) queTasks();
     callAllTasksFinishedFunc();
@@ -244,6 +329,7 @@ void TaskScheduler::setAllTasksFinishedFunc(const Func& func) {
 bool TaskScheduler::allQuedTasksFinished() const {
     return allQuedCpuTasksFinished() &&
            allQuedHddTasksFinished() &&
+           allQuedDecoderTasksFinished() &&
            allQuedGpuTasksFinished() &&
            TaskExecutor::sTaskFinishSignals == 0;
 }
@@ -260,10 +346,23 @@ bool TaskScheduler::allQuedHddTasksFinished() const {
     return mQuedHddTasks.isEmpty() && !hddTaskBeingProcessed();
 }
 
+bool TaskScheduler::allQuedDecoderTasksFinished() const {
+    return mQuedDecoderTasks.isEmpty() &&
+           DecoderTaskExecutor::sUsageCount() == 0 &&
+           DecoderTaskExecutor::sWaitingTasks() == 0;
+}
+
 bool TaskScheduler::cpuTasksBeingProcessed() const {
     return busyCpuThreads() > 0;
 }
 
+bool TaskScheduler::hddBottleneck() const {
+    const bool hddWork = !mQuedHddTasks.isEmpty() ||
+                         HddTaskExecutor::sWaitingTasks() > 0 ||
+                         hddTaskBeingProcessed();
+    return hddWork && CpuTaskExecutor::sUsageCount() == 0;
+}
+
 bool TaskScheduler::hddTaskBeingProcessed() const {
     return busyHddThreads() > 0;
 }
@@ -287,6 +386,14 @@ void TaskScheduler::setAlwaysQue(const bool alwaysQue) {
     mAlwaysQue = alwaysQue;
 }
 
+void TaskScheduler::setMaxQues(const int maxQues) {
+    mMaxQues = maxQues;
+}
+
+void TaskScheduler::setQuePriority(const eTaskPriority priority) {
+    mQuePriority = priority;
+}
+
 void TaskScheduler::addComplexTask(const qsptr<ComplexTask> &task) {
     if(task->done()) return;
     mComplexTasks << task;
@@ -302,15 +409,45 @@ void TaskScheduler::addComplexTask(const qsptr<ComplexTask> &task) {
 void TaskScheduler::enterCriticalMemoryState() {
     if(mCriticalMemoryState) return;
     mCriticalMemoryState = true;
+    mCriticalMemoryTimer.start();
 }
 
 void TaskScheduler::finishCriticalMemoryState() {
     if(!mCriticalMemoryState) return;
     mCriticalMemoryState = false;
+    mCriticalMemoryMs += mCriticalMemoryTimer.elapsed();
     queTasks();
     processNextTasks();
 }
 
+TaskSchedulerMetrics TaskScheduler::metrics() const {
+    TaskSchedulerMetrics result;
+    for(const auto& exec : mCpuExecs) {
+        result.fCpuExecutors << exec->metrics();
+    }
+    result.fGpuExecutor = mGpuExec->metrics();
+    result.fHddExecutor = mHddExec->metrics();
+
+    result.fQued = mQuedCGTasks.counts();
+    result.fQuedHdd = mQuedHddTasks.count();
+    result.fQuedDecoder = mQuedDecoderTasks.count();
+
+    result.fWaitingCpu = CpuTaskExecutor::sWaitingTasks();
+    result.fWaitingGpu = GpuTaskExecutor::sWaitingTasks();
+    result.fWaitingHdd = HddTaskExecutor::sWaitingTasks();
+    result.fWaitingDecoder = DecoderTaskExecutor::sWaitingTasks();
+
+    result.fOverflowStalls = mOverflowStalls;
+    result.fHddStalls = mHddStalls;
+
+    result.fCriticalMemoryState = mCriticalMemoryState;
+    result.fCriticalMemoryMs = mCriticalMemoryMs;
+    if(mCriticalMemoryState) {
+        result.fCriticalMemoryMs += mCriticalMemoryTimer.elapsed();
+    }
+    return result;
+}
+
 void TaskScheduler::waitTillFinished() {
     if(allQuedTasksFinished()) return;
     QEventLoop loop;
@@ -320,6 +457,7 @@ void TaskScheduler::waitTillFinished() {
 }
 
 void TaskScheduler::processNextQuedCpuTask() {
+    eTaskBase::sInvalidateCriticalPaths();
     bool finished = false;
     QList<stdsptr<eTask>> tasks;
     const int count = 3*mCpuExecs.count() - CpuTaskExecutor::sWaitingTasks();
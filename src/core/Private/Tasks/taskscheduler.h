@@ -27,17 +27,44 @@
 #define TASKSCHEDULER_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QPointer>
 
 #include "Tasks/etask.h"
 #include "taskquehandler.h"
+#include "taskexecutor.h"
 #include "Private/esettings.h"
 
 class Canvas;
 class CpuExecController;
 class HddExecController;
+class DecoderExecController;
 class GpuExecController;
 class ComplexTask;
 
+struct CORE_EXPORT TaskSchedulerMetrics {
+    QList<ExecutorMetrics> fCpuExecutors;
+    ExecutorMetrics fGpuExecutor;
+    ExecutorMetrics fHddExecutor;
+
+    TaskQueCounts fQued;
+    int fQuedHdd = 0;
+    int fQuedDecoder = 0;
+
+    int fWaitingCpu = 0;
+    int fWaitingGpu = 0;
+    int fWaitingHdd = 0;
+    int fWaitingDecoder = 0;
+
+    //! @brief Times queuing new work was held back by overflowed().
+    int fOverflowStalls = 0;
+    //! @brief Times the cpu sat idle with hdd work queued or running.
+    int fHddStalls = 0;
+
+    bool fCriticalMemoryState = false;
+    qint64 fCriticalMemoryMs = 0;
+};
+
 class CORE_EXPORT TaskScheduler : public QObject {
     Q_OBJECT
     using Func = std::function<void()>;
@@ -53,6 +80,8 @@ public:
 
     static bool sAllTasksFinished();
     static bool sAllQuedCpuTasksFinished();
+    //! @brief False until initializeGpu() succeeds, e.g. when rendering headless.
+    static bool sGpuAvailable();
 
     static void sClearTasks();
 
@@ -61,11 +90,18 @@ public:
     void queTasks();
     void queHddTask(const stdsptr<eTask>& task);
     void queCpuTask(const stdsptr<eTask> &task);
+    void queDecoderTask(const stdsptr<eTask>& task,
+                        DecoderExecController* const decoder);
+
+    //! @brief Creates a thread for the tasks of a single media source,
+    //! it is stopped and its waiting tasks canceled once released.
+    stdsptr<DecoderExecController> createDecoder(const QString& name);
 
     void clearTasks();
 
     void afterHddTaskFinished(const stdsptr<eTask>& finishedTask);
     void afterCpuGpuTaskFinished(const stdsptr<eTask>& task);
+    void afterDecoderTaskFinished(const stdsptr<eTask>& task);
 
     void setTaskUnderflowFunc(const Func& func);
     void setAllTasksFinishedFunc(const Func& func);
@@ -75,9 +111,12 @@ public:
     bool allQuedGpuTasksFinished() const;
     bool allQuedCpuTasksFinished() const;
     bool allQuedHddTasksFinished() const;
+    bool allQuedDecoderTasksFinished() const;
 
     bool cpuTasksBeingProcessed() const;
     bool hddTaskBeingProcessed() const;
+    //! @brief Hdd work is queued or running while no cpu task runs
+    bool hddBottleneck() const;
 
     int busyHddThreads() const;
     int busyCpuThreads() const;
@@ -85,13 +124,21 @@ public:
     int availableCpuThreads() const;
 
     void setAlwaysQue(const bool alwaysQue);
+    //! @brief Limit of ques (frames) waiting at once, <= 0 - default.
+    void setMaxQues(const int maxQues);
+
+    void setQuePriority(const eTaskPriority priority);
+    eTaskPriority quePriority() const { return mQuePriority; }
 
     void addComplexTask(const qsptr<ComplexTask>& task);
 
     void enterCriticalMemoryState();
     void finishCriticalMemoryState();
+    bool criticalMemoryState() const { return mCriticalMemoryState; }
 
     void waitTillFinished();
+
+    TaskSchedulerMetrics metrics() const;
 signals:
     void finishedAllQuedTasks() const;
     void hddUsageChanged(bool);
@@ -102,6 +149,7 @@ private:
     void queScheduledCpuTasks();
 
     void processNextQuedHddTask();
+    void processNextQuedDecoderTasks();
     void processNextQuedCpuTask();
     bool processNextQuedGpuTask();
     void processNextTasks();
@@ -115,17 +163,27 @@ private:
     static TaskScheduler* sInstance;
 
     bool mCriticalMemoryState = false;
+    QElapsedTimer mCriticalMemoryTimer;
+    qint64 mCriticalMemoryMs = 0;
+
+    int mOverflowStalls = 0;
+    int mHddStalls = 0;
 
     bool mAlwaysQue = false;
+    int mMaxQues = 0;
     bool mCpuQueing = false;
+    eTaskPriority mQuePriority = eTaskPriority::interactive;
 
     QList<qsptr<ComplexTask>> mComplexTasks;
 
     TaskQueHandler mQuedCGTasks;
     QList<stdsptr<eTask>> mQuedHddTasks;
+    QList<std::pair<stdsptr<eTask>,
+                    QPointer<DecoderExecController>>> mQuedDecoderTasks;
 
     QList<stdsptr<CpuExecController>> mCpuExecs;
     stdsptr<GpuExecController> mGpuExec;
+    bool mGpuAvailable = false;
     stdsptr<HddExecController> mHddExec;
 
     Func mTaskUnderflowFunc;
@@ -0,0 +1,227 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "tasktracer.h"
+
+#include "Tasks/etask.h"
+
+#include <QFile>
+#include <QThread>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <typeinfo>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace {
+    struct TraceEvent {
+        char fPh;
+        const char* fPhase;
+        qint64 fTs;
+        qint64 fDur;
+        int fTid;
+        stdsptr<const TaskTraceInfo> fInfo;
+    };
+
+    std::atomic<bool> gEnabled{false};
+    std::atomic<quint64> gNextId{1};
+    std::atomic<int> gNextTid{1};
+    std::mutex gMutex;
+    QList<TraceEvent> gEvents;
+    QMap<int, QString> gThreadNames;
+
+    // started once on first use, sNowUs runs on every executor thread
+    const QElapsedTimer& traceClock() {
+        static const QElapsedTimer sClock = [] {
+            QElapsedTimer timer;
+            timer.start();
+            return timer;
+        }();
+        return sClock;
+    }
+
+    thread_local int tTid = 0;
+    thread_local QString tThreadName;
+
+    int currentTid() {
+        if(tTid == 0) {
+            tTid = gNextTid++;
+            QString name = tThreadName;
+            if(name.isEmpty()) {
+                const auto app = QCoreApplication::instance();
+                const bool main = app && app->thread() == QThread::currentThread();
+                name = main ? QStringLiteral("Main") :
+                              QStringLiteral("Thread %1").arg(tTid);
+            }
+            std::lock_guard<std::mutex> lk(gMutex);
+            gThreadNames.insert(tTid, name);
+        }
+        return tTid;
+    }
+
+    QString demangledTypeName(const eTask& task) {
+        const char* const name = typeid(task).name();
+#ifdef __GNUG__
+        int status = 0;
+        char* const demangled = abi::__cxa_demangle(name, nullptr,
+                                                    nullptr, &status);
+        if(status == 0 && demangled) {
+            const QString result(demangled);
+            free(demangled);
+            return result;
+        }
+#endif
+        return QString(name);
+    }
+
+    void record(const char ph, const char* const phase,
+                const qint64 ts, const qint64 dur,
+                const eTask& task) {
+        const auto info = task.traceInfo();
+        if(!info) return;
+        const int tid = currentTid();
+        std::lock_guard<std::mutex> lk(gMutex);
+        gEvents << TraceEvent{ph, phase, ts, dur, tid, info};
+    }
+}
+
+void TaskTracer::sStart() {
+    std::lock_guard<std::mutex> lk(gMutex);
+    gEvents.clear();
+    gEnabled = true;
+}
+
+bool TaskTracer::sStop(const QString& path) {
+    gEnabled = false;
+    QList<TraceEvent> events;
+    QMap<int, QString> threadNames;
+    {
+        std::lock_guard<std::mutex> lk(gMutex);
+        std::swap(events, gEvents);
+        threadNames = gThreadNames;
+    }
+    if(path.isEmpty()) return false;
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    bool first = true;
+    const auto write = [&](const QJsonObject& obj) {
+        file.write(first ? "[\n" : ",\n");
+        file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+        first = false;
+    };
+
+    for(auto it = threadNames.begin(); it != threadNames.end(); it++) {
+        QJsonObject obj;
+        obj["ph"] = "M";
+        obj["name"] = "thread_name";
+        obj["pid"] = pid;
+        obj["tid"] = it.key();
+        obj["args"] = QJsonObject{{"name", it.value()}};
+        write(obj);
+    }
+
+    for(const auto& event : events) {
+        const auto& info = *event.fInfo;
+        QJsonObject args;
+        if(!info.fOwner.isEmpty()) args["owner"] = info.fOwner;
+        if(info.fFrame >= 0) args["frame"] = info.fFrame;
+        args["task"] = QString::number(info.fId);
+
+        QJsonObject obj;
+        obj["ph"] = QString(QLatin1Char(event.fPh));
+        obj["cat"] = event.fPhase;
+        obj["name"] = event.fPh == 'X' ?
+                    QString("%1::%2").arg(info.fType, event.fPhase) :
+                    QString("%1 %2").arg(info.fType, event.fPhase);
+        obj["pid"] = pid;
+        obj["tid"] = event.fTid;
+        obj["ts"] = event.fTs;
+        if(event.fPh == 'X') {
+            obj["dur"] = event.fDur;
+        } else {
+            obj["id"] = QString::number(info.fId);
+        }
+        obj["args"] = args;
+        write(obj);
+    }
+    file.write(first ? "[]\n" : "\n]\n");
+    return true;
+}
+
+bool TaskTracer::sEnabled() {
+    return gEnabled;
+}
+
+qint64 TaskTracer::sNowUs() {
+    return traceClock().nsecsElapsed()/1000;
+}
+
+void TaskTracer::sSetThreadName(const QString& name) {
+    tThreadName = name;
+}
+
+void TaskTracer::sSetup(eTask& task) {
+    if(task.traceInfo()) return;
+    sSetup(task, demangledTypeName(task),
+           task.traceOwner(), task.traceFrame());
+}
+
+void TaskTracer::sSetup(eTask& task,
+                        const QString& type,
+                        const QString& owner,
+                        const qreal frame) {
+    const auto info = std::make_shared<TaskTraceInfo>();
+    info->fType = type;
+    info->fOwner = owner;
+    info->fFrame = frame;
+    info->fId = gNextId++;
+    task.setTraceInfo(info);
+}
+
+void TaskTracer::sQued(const eTask& task) {
+    if(!gEnabled) return;
+    record('b', "qued", sNowUs(), 0, task);
+}
+
+void TaskTracer::sStarted(const eTask& task) {
+    if(!gEnabled) return;
+    record('e', "qued", sNowUs(), 0, task);
+}
+
+void TaskTracer::sComplete(const eTask& task,
+                           const char* const phase,
+                           const qint64 startUs) {
+    if(!gEnabled) return;
+    record('X', phase, startUs, sNowUs() - startUs, task);
+}
@@ -0,0 +1,65 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef TASKTRACER_H
+#define TASKTRACER_H
+
+#include <QString>
+
+#include "core_global.h"
+
+class eTask;
+
+struct CORE_EXPORT TaskTraceInfo {
+    QString fType;
+    QString fOwner;
+    qreal fFrame = -1;
+    quint64 fId = 0;
+};
+
+//! @brief Opt-in recorder of task lifetimes,
+//! written as Chrome trace JSON (loadable in Perfetto).
+class CORE_EXPORT TaskTracer {
+public:
+    static void sStart();
+    static bool sStop(const QString& path);
+    static bool sEnabled();
+
+    static qint64 sNowUs();
+
+    static void sSetThreadName(const QString& name);
+
+    static void sSetup(eTask& task);
+    static void sSetup(eTask& task,
+                       const QString& type,
+                       const QString& owner,
+                       const qreal frame);
+
+    static void sQued(const eTask& task);
+    static void sStarted(const eTask& task);
+    static void sComplete(const eTask& task,
+                          const char* const phase,
+                          const qint64 startUs);
+};
+
+#endif // TASKTRACER_H
@@ -182,15 +182,60 @@ eSettings::eSettings(const int cpuThreads,
     gSettings << std::make_shared<eBoolSetting>(
                      fPathGpuAcc,
                      "pathGpuAcc", true);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fCpuWorkStealing,
+                     "cpuWorkStealing", false);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fParallelOutput,
+                     "parallelOutput", false);
+    gSettings << std::make_shared<eIntSetting>(
+                     fOutputFramesInFlight,
+                     "outputFramesInFlight", 0);
+    gSettings << std::make_shared<eIntSetting>(
+                     fEncoderThreads,
+                     "encoderThreads", 0);
+    gSettings << std::make_shared<eIntSetting>(
+                     fParallelEncoders,
+                     "parallelEncoders", 0);
     gSettings << std::make_shared<eIntSetting>(
                      fInternalMultisampleCount,
                      "msaa", 4);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fRamCacheCompression,
+                     "ramCacheCompression", true);
     gSettings << std::make_shared<eBoolSetting>(
                      fHddCache,
                      "hddCache", true);
     gSettings << std::make_shared<eIntSetting>(
                      reinterpret_cast<int&>(fHddCacheMBCap),
                      "hddCacheMBCap", 0);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fPersistentRenderCache,
+                     "persistentRenderCache", false);
+    gSettings << std::make_shared<eStringSetting>(
+                     fPersistentRenderCacheFolder,
+                     "persistentRenderCacheFolder", "");
+    gSettings << std::make_shared<eIntSetting>(
+                     reinterpret_cast<int&>(fPersistentRenderCacheMBCap),
+                     "persistentRenderCacheMBCap", 4096);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fCompactPreviewCache,
+                     "compactPreviewCache", false);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fDraftPreviewCache,
+                     "draftPreviewCache", false);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fCompactVideoCache,
+                     "compactVideoCache", true);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fAutoVideoProxies,
+                     "autoVideoProxies", true);
+    gSettings << std::make_shared<eBoolSetting>(
+                     fPredictiveRender,
+                     "predictiveRender", true);
+    gSettings << std::make_shared<eIntSetting>(
+                     fPredictiveRenderFrames,
+                     "predictiveRenderFrames", 24);
 
     gSettings << std::make_shared<eQrealSetting>(
                      fInterfaceScaling,
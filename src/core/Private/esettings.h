@@ -97,15 +97,40 @@ public:
     AccPreference fAccPreference = AccPreference::defaultPreference;
     bool fPathGpuAcc = true;
 
+    bool fCpuWorkStealing = false; // per thread task ques with stealing
+
+    bool fParallelOutput = false; // render several output frames at once
+    int fOutputFramesInFlight = 0; // <= 0 - automatic, capped by RAM, at least one per cpu thread
+    int fEncoderThreads = 0; // <= 0 - let the codec decide
+    int fParallelEncoders = 0; // <= 0 - automatic, 1 - off, at most 8, frame independent codecs
+
     // MSAA
     int fInternalMultisampleCount = 4;
 
     int fImportFileDirOpt = ImportFileDirRecent;
 
+    bool fRamCacheCompression = true; // compress frames before spilling them
     bool fHddCache = true;
     QString fHddCacheFolder = ""; // "" - use system default temporary files folder
     intMB fHddCacheMBCap = intMB(0); // <= 0 - no cap
 
+    // rendered scene frames kept between sessions
+    bool fPersistentRenderCache = false;
+    QString fPersistentRenderCacheFolder = ""; // "" - use application cache folder
+    intMB fPersistentRenderCacheMBCap = intMB(4096); // <= 0 - no cap
+
+    // smaller layouts for frames kept for preview playback
+    bool fCompactPreviewCache = false; // YUV 4:2:0, with an alpha plane if needed
+    bool fDraftPreviewCache = false; // RGB565 for opaque backgrounds
+    // decoded video frames kept in YUV 4:2:0, expanded when drawn
+    bool fCompactVideoCache = true;
+    // reduced MJPEG copies of large videos, decoded by previews below 100%
+    bool fAutoVideoProxies = true;
+
+    // frames rendered ahead of (and behind) the playhead while idle
+    bool fPredictiveRender = true;
+    int fPredictiveRenderFrames = 24; // still capped by RAM
+
     // history
     int fUndoCap = 25; // <= 0 - no cap
 
@@ -2,6 +2,7 @@
 #define QATOMICLIST_H
 
 #include <QList>
+#include <algorithm>
 #include <mutex>
 #include <condition_variable>
 
@@ -61,6 +62,20 @@ public:
         mCv.notify_all();
     }
 
+    // keeps the list sorted, equal elements stay in FIFO order
+    template <typename LessThan>
+    void insertSortedAndNotifyAll(const QList<T>& list,
+                                  const LessThan& lessThan) {
+        std::lock_guard<std::mutex> lk(mMutex);
+        for(const auto& t : list) {
+            const auto it = std::upper_bound(QList<T>::begin(),
+                                             QList<T>::end(),
+                                             t, lessThan);
+            QList<T>::insert(it, t);
+        }
+        mCv.notify_all();
+    }
+
     void appendAndNotifyOne(const QList<T>& list) {
         std::lock_guard<std::mutex> lk(mMutex);
         QList<T>::append(list);
@@ -91,6 +106,14 @@ public:
         t = QList<T>::takeFirst();
         return true;
     }
+
+    bool waitTakeFirstFor(T& t, const std::chrono::milliseconds& timeout) {
+        std::unique_lock<std::mutex> lk(mMutex);
+        if(QList<T>::isEmpty()) mCv.wait_for(lk, timeout);
+        if(QList<T>::isEmpty()) return false;
+        t = QList<T>::takeFirst();
+        return true;
+    }
 private:
     std::mutex mMutex;
     std::condition_variable mCv;
@@ -0,0 +1,85 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, version 3.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef SPSCQUE_H
+#define SPSCQUE_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+// Bounded lock-free ring buffer for exactly one producer thread
+// and exactly one consumer thread.
+template <typename T>
+class SpscQue {
+public:
+    // Has to be called while neither side is running.
+    void setup(const int capacity) {
+        mSlots.assign(static_cast<size_t>(capacity + 1), T());
+        mHead = 0;
+        mTail = 0;
+    }
+
+    bool tryPush(const T& t) {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        const size_t next = increment(tail);
+        if(next == mHead.load(std::memory_order_acquire)) return false;
+        mSlots[tail] = t;
+        mTail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& t) {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if(head == mTail.load(std::memory_order_acquire)) return false;
+        t = mSlots[head];
+        mHead.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    void push(const T& t) {
+        int spins = 0;
+        while(!tryPush(t)) sBackoff(spins);
+    }
+
+    void pop(T& t) {
+        int spins = 0;
+        while(!tryPop(t)) sBackoff(spins);
+    }
+
+    // spin shortly, then sleep, so that idle stages stay cheap
+    static void sBackoff(int& spins) {
+        if(spins++ < 64) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+private:
+    size_t increment(const size_t id) const {
+        return id + 1 == mSlots.size() ? 0 : id + 1;
+    }
+
+    std::vector<T> mSlots;
+    alignas(64) std::atomic<size_t> mHead{0};
+    alignas(64) std::atomic<size_t> mTail{0};
+};
+
+#endif // SPSCQUE_H
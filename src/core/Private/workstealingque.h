@@ -0,0 +1,176 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, version 3.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef WORKSTEALINGQUE_H
+#define WORKSTEALINGQUE_H
+
+#include <QList>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// One deque per worker thread. Owners take from the front of their own
+// deque, idle workers steal half of the back of another worker's deque.
+template <typename T>
+class WorkStealingQue {
+public:
+    // Has to be called before any worker is started.
+    void setup(const int nQues) {
+        mQues.clear();
+        for(int i = 0; i < nQues; i++) {
+            mQues.push_back(std::make_unique<Que>());
+        }
+        mNextQue = 0;
+        mCount = 0;
+    }
+
+    int queCount() const { return static_cast<int>(mQues.size()); }
+
+    int count() const { return mCount; }
+
+    bool isEmpty() const { return mCount == 0; }
+
+    void appendAndNotifyAll(const T& t) {
+        if(mQues.empty()) return;
+        const int id = nextQue();
+        {
+            std::lock_guard<std::mutex> lk(mQues[id]->fMutex);
+            mQues[id]->fTasks.push_back(t);
+            mCount++;
+        }
+        notifyAll();
+    }
+
+    void appendAndNotifyAll(const QList<T>& list) {
+        if(mQues.empty() || list.isEmpty()) return;
+        for(const auto& t : list) {
+            const int id = nextQue();
+            std::lock_guard<std::mutex> lk(mQues[id]->fMutex);
+            mQues[id]->fTasks.push_back(t);
+            mCount++;
+        }
+        notifyAll();
+    }
+
+    // for urgent work, owners will pick it up first
+    void prependAndNotifyAll(const QList<T>& list) {
+        if(mQues.empty() || list.isEmpty()) return;
+        for(auto it = list.rbegin(); it != list.rend(); it++) {
+            const int id = nextQue();
+            std::lock_guard<std::mutex> lk(mQues[id]->fMutex);
+            mQues[id]->fTasks.push_front(*it);
+            mCount++;
+        }
+        notifyAll();
+    }
+
+    QList<T> takeAll() {
+        // a thief holds stolen tasks outside of any deque
+        std::lock_guard<std::mutex> stealLk(mStealMutex);
+        QList<T> result;
+        for(const auto& que : mQues) {
+            std::lock_guard<std::mutex> lk(que->fMutex);
+            for(const auto& t : que->fTasks) result << t;
+            mCount -= static_cast<int>(que->fTasks.size());
+            que->fTasks.clear();
+        }
+        return result;
+    }
+
+    void notifyAll() {
+        std::lock_guard<std::mutex> lk(mWaitMutex);
+        mCv.notify_all();
+    }
+
+    // Returns false if nothing was found before the timeout.
+    bool waitTake(const int id, T& t,
+                  const std::chrono::milliseconds& timeout) {
+        if(takeOwn(id, t)) return true;
+        if(steal(id, t)) return true;
+        {
+            std::unique_lock<std::mutex> lk(mWaitMutex);
+            if(mCount == 0) mCv.wait_for(lk, timeout);
+        }
+        if(takeOwn(id, t)) return true;
+        return steal(id, t);
+    }
+private:
+    struct Que {
+        std::mutex fMutex;
+        std::deque<T> fTasks;
+    };
+
+    int nextQue() {
+        const unsigned nQues = static_cast<unsigned>(queCount());
+        return static_cast<int>(mNextQue++ % nQues);
+    }
+
+    bool takeOwn(const int id, T& t) {
+        auto& que = *mQues[id];
+        std::lock_guard<std::mutex> lk(que.fMutex);
+        if(que.fTasks.empty()) return false;
+        t = que.fTasks.front();
+        que.fTasks.pop_front();
+        mCount--;
+        return true;
+    }
+
+    bool steal(const int id, T& t) {
+        std::lock_guard<std::mutex> stealLk(mStealMutex);
+        const int nQues = queCount();
+        std::deque<T> stolen;
+        for(int i = 1; i < nQues && stolen.empty(); i++) {
+            auto& victim = *mQues[(id + i) % nQues];
+            std::lock_guard<std::mutex> lk(victim.fMutex);
+            const int nSteal = (static_cast<int>(victim.fTasks.size()) + 1)/2;
+            for(int j = 0; j < nSteal; j++) {
+                stolen.push_front(victim.fTasks.back());
+                victim.fTasks.pop_back();
+            }
+        }
+        if(stolen.empty()) return false;
+        t = stolen.front();
+        stolen.pop_front();
+        mCount--;
+        if(!stolen.empty()) {
+            auto& own = *mQues[id];
+            std::lock_guard<std::mutex> lk(own.fMutex);
+            for(const auto& s : stolen) own.fTasks.push_back(s);
+        }
+        return true;
+    }
+
+    std::vector<std::unique_ptr<Que>> mQues;
+    std::atomic<unsigned> mNextQue{0};
+    std::atomic<int> mCount{0};
+    // held while stealing and by takeAll, so no task is
+    // in between deques when they are all emptied
+    std::mutex mStealMutex;
+
+    std::mutex mWaitMutex;
+    std::condition_variable mCv;
+};
+
+#endif // WORKSTEALINGQUE_H
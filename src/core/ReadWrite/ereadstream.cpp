@@ -6,6 +6,8 @@
 #include "evformat.h"
 #include "Boxes/boundingbox.h"
 
+#include <cstring>
+
 eReadFutureTable::eReadFutureTable(QIODevice * const main) : mMain(main) {}
 
 void eReadFutureTable::read() {
@@ -59,6 +61,13 @@ bool eReadStream::seek(const eFuturePos &pos) {
 }
 
 void eReadStream::readCheckpoint(const QString &errMsg) {
+    if(mEvFileVersion >= EvFormat::checkpointMagic) {
+        qint64 tag; read(&tag, sizeof(qint64));
+        if(tag != EvFormat::checkpointTag)
+            RuntimeThrow("No checkpoint at QIODevice::pos '" +
+                         QString::number(mSrc->pos() - qint64(sizeof(qint64))) +
+                         "'.\n" + errMsg);
+    }
     const qint64 sPos = mSrc->pos();
     qint64 pos; read(&pos, sizeof(qint64));
     if(pos != sPos)
@@ -67,6 +76,36 @@ void eReadStream::readCheckpoint(const QString &errMsg) {
                      QString::number(pos) + "'.\n" + errMsg);
 }
 
+void eReadStream::skipToCheckpoint(const QString &errMsg) {
+    // a checkpoint is a tag followed by its own position as qint64,
+    // older files only have the position, which payload can match
+    const bool tagged = mEvFileVersion >= EvFormat::checkpointMagic;
+    const int posSize = sizeof(qint64);
+    const int tagSize = tagged ? posSize : 0;
+    const int checkpointSize = tagSize + posSize;
+    qint64 chunkPos = mSrc->pos();
+    while(true) {
+        mSrc->seek(chunkPos);
+        const QByteArray chunk = mSrc->read(64*1024);
+        if(chunk.size() < checkpointSize) break;
+        for(int i = 0; i + checkpointSize <= chunk.size(); i++) {
+            const char* const data = chunk.constData() + i;
+            if(tagged) {
+                qint64 tag;
+                memcpy(&tag, data, posSize);
+                if(tag != EvFormat::checkpointTag) continue;
+            }
+            qint64 pos;
+            memcpy(&pos, data + tagSize, posSize);
+            if(pos != chunkPos + i + tagSize) continue;
+            mSrc->seek(pos + posSize);
+            return;
+        }
+        chunkPos += chunk.size() - checkpointSize + 1;
+    }
+    RuntimeThrow("No checkpoint found.\n" + errMsg);
+}
+
 QByteArray eReadStream::readCompressed() {
     QByteArray compressed; *this >> compressed;
     return qUncompress(compressed);
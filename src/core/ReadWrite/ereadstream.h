@@ -57,6 +57,9 @@ public:
     bool seek(const eFuturePos& pos);
 
     void readCheckpoint(const QString& errMsg);
+    //! @brief Skips data up to and including the next checkpoint,
+    //! used to bypass sections that need the GUI to be read.
+    void skipToCheckpoint(const QString& errMsg);
 
     inline qint64 read(void* const data, const qint64 len) {
         return mSrc->read(reinterpret_cast<char*>(data), len);
@@ -26,6 +26,8 @@
 #ifndef EVFORMAT_H
 #define EVFORMAT_H
 
+#include <QtGlobal>
+
 namespace EvFormat {
     enum {
         dataCompression = 16,
@@ -47,11 +49,15 @@ namespace EvFormat {
         subPathOffset = 32,
         avStretch = 33,
         grid = 34,
+        checkpointMagic = 35,
 
         nextVersion
     };
 
     const int version = nextVersion - 1;
+
+    // written in front of the position of every checkpoint
+    const qint64 checkpointTag = 0x54504b4354435246; // "FRCTCKPT"
 }
 
 #endif // EVFORMAT_H
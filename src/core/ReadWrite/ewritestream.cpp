@@ -5,6 +5,7 @@
 #include "Paint/brushescontext.h"
 #include "filefooter.h"
 #include "framerange.h"
+#include "evformat.h"
 
 void eWriteFutureTable::write(eWriteStream &dst) {
     for(const auto& future : mFutures) {
@@ -32,6 +33,8 @@ void eWriteStream::assignFuturePos(const eWriteStream::FuturePosId id) {
 }
 
 void eWriteStream::writeCheckpoint() {
+    const qint64 tag = EvFormat::checkpointTag;
+    write(&tag, sizeof(qint64));
     const qint64 pos = mDst->pos();
     write(&pos, sizeof(qint64));
 }
@@ -66,6 +69,7 @@ qint64 eWriteStream::writeCompressed(const void* const data, const qint64 len) {
 }
 
 void eWriteStream::writeFilePath(const QString& absPath) {
+    if(!mFilePaths.contains(absPath)) mFilePaths << absPath;
     const QString relPath = mDir.relativeFilePath(absPath);
     *this << absPath;
     *this << relPath;
@@ -82,6 +82,8 @@ public:
     eWriteStream& operator<<(SimpleBrushWrapper* const brush);
 
     void writeFilePath(const QString& absPath);
+    //! @brief Absolute paths passed to writeFilePath so far.
+    const QStringList& filePaths() const { return mFilePaths; }
 
     template <typename T>
     eWriteStream& operator<<(const T& value) {
@@ -92,6 +94,7 @@ public:
 private:
     QIODevice* const mDst;
     QDir mDir;
+    QStringList mFilePaths;
     eWriteFutureTable mFutureTable;
     RuntimeIdToWriteId mObjectListIdConv;
 };
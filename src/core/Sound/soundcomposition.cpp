@@ -62,11 +62,13 @@ void SoundComposition::removeSound(const qsptr<eSound>& sound) {
 }
 
 void SoundComposition::secondFinished(const int secondId,
-                                      const stdsptr<Samples> &samples) {
+                                      const stdsptr<Samples> &samples,
+                                      const qreal costMs) {
     mProcessingSeconds.removeOne(secondId);
     if(!samples) return;
     const auto sCont = enve::make_shared<SoundCacheContainer>(
                 samples, iValueRange{secondId, secondId}, &mSecondsCache);
+    sCont->setRecomputeCost(costMs);
     mSecondsCache.add(sCont);
 }
 
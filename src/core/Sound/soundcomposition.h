@@ -60,7 +60,8 @@ public:
     void removeSound(const qsptr<eSound> &sound);
 
     void secondFinished(const int secondId,
-                        const stdsptr<Samples>& samples);
+                        const stdsptr<Samples>& samples,
+                        const qreal costMs);
 
     void setMinFrameUseRange(const int frame);
     void setMaxFrameUseRange(const int frame);
@@ -49,16 +49,20 @@ protected:
                 SoundComposition* const composition) :
         mSecondId(secondId), mSampleRange(sampleRange),
         mComposition(composition), mSettings(eSoundSettings::sData()) {
-
+        setPriority(eTaskPriority::lookAhead);
     }
 
     void afterProcessing() {
         if(mComposition)
-            mComposition->secondFinished(mSecondId, mSamples);
+            mComposition->secondFinished(mSecondId, mSamples,
+                                         processingNs()/1000000.);
     }
 public:
     void process();
 
+    QString traceOwner() const
+    { return QString("second %1").arg(mSecondId); }
+
     void addSoundToMerge(const SingleSoundData& data) {
         mSounds << data;
     }
@@ -24,9 +24,14 @@
 // Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
 
 #include "etask.h"
+#include "Private/Tasks/tasktracer.h"
 
 bool eTask::queTask() {
     mState = eTaskState::qued;
+    if(TaskTracer::sEnabled()) {
+        TaskTracer::sSetup(*this);
+        TaskTracer::sQued(*this);
+    }
     afterQued();
     queTaskNow();
     return true;
@@ -34,5 +39,15 @@ bool eTask::queTask() {
 
 void eTask::aboutToProcess(const Hardware hw) {
     mState = eTaskState::processing;
+    TaskTracer::sStarted(*this);
+    const qint64 startUs = TaskTracer::sNowUs();
     beforeProcessing(hw);
+    TaskTracer::sComplete(*this, "beforeProcessing", startUs);
+}
+
+void eTask::cancelUnprocessed() {
+    Q_ASSERT(mState == eTaskState::processing);
+    // cancel() would only mark a processing task to be canceled later
+    mState = eTaskState::qued;
+    cancel();
 }
@@ -31,6 +31,8 @@
 #include "../switchablecontext.h"
 #include "etaskbase.h"
 
+struct TaskTraceInfo;
+
 class CORE_EXPORT eTask : public StdSelfRef, public eTaskBase {
     friend class TaskScheduler;
     friend class Que;
@@ -53,6 +55,23 @@ public:
     bool queTask();
 
     void aboutToProcess(const Hardware hw);
+    //! @brief Cancels a task taken for processing that was never processed
+    void cancelUnprocessed();
+
+    virtual QString traceOwner() const { return QString(); }
+    virtual qreal traceFrame() const { return -1; }
+
+    const stdsptr<const TaskTraceInfo>& traceInfo() const
+    { return mTraceInfo; }
+    void setTraceInfo(const stdsptr<const TaskTraceInfo>& info)
+    { mTraceInfo = info; }
+
+    static bool sHigherPriority(const stdsptr<eTask>& a,
+                                const stdsptr<eTask>& b) {
+        return a->priority() < b->priority();
+    }
+private:
+    stdsptr<const TaskTraceInfo> mTraceInfo;
 };
 
 Q_DECLARE_METATYPE(stdsptr<eTask>);
@@ -29,6 +29,8 @@
 
 #include "GUI/dialogsinterface.h"
 
+uint eTaskBase::sPathStamp = 1;
+
 void eTaskBase::finishedProcessing() {
     mState = eTaskState::finished;
     if(mCancel) {
@@ -64,6 +66,7 @@ void eTaskBase::addDependent(eTask * const task) {
         if(mDependent.contains(task)) return;
         mDependent << task;
         task->incDependencies();
+        raisePriority(task->priority());
     }
 }
 
@@ -85,9 +88,36 @@ void eTaskBase::cancel() {
     afterCanceled();
 }
 
+void eTaskBase::setPriority(const eTaskPriority priority) {
+    mPriority = priority;
+    mPriorityFixed = true;
+}
+
+void eTaskBase::setDefaultPriority(const eTaskPriority priority) {
+    if(mPriorityFixed) return;
+    mPriority = qMin(mPriority, priority);
+}
+
+void eTaskBase::raisePriority(const eTaskPriority priority) {
+    mPriority = qMin(mPriority, priority);
+}
+
+qreal eTaskBase::criticalPathCost() {
+    if(mPathStamp == sPathStamp) return mPathCost;
+    mPathStamp = sPathStamp;
+    qreal successorsCost = 0;
+    for(const auto& dependent : mDependent) {
+        if(!dependent) continue;
+        successorsCost = qMax(successorsCost, dependent->criticalPathCost());
+    }
+    mPathCost = estimatedCost() + successorsCost;
+    return mPathCost;
+}
+
 void eTaskBase::moveDependent(eTaskBase* const to) {
     for(const auto& dependent : mDependent) {
         to->mDependent << dependent;
+        if(dependent) to->raisePriority(dependent->priority());
     }
     mDependent.clear();
     for(const auto& dependent : mDependentF) {
@@ -37,6 +37,14 @@ enum class eTaskState {
     waiting
 };
 
+// lower value means more urgent
+enum class eTaskPriority {
+    interactive, // frame the user is looking at
+    lookAhead, // preview playback
+    cacheMaintenance, // hdd cache saves, deletes
+    background // output rendering
+};
+
 class eTask;
 
 class CORE_EXPORT eTaskBase {
@@ -74,6 +82,24 @@ public:
 
     bool waitingToCancel() const { return mCancel; }
     void cancel();
+
+    eTaskPriority priority() const { return mPriority; }
+    void setPriority(const eTaskPriority priority);
+    void setDefaultPriority(const eTaskPriority priority);
+    void raisePriority(const eTaskPriority priority);
+
+    //! @brief Estimated processing cost of this task alone, in arbitrary units.
+    virtual qreal estimatedCost() const { return 1; }
+    //! @brief Cost of the longest dependency chain from this task to the end.
+    qreal criticalPathCost();
+    //! @brief Tasks that are waiting for this task to finish.
+    const QList<stdptr<eTask>>& successors() const { return mDependent; }
+
+    static void sInvalidateCriticalPaths() { sPathStamp++; }
+
+    //! @brief Wall time spent in processTask, summed over all steps.
+    qint64 processingNs() const { return mProcessingNs; }
+    void addProcessingNs(const qint64 ns) { mProcessingNs += ns; }
 protected:
     eTaskState mState = eTaskState::created;
 
@@ -86,7 +112,13 @@ private:
     void cancelDependent();
 
     bool mCancel = false;
+    bool mPriorityFixed = false;
+    eTaskPriority mPriority = eTaskPriority::background;
     int mNDependancies = 0;
+    qreal mPathCost = 0;
+    qint64 mProcessingNs = 0;
+    uint mPathStamp = 0;
+    static uint sPathStamp;
     QList<Dependent> mDependentF;
     QList<stdptr<eTask>> mDependent;
     std::exception_ptr mUpdateException;
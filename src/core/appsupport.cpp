@@ -309,6 +309,14 @@ const QString AppSupport::getAppTempPath()
     return QDir::tempPath();
 }
 
+const QString AppSupport::getAppRenderCachePath()
+{
+    QString path = QString::fromUtf8("%1/render").arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    QDir dir(path);
+    if (!dir.exists()) { dir.mkpath(path); }
+    return path;
+}
+
 const QString AppSupport::getAppOutputProfilesPath()
 {
     QString path = QString::fromUtf8("%1/OutputProfiles").arg(getAppConfigPath());
@@ -1019,7 +1027,7 @@ void AppSupport::checkFFmpeg(const bool &isRenderer)
 
 void AppSupport::initEnv(const bool &isRenderer)
 {
-    Q_UNUSED(isRenderer)
+    const bool hasPlatform = !qgetenv("QT_QPA_PLATFORM").isEmpty();
 #if defined(Q_OS_WIN)
     // windows theme integration
 #if QT_VERSION < QT_VERSION_CHECK(6, 5, 0)
@@ -1036,6 +1044,11 @@ void AppSupport::initEnv(const bool &isRenderer)
     // GLX not supported!
     qputenv("QT_XCB_GL_INTEGRATION", "xcb_egl");
 #endif
+
+    // no display needed when rendering from the command line
+    if (isRenderer && !hasPlatform) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
 }
 
 QPair<bool, int> AppSupport::handleXDGArgs(const bool &isRenderer,
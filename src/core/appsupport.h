@@ -83,6 +83,7 @@ public:
     static const QString getAppConfigPath();
     static const QString getAppPath();
     static const QString getAppTempPath();
+    static const QString getAppRenderCachePath();
     static const QString getAppOutputProfilesPath();
     static const QString getAppPathEffectsPath();
     static const QString getAppRasterEffectsPath();
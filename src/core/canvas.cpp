@@ -26,6 +26,7 @@
 #include <QtMath>
 #include <cmath>
 #include <limits>
+#include <algorithm>
 #include <QDebug>
 #include <QApplication>
 #include <QPolygonF>
@@ -54,6 +55,11 @@
 #include "simpletask.h"
 #include "themesupport.h"
 #include "efiltersettings.h"
+#include "CacheHandlers/persistentrendercache.h"
+#include "Private/Tasks/taskscheduler.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDateTime>
 
 using namespace Friction::Core;
 
@@ -85,6 +91,7 @@ Canvas::Canvas(Document &document,
     mSoundComposition = qsptr<SoundComposition>::create(this);
 
     mRange = {0, frameCount};
+    switchSceneFramesResolution(mResolution);
 
     mWidth = canvasWidth;
     mHeight = canvasHeight;
@@ -125,9 +132,89 @@ qreal Canvas::getResolution() const
 
 void Canvas::setResolution(const qreal percent)
 {
+    if (resolutionKey(percent) == resolutionKey(mResolution)) { return; }
+    const uint oldState = mStateId;
     mResolution = percent;
-    prp_afterWholeInfluenceRangeChanged();
+    switchSceneFramesResolution(percent);
     updateAllBoxes(UpdateReason::userChange);
+    // the content did not change, only the resolution it is rendered at
+    restampSceneFrames(oldState, false);
+
+    const int relFrame = anim_getCurrentRelFrame();
+    const auto cont = mSceneFramesHandler->atFrame<SceneFrameContainer>(relFrame);
+    if (cont && cont->storesDataInMemory()) {
+        setSceneFrame(cont->ref<SceneFrameContainer>());
+        mSceneFrameOutdated = false;
+        return;
+    }
+    if (cont) {
+        setLoadingSceneFrame(cont->ref<SceneFrameContainer>());
+    } else if (const auto higher = higherResolutionFrame(relFrame)) {
+        setSceneFrame(higher->ref<SceneFrameContainer>());
+    }
+    mSceneFrameOutdated = true;
+}
+
+int Canvas::resolutionKey(const qreal resolution)
+{
+    return qRound(resolution*10000);
+}
+
+HddCachableCacheHandler* Canvas::sceneFramesAt(const qreal resolution) const
+{
+    const auto it = mSceneFrameCaches.find(resolutionKey(resolution));
+    if (it == mSceneFrameCaches.end()) { return nullptr; }
+    return it->second.get();
+}
+
+void Canvas::switchSceneFramesResolution(const qreal resolution)
+{
+    // 25 %, 50 % and 100 % previews plus one more
+    const int maxCaches = 4;
+    const int key = resolutionKey(resolution);
+    auto& cache = mSceneFrameCaches[key];
+    if (!cache) { cache = std::make_unique<HddCachableCacheHandler>(); }
+    const auto old = mSceneFramesHandler;
+    mSceneFramesHandler = cache.get();
+    if (old && old != mSceneFramesHandler) {
+        const auto useRange = old->useRange();
+        old->clearUseRange();
+        if (useRange.isValid()) { mSceneFramesHandler->setUseRange(useRange); }
+    }
+    // frames may outlive their cache, so caches are emptied, never deleted
+    QList<int> used;
+    for (const auto &it : mSceneFrameCaches) {
+        if (it.second->begin() != it.second->end()) { used << it.first; }
+    }
+    std::sort(used.begin(), used.end(), [key](const int a, const int b) {
+        return qAbs(a - key) < qAbs(b - key);
+    });
+    for (int i = maxCaches; i < used.count(); i++) {
+        mSceneFrameCaches[used.at(i)]->clear();
+    }
+}
+
+SceneFrameContainer* Canvas::higherResolutionFrame(const int relFrame) const
+{
+    const auto begin = mSceneFrameCaches.upper_bound(resolutionKey(mResolution));
+    for (auto it = begin; it != mSceneFrameCaches.end(); it++) {
+        const auto cont = it->second->atFrame<SceneFrameContainer>(relFrame);
+        if (!cont || cont->fBoxState != mStateId) { continue; }
+        if (cont->storesDataInMemory()) { return cont; }
+    }
+    return nullptr;
+}
+
+void Canvas::restampSceneFrames(const uint fromState, const bool all) const
+{
+    for (const auto &cache : mSceneFrameCaches) {
+        for (const auto &cont : *cache.second) {
+            const auto sceneCont = static_cast<SceneFrameContainer*>(cont.second.get());
+            if (all || sceneCont->fBoxState == fromState) {
+                sceneCont->fBoxState = mStateId;
+            }
+        }
+    }
 }
 
 void Canvas::setCurrentGroupParentAsCurrentGroup()
@@ -137,11 +224,69 @@ void Canvas::setCurrentGroupParentAsCurrentGroup()
 
 void Canvas::queTasks()
 {
+    if (getUpdatePlanned() && quePersistentFrame(anim_getCurrentRelFrame())) {
+        return;
+    }
     if (Actions::sInstance->smoothChange() && mCurrentContainer) {
         if (!mDrawnSinceQue) { return; }
         mCurrentContainer->queChildrenTasks();
     } else ContainerBox::queTasks();
     mDrawnSinceQue = false;
+    quePredictedFrames();
+}
+
+int Canvas::predictionWindow() const
+{
+    const auto& sett = eSettings::instance();
+    if (!sett.fPredictiveRender) { return 0; }
+    const qint64 frameBytes = qMax(qint64(1),
+                                   qint64(qCeil(mWidth*mResolution))*
+                                   qCeil(mHeight*mResolution)*4);
+    // a quarter of the RAM cache budget at most
+    const qint64 budget = qint64(eSettings::sRamMBCap().fValue)*1024*1024/4;
+    return int(qBound(qint64(0), budget/frameBytes,
+                      qint64(sett.fPredictiveRenderFrames)));
+}
+
+void Canvas::quePredictedFrames()
+{
+    if (mPreviewing || mRenderingOutput || mSceneFrameOutdated) { return; }
+    if (Actions::sInstance->smoothChange()) { return; }
+    const auto scheduler = TaskScheduler::instance();
+    if (scheduler->criticalMemoryState()) { return; }
+    const int maxFrames = predictionWindow();
+    if (maxFrames <= 0) { return; }
+
+    mPlayhead.setBounds(mRange);
+    mPlayhead.setLoopHint(mIn.enabled && mOut.enabled ?
+                              FrameRange{mIn.frame, mOut.frame} :
+                              FrameRange::INVALID);
+    QList<int> markers;
+    for (const auto &marker : mMarkers) { markers << marker.frame; }
+    mPlayhead.setMarkers(markers);
+
+    // source media is cheaper than a render, fetch it twice as far out
+    const auto frames = mPlayhead.window(2*maxFrames);
+    const auto priority = scheduler->quePriority();
+    scheduler->setQuePriority(eTaskPriority::lookAhead);
+    int renders = 0;
+    int prefetches = 0;
+    for (int i = 0; i < frames.count(); i++) {
+        const int relFrame = prp_absFrameToRelFrame(frames.at(i));
+        if (i >= maxFrames) {
+            if (prefetches++ >= 4) { break; }
+            prefetchFrame(relFrame);
+            continue;
+        }
+        // one frame at a time keeps interactive updates responsive
+        if (renders >= 1) { continue; }
+        if (mSceneFramesHandler->atFrame(relFrame)) { continue; }
+        if (hasCurrentRenderData(relFrame)) { continue; }
+        renders++;
+        if (quePersistentFrame(relFrame)) { continue; }
+        queRender(relFrame, getInheritedTransformAtFrame(relFrame));
+    }
+    scheduler->setQuePriority(priority);
 }
 
 void Canvas::addSelectedForGraph(const int widgetId,
@@ -298,7 +443,7 @@ void Canvas::renderSk(SkCanvas* const canvas,
             }
             const float reversedRes = toSkScalar(1/mSceneFrame->fResolution);
             canvas->scale(reversedRes, reversedRes);
-            mSceneFrame->drawImage(canvas, filter);
+            drawSceneFrame(canvas, filter);
             canvas->restore();
         }
         return;
@@ -350,7 +495,7 @@ void Canvas::renderSk(SkCanvas* const canvas,
         canvas->save();
         const float reversedRes = toSkScalar(1/mSceneFrame->fResolution);
         canvas->scale(reversedRes, reversedRes);
-        mSceneFrame->drawImage(canvas, filter);
+        drawSceneFrame(canvas, filter);
         canvas->restore();
     }
 
@@ -843,7 +988,7 @@ void Canvas::setOutputRendering(const bool bT) {
 }
 
 void Canvas::setSceneFrame(const int relFrame) {
-    const auto cont = mSceneFramesHandler.atFrame(relFrame);
+    const auto cont = mSceneFramesHandler->atFrame(relFrame);
     setSceneFrame(enve::shared<SceneFrameContainer>(cont));
 }
 
@@ -876,14 +1021,24 @@ void Canvas::renderDataFinished(BoxRenderData *renderData) {
     mLastStateId = renderData->fBoxStateId;
 
     const auto range = prp_getIdenticalRelRange(relFrame);
+    const bool currentResolution = resolutionKey(renderData->fResolution) ==
+                                   resolutionKey(mResolution);
+    const auto cache = currentState ?
+                sceneFramesAt(renderData->fResolution) : nullptr;
     const auto cont = enve::make_shared<SceneFrameContainer>(
-                this, renderData, range,
-                currentState ? &mSceneFramesHandler : nullptr);
-    if(currentState) mSceneFramesHandler.add(cont);
+                this, renderData, range, cache);
+    cont->setRecomputeCost(renderData->renderCostMs());
+    if(cache) cache->add(cont);
+    if(currentState) compactPreviewFrame(cont.get(), relFrame);
+    if(currentState && currentResolution && usePersistentCache()) {
+        PersistentRenderCache::sStore(persistentCacheKey(range),
+                                      renderData->fRenderedImage);
+    }
 
     if(!mPreviewing && !mRenderingOutput){
         bool newerSate = true;
         bool closerFrame = true;
+        bool exactResolution = false;
         if(mSceneFrame) {
             newerSate = mSceneFrame->fBoxState < renderData->fBoxStateId;
             const int cRelFrame = anim_getCurrentRelFrame();
@@ -893,18 +1048,191 @@ void Canvas::renderDataFinished(BoxRenderData *renderData) {
             const int oldFrameDist = qMin(qAbs(cRelFrame - cRange.fMin),
                                           qAbs(cRelFrame - cRange.fMax));
             closerFrame = finishedFrameDist < oldFrameDist;
+            // replace a downscaled fallback with the exact resolution frame
+            exactResolution = currentState && currentResolution &&
+                    finishedFrameDist == oldFrameDist &&
+                    resolutionKey(mSceneFrame->fResolution) !=
+                    resolutionKey(mResolution);
         }
-        if(newerSate || closerFrame) {
+        if(newerSate || closerFrame || exactResolution) {
             mSceneFrameOutdated = !currentState;
             setSceneFrame(cont);
         }
     }
 }
 
+namespace {
+    class HashingDevice : public QIODevice {
+    public:
+        HashingDevice() : mHash(QCryptographicHash::Sha1) {
+            open(QIODevice::WriteOnly);
+        }
+
+        QByteArray result() const { return mHash.result(); }
+    protected:
+        qint64 readData(char*, qint64) { return -1; }
+        qint64 writeData(const char* data, qint64 len) {
+            mHash.addData(data, static_cast<int>(len));
+            return len;
+        }
+    private:
+        QCryptographicHash mHash;
+    };
+}
+
+bool Canvas::usePersistentCache() const {
+    return (mRenderingPreview || mRenderingOutput) &&
+           PersistentRenderCache::sEnabled();
+}
+
+static void sAddLinkedScenes(const ContainerBox * const container,
+                             QList<qptr<Canvas>>& scenes) {
+    for(const auto box : container->getContainedBoxes()) {
+        if(const auto link = enve_cast<InternalLinkCanvas*>(box)) {
+            const auto scene = enve_cast<Canvas*>(link->getLinkTarget());
+            if(scene && !scenes.contains(scene)) scenes << scene;
+        } else if(const auto group = enve_cast<ContainerBox*>(box)) {
+            sAddLinkedScenes(group, scenes);
+        }
+    }
+}
+
+const QByteArray& Canvas::persistentSceneHash() {
+    if(mPersistentSceneHash.isEmpty() || mPersistentHashStateId != mStateId) {
+        // the saved scene covers every animated value
+        // and the paths of the files it references
+        HashingDevice device;
+        {
+            eWriteStream dst(&device);
+            writeBoundingBox(dst);
+            mPersistentFiles = dst.filePaths();
+        }
+        BoundingBox::sClearWriteBoxes();
+        mPersistentSceneHash = device.result();
+        mPersistentHashStateId = mStateId;
+        mPersistentLinkedScenes.clear();
+        sAddLinkedScenes(this, mPersistentLinkedScenes);
+    }
+    return mPersistentSceneHash;
+}
+
+void Canvas::addPersistentContentHash(QCryptographicHash& hash,
+                                      QList<const Canvas*>& visited) {
+    if(visited.contains(this)) return;
+    visited << this;
+    hash.addData(persistentSceneHash());
+    // files can change on disk without changing the scene,
+    // so their size and modification time is checked on every lookup
+    for(const auto& path : mPersistentFiles) {
+        const QFileInfo info(path);
+        hash.addData(QByteArray::number(info.size()));
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    }
+    // maps scene frames to source video frames and linked scene frames
+    hash.addData(QByteArray::number(mFps, 'g', 17));
+    // linked scenes are only written by reference,
+    // edits to them do not change the state of this scene
+    for(const auto& scene : mPersistentLinkedScenes) {
+        if(scene) scene->addPersistentContentHash(hash, visited);
+    }
+}
+
+QByteArray Canvas::persistentCacheKey(const FrameRange &range) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QList<const Canvas*> visited;
+    addPersistentContentHash(hash, visited);
+    const QString params = QString("%1 %2 %3 %4 %5 %6").
+            arg(range.fMin).arg(range.fMax).
+            arg(mWidth).arg(mHeight).arg(mClipToCanvasSize).
+            arg(mResolution, 0, 'g', 17);
+    hash.addData(params.toUtf8());
+    return hash.result();
+}
+
+bool Canvas::quePersistentFrame(const int relFrame) {
+    if(!usePersistentCache()) return false;
+    if(mPersistentLoads.contains(relFrame)) return true;
+    if(mSceneFramesHandler->atFrame(relFrame)) return false;
+    if(mPersistentMissesStateId != mStateId) {
+        mPersistentMisses.clear();
+        mPersistentMissesStateId = mStateId;
+    }
+    if(mPersistentMisses.contains(relFrame)) return false;
+    const auto range = prp_getIdenticalRelRange(relFrame);
+    const auto key = persistentCacheKey(range);
+    if(!PersistentRenderCache::sContains(key)) {
+        mPersistentMisses << relFrame;
+        return false;
+    }
+    const uint stateId = mStateId;
+    const QPointer<Canvas> thisPtr = this;
+    const auto loader = enve::make_shared<PersistentFrameLoader>(
+                key, [thisPtr, stateId, range](const sk_sp<SkImage>& image) {
+        if(thisPtr) thisPtr->persistentFrameLoaded(stateId, range, image);
+    }, [thisPtr, stateId, relFrame]() {
+        if(thisPtr) thisPtr->persistentFrameFailed(stateId, relFrame);
+    });
+    mPersistentLoads << relFrame;
+    loader->queTask();
+    return true;
+}
+
+void Canvas::persistentFrameLoaded(const uint stateId, const FrameRange &range,
+                                   const sk_sp<SkImage> &image) {
+    for(int i = mPersistentLoads.count() - 1; i >= 0; i--) {
+        if(range.inRange(mPersistentLoads.at(i))) mPersistentLoads.removeAt(i);
+    }
+    if(stateId != mStateId) return;
+    if(mSceneFramesHandler->atFrame(range.fMin)) return;
+    const auto cont = enve::make_shared<SceneFrameContainer>(
+                this, image, stateId, mResolution, range,
+                mSceneFramesHandler);
+    mSceneFramesHandler->add(cont);
+    compactPreviewFrame(cont.get(), range.fMin);
+    if(range.inRange(anim_getCurrentRelFrame())) {
+        mSceneFrameOutdated = false;
+        if(!mPreviewing && !mRenderingOutput) setSceneFrame(cont);
+    }
+}
+
+void Canvas::persistentFrameFailed(const uint stateId, const int relFrame) {
+    mPersistentLoads.removeOne(relFrame);
+    if(stateId != mStateId) return;
+    mPersistentMisses << relFrame;
+    // the render handler may already wait for this frame
+    queRender(relFrame, getInheritedTransformAtFrame(relFrame));
+}
+
+void Canvas::compactPreviewFrame(SceneFrameContainer * const cont,
+                                 const int relFrame)
+{
+    // only frames kept for playback, output and scrubbing stay RGBA
+    if (!mRenderingPreview || mRenderingOutput) { return; }
+    const bool opaque = mBackgroundColor->getColor(relFrame).alpha() == 255;
+    cont->scheduleCompaction(CompactFrame::sFormatFor(opaque));
+}
+
+void Canvas::drawSceneFrame(SkCanvas * const canvas,
+                            const SkFilterQuality filter)
+{
+    if (!CompactFrame::sNeedsUnpacking(mSceneFrame->format())) {
+        mSceneFrame->drawImage(canvas, filter);
+        return;
+    }
+    const auto& packed = mSceneFrame->getImage();
+    if (packed != mUnpackedSceneFrameSource) {
+        mUnpackedSceneFrameSource = packed;
+        mUnpackedSceneFrame = mSceneFrame->rgbaImage();
+    }
+    SkPaint paint;
+    paint.setFilterQuality(filter);
+    canvas->drawImage(mUnpackedSceneFrame, 0, 0, &paint);
+}
+
 void Canvas::prp_afterChangedAbsRange(const FrameRange &range, const bool clip) {
     Property::prp_afterChangedAbsRange(range, clip);
-    mSceneFramesHandler.remove(range);
-    if(!mSceneFramesHandler.atFrame(anim_getCurrentRelFrame())) {
+    for(const auto& cache : mSceneFrameCaches) cache.second->remove(range);
+    if(!mSceneFramesHandler->atFrame(anim_getCurrentRelFrame())) {
         mSceneFrameOutdated = true;
         planUpdate(UpdateReason::userChange);
     }
@@ -1212,9 +1540,11 @@ void Canvas::anim_setAbsFrame(const int frame)
 {
     if (frame == anim_getCurrentAbsFrame()) { return; }
     ContainerBox::anim_setAbsFrame(frame);
+    mPlayhead.frameChanged(frame);
     const int newRelFrame = anim_getCurrentRelFrame();
+    mSceneFramesHandler->setFocusFrame(newRelFrame);
 
-    const auto cont = mSceneFramesHandler.atFrame<SceneFrameContainer>(newRelFrame);
+    const auto cont = mSceneFramesHandler->atFrame<SceneFrameContainer>(newRelFrame);
     if (cont) {
         if (cont->storesDataInMemory()) {
             setSceneFrame(cont->ref<SceneFrameContainer>());
@@ -1223,6 +1553,8 @@ void Canvas::anim_setAbsFrame(const int frame)
         }
         mSceneFrameOutdated = !cont->storesDataInMemory();
     } else {
+        const auto higher = higherResolutionFrame(newRelFrame);
+        if (higher) { setSceneFrame(higher->ref<SceneFrameContainer>()); }
         mSceneFrameOutdated = true;
         planUpdate(UpdateReason::frameChange);
     }
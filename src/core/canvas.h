@@ -48,8 +48,11 @@
 #include <QVector>
 #include <QTransform>
 #include <vector>
+#include <map>
+#include <memory>
 
 #include "gizmos.h"
+#include "playheadpredictor.h"
 
 class AnimatedSurface;
 //class PaintBox;
@@ -63,6 +66,7 @@ class ImageSequenceBox;
 class Brush;
 class UndoRedoStack;
 class ExternalLinkBox;
+class QCryptographicHash;
 struct ShaderEffectCreator;
 class VideoBox;
 class ImageBox;
@@ -533,7 +537,7 @@ public:
     //void updatePixmaps();
     HddCachableCacheHandler &getSceneFramesHandler()
     {
-        return mSceneFramesHandler;
+        return *mSceneFramesHandler;
     }
 
     HddCachableCacheHandler &getSoundCacheHandler();
@@ -544,6 +548,11 @@ public:
 
     void setRenderingPreview(const bool bT);
 
+    bool isRenderingOutput() const
+    {
+        return mRenderingOutput;
+    }
+
     bool isPreviewingOrRendering() const
     {
         return mPreviewing || mRenderingPreview || mRenderingOutput;
@@ -609,6 +618,7 @@ public:
     }
 
     void renderDataFinished(BoxRenderData *renderData);
+    QByteArray persistentCacheKey(const FrameRange& range);
     FrameRange prp_getIdenticalRelRange(const int relFrame) const;
 
     void writeSettings(eWriteStream &dst) const;
@@ -704,17 +714,17 @@ public:
 
     void setMinFrameUseRange(const int min)
     {
-        mSceneFramesHandler.setMinUseRange(min);
+        mSceneFramesHandler->setMinUseRange(min);
     }
 
     void setMaxFrameUseRange(const int max)
     {
-        mSceneFramesHandler.setMaxUseRange(max);
+        mSceneFramesHandler->setMaxUseRange(max);
     }
 
     void clearUseRange()
     {
-        mSceneFramesHandler.clearUseRange();
+        mSceneFramesHandler->clearUseRange();
     }
 
     void setGizmosSuppressed(bool suppressed);
@@ -722,10 +732,7 @@ public:
     //! Used for clip to canvas, when frames are not really changed.
     void sceneFramesUpToDate() const
     {
-        for (const auto &cont : mSceneFramesHandler) {
-            const auto sceneCont = static_cast<SceneFrameContainer*>(cont.second.get());
-            sceneCont->fBoxState = mStateId;
-        }
+        restampSceneFrames(0, true);
     }
 
     void addSelectedForGraph(const int widgetId,
@@ -864,7 +871,48 @@ protected:
     bool mStylusDrawing = false;
 
     uint mLastStateId = 0;
-    HddCachableCacheHandler mSceneFramesHandler;
+    //! Scene frames cached at each preview resolution, keyed by
+    //! resolutionKey(). mSceneFramesHandler is the one for mResolution.
+    std::map<int, std::unique_ptr<HddCachableCacheHandler>> mSceneFrameCaches;
+    HddCachableCacheHandler* mSceneFramesHandler = nullptr;
+
+    static int resolutionKey(const qreal resolution);
+    HddCachableCacheHandler* sceneFramesAt(const qreal resolution) const;
+    void switchSceneFramesResolution(const qreal resolution);
+    SceneFrameContainer* higherResolutionFrame(const int relFrame) const;
+    void restampSceneFrames(const uint fromState, const bool all) const;
+
+    bool usePersistentCache() const;
+    bool quePersistentFrame(const int relFrame);
+    void persistentFrameLoaded(const uint stateId, const FrameRange& range,
+                               const sk_sp<SkImage>& image);
+    void persistentFrameFailed(const uint stateId, const int relFrame);
+
+    int predictionWindow() const;
+    void quePredictedFrames();
+
+    void compactPreviewFrame(SceneFrameContainer* const cont,
+                             const int relFrame);
+    void drawSceneFrame(SkCanvas* const canvas,
+                        const SkFilterQuality filter);
+
+    PlayheadPredictor mPlayhead;
+
+    // last compact frame drawn and its RGBA expansion
+    sk_sp<SkImage> mUnpackedSceneFrameSource;
+    sk_sp<SkImage> mUnpackedSceneFrame;
+
+    const QByteArray& persistentSceneHash();
+    void addPersistentContentHash(QCryptographicHash& hash,
+                                  QList<const Canvas*>& visited);
+
+    QByteArray mPersistentSceneHash;
+    uint mPersistentHashStateId = 0;
+    QStringList mPersistentFiles;
+    QList<qptr<Canvas>> mPersistentLinkedScenes;
+    QList<int> mPersistentLoads;
+    QList<int> mPersistentMisses;
+    uint mPersistentMissesStateId = 0;
 
     qsptr<ColorAnimator> mBackgroundColor = enve::make_shared<ColorAnimator>();
 
@@ -26,6 +26,8 @@
 #include "exceptions.h"
 #include <QMessageBox>
 
+static bool gExceptionDialogs = true;
+
 std::string operator+(const std::string& c, const QString& k) {
     return c + k.toStdString();
 }
@@ -90,8 +92,16 @@ QString gAllTextFromException(const std::exception &e,
     return allText;
 }
 
+void gSetExceptionDialogs(const bool enabled) {
+    gExceptionDialogs = enabled;
+}
+
 void gPrintException(const bool fatal, const QString &allText) {
     const QString txt = fatal ? "Fatal" : "Critical";
+    if(!gExceptionDialogs) {
+        qCritical().noquote() << txt + " Error:" << allText;
+        return;
+    }
     const auto icon = fatal ? QMessageBox::Critical : QMessageBox::Warning;
     QMessageBox(icon, txt + " Error", allText).exec();
 }
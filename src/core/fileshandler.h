@@ -39,6 +39,8 @@ public:
     template <typename T>
     T *getFileHandler(const QString &filePath);
     bool removeFileHandler(const qsptr<FileCacheHandler> &fh);
+    const QList<qsptr<FileCacheHandler>>& fileHandlers() const
+    { return mFileHandlers; }
 
     static FilesHandler* sInstance;
 private:    
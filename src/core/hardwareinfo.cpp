@@ -111,9 +111,10 @@ const QPair<GpuVendor, QStringList> gpuVendor()
     return QPair<GpuVendor, QStringList>(gpu, specs);
 }
 
-void HardwareInfo::sUpdateInfo() {
+void HardwareInfo::sUpdateInfo(const bool queryGpu) {
     mCpuThreads = QThread::idealThreadCount();
     mRamKB = getTotalRamBytes();
+    if(!queryGpu) return;
     const auto gpu = gpuVendor();
     mGpuVendor = gpu.first;
     mGpuVendorString = gpu.second.at(0);
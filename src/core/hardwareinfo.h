@@ -33,7 +33,7 @@
 class CORE_EXPORT HardwareInfo {
     HardwareInfo() = delete;
 public:
-    static void sUpdateInfo();
+    static void sUpdateInfo(const bool queryGpu = true);
 
     static int sCpuThreads() { return mCpuThreads; }
     static intKB sRamKB() { return mRamKB; }
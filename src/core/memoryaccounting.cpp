@@ -0,0 +1,121 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "memoryaccounting.h"
+
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include <QCoreApplication>
+
+#include <algorithm>
+
+namespace {
+    struct Registry {
+        QMutex fMutex;
+        QSet<MemoryAccounting::Tag*> fTags;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+}
+
+QString MemoryAccounting::sCategoryName(const Category category) {
+    switch(category) {
+    case Category::sceneFrames:
+        return QCoreApplication::translate("MemoryAccounting", "Scene Frames");
+    case Category::mediaFrames:
+        return QCoreApplication::translate("MemoryAccounting", "Images and Video");
+    case Category::sound:
+        return QCoreApplication::translate("MemoryAccounting", "Sound");
+    case Category::decoding:
+        return QCoreApplication::translate("MemoryAccounting", "Video Decoding");
+    case Category::rendering:
+        return QCoreApplication::translate("MemoryAccounting", "Rendering");
+    default:
+        return QCoreApplication::translate("MemoryAccounting", "Other");
+    }
+}
+
+MemoryAccounting::Tag::Tag(const Category category, const QString &owner) :
+    mCategory(category), mOwner(owner) {
+    auto& reg = registry();
+    QMutexLocker lock(&reg.fMutex);
+    reg.fTags.insert(this);
+}
+
+MemoryAccounting::Tag::~Tag() {
+    auto& reg = registry();
+    QMutexLocker lock(&reg.fMutex);
+    reg.fTags.remove(this);
+}
+
+void MemoryAccounting::Tag::setCategory(const Category category) {
+    QMutexLocker lock(&registry().fMutex);
+    mCategory = category;
+}
+
+void MemoryAccounting::Tag::setOwner(const QString &owner) {
+    QMutexLocker lock(&registry().fMutex);
+    mOwner = owner;
+}
+
+void MemoryAccounting::Tag::setBytes(const qint64 bytes) {
+    QMutexLocker lock(&registry().fMutex);
+    mBytes = bytes;
+}
+
+QList<MemoryAccounting::Usage> MemoryAccounting::sUsage() {
+    QMap<QPair<int, QString>, Usage> grouped;
+    {
+        auto& reg = registry();
+        QMutexLocker lock(&reg.fMutex);
+        for(const auto tag : reg.fTags) {
+            if(tag->mBytes <= 0) continue;
+            const QPair<int, QString> key{int(tag->mCategory), tag->mOwner};
+            auto it = grouped.find(key);
+            if(it == grouped.end()) {
+                it = grouped.insert(key, {tag->mCategory, tag->mOwner, 0, 0});
+            }
+            it->fBytes += tag->mBytes;
+            it->fCount++;
+        }
+    }
+    auto result = grouped.values();
+    std::sort(result.begin(), result.end(), [](const Usage& a, const Usage& b) {
+        return a.fBytes > b.fBytes;
+    });
+    return result;
+}
+
+qint64 MemoryAccounting::sTotal(const Category category) {
+    auto& reg = registry();
+    QMutexLocker lock(&reg.fMutex);
+    qint64 result = 0;
+    for(const auto tag : reg.fTags) {
+        if(tag->mCategory == category) result += tag->mBytes;
+    }
+    return result;
+}
@@ -0,0 +1,78 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <QList>
+#include <QString>
+
+#include "core_global.h"
+
+//! @brief Live totals of the memory held by caches and in flight buffers,
+//! split by category and by the scene, box or file that owns it.
+class CORE_EXPORT MemoryAccounting {
+public:
+    enum class Category {
+        sceneFrames, // rendered scene frames
+        mediaFrames, // decoded video frames and images
+        sound, // audio sample buffers
+        decoding, // frames held by video decoders
+        rendering, // box bitmaps being rendered
+        other,
+        count
+    };
+
+    static QString sCategoryName(const Category category);
+
+    //! @brief Bytes held by one allocation, safe to update from any thread.
+    class CORE_EXPORT Tag {
+        friend class MemoryAccounting;
+    public:
+        Tag(const Category category, const QString& owner = QString());
+        Tag(const Tag&) = delete;
+        Tag& operator=(const Tag&) = delete;
+        ~Tag();
+
+        void setCategory(const Category category);
+        void setOwner(const QString& owner);
+        void setBytes(const qint64 bytes);
+    private:
+        Category mCategory;
+        QString mOwner;
+        qint64 mBytes = 0;
+    };
+
+    struct Usage {
+        Category fCategory;
+        QString fOwner;
+        qint64 fBytes;
+        int fCount;
+    };
+
+    //! @brief Totals grouped by category and owner, largest first.
+    static QList<Usage> sUsage();
+    static qint64 sTotal(const Category category);
+};
+
+#endif // MEMORYACCOUNTING_H
@@ -34,11 +34,14 @@ MemoryDataHandler::MemoryDataHandler() {
 }
 
 void MemoryDataHandler::addContainer(CacheContainer * const cont) {
-    mContainers << cont;
+    // reached from the CacheContainer constructor, the real priority
+    // is only known once the container is complete, see updatePriorities
+    cont->mEvictionBase = mInflation;
+    insert(cont, mInflation);
 }
 
 void MemoryDataHandler::removeContainer(CacheContainer * const cont) {
-    mContainers.removeOne(cont);
+    mContainers.erase(cont->mEvictionPos);
 }
 
 void MemoryDataHandler::containerUpdated(CacheContainer * const cont) {
@@ -46,8 +49,39 @@ void MemoryDataHandler::containerUpdated(CacheContainer * const cont) {
     addContainer(cont);
 }
 
-CacheContainer *MemoryDataHandler::takeFirst() {
-    const auto cont = mContainers.takeFirst();
+void MemoryDataHandler::priorityChanged(CacheContainer * const cont) {
+    removeContainer(cont);
+    insert(cont, evictionPriority(cont));
+}
+
+void MemoryDataHandler::insert(CacheContainer * const cont,
+                               const qreal priority) {
+    cont->mEvictionPos = mContainers.emplace(priority, cont);
+}
+
+qreal MemoryDataHandler::evictionPriority(CacheContainer * const cont) const {
+    // frames this far from the playhead are worth half as much
+    const qreal focusFalloff = 24;
+    const qreal kBytes = qMax(1, cont->getByteCount()/1024);
+    const qreal distance = cont->distanceFromFocus();
+    return cont->mEvictionBase + cont->mRecomputeCost/kBytes/
+                                 (1 + distance/focusFalloff);
+}
+
+void MemoryDataHandler::updatePriorities() {
+    std::multimap<qreal, CacheContainer*> containers;
+    std::swap(containers, mContainers);
+    for(const auto& entry : containers) {
+        const auto cont = entry.second;
+        insert(cont, evictionPriority(cont));
+    }
+}
+
+CacheContainer *MemoryDataHandler::takeCheapest() {
+    const auto first = mContainers.begin();
+    const auto cont = first->second;
+    mInflation = qMax(mInflation, first->first);
+    mContainers.erase(first);
     cont->mHandledByMemoryHandler = false;
     return cont;
 }
@@ -25,7 +25,8 @@
 
 #ifndef MEMORYDATAHANDLER_H
 #define MEMORYDATAHANDLER_H
-#include <QList>
+#include <map>
+#include <QtGlobal>
 
 #include "core_global.h"
 
@@ -40,11 +41,25 @@ public:
     void addContainer(CacheContainer * const cont);
     void removeContainer(CacheContainer * const cont);
     void containerUpdated(CacheContainer * const cont);
+    //! @brief Re-sorts the container after its recompute cost changed.
+    void priorityChanged(CacheContainer * const cont);
 
-    bool isEmpty() const { return mContainers.isEmpty(); }
-    CacheContainer* takeFirst();
+    //! @brief Re-sorts all containers, their distance from the frames
+    //! in use changes with the playhead and sizes change with the data.
+    void updatePriorities();
+
+    bool isEmpty() const { return mContainers.empty(); }
+    //! @brief Takes the container that is cheapest to lose, i.e. the one
+    //! with the lowest GreedyDual-Size priority weighted by its distance
+    //! from the frames in use, as of the last updatePriorities call.
+    CacheContainer* takeCheapest();
 private:
-    QList<CacheContainer*> mContainers;
+    qreal evictionPriority(CacheContainer * const cont) const;
+    void insert(CacheContainer * const cont, const qreal priority);
+
+    //! @brief Containers sorted by their priority when last updated.
+    std::multimap<qreal, CacheContainer*> mContainers;
+    qreal mInflation = 0;
 };
 
 #endif // MEMORYDATAHANDLER_H
@@ -24,6 +24,8 @@
 #include "ReadWrite/evformat.h"
 #include "appsupport.h"
 
+#include <QDir>
+
 using namespace Friction::Core;
 
 QList<qsptr<OutputSettingsProfile>> OutputSettingsProfile::sOutputProfiles;
@@ -346,6 +348,25 @@ OutputSettingsProfile *OutputSettingsProfile::sGetByName(const QString &name)
     return nullptr;
 }
 
+void OutputSettingsProfile::sLoadProfiles()
+{
+    if (sOutputProfilesLoaded) { return; }
+    sOutputProfilesLoaded = true;
+    QDir dirPath(AppSupport::getAppOutputProfilesPath());
+    dirPath.setSorting(QDir::SortFlag::Name);
+    for (const auto &fileInfo : dirPath.entryInfoList()) {
+        if (!fileInfo.isFile()) { continue; }
+        if (!fileInfo.completeSuffix().contains("conf")) { continue; }
+        const auto profile = enve::make_shared<OutputSettingsProfile>();
+        try {
+            profile->load(fileInfo.absoluteFilePath());
+        } catch(const std::exception& e) {
+            gPrintExceptionCritical(e);
+        }
+        sOutputProfiles << profile;
+    }
+}
+
 FormatOptions OutputSettingsProfile::toFormatOptions(const FormatOptionsList &list)
 {
     FormatOptions options;
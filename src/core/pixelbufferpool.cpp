@@ -0,0 +1,144 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "pixelbufferpool.h"
+
+#include <QMutex>
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+
+#include "skia/skiahelpers.h"
+#include "memoryaccounting.h"
+#include "Private/esettings.h"
+
+namespace {
+    // smaller bitmaps are cheap enough for the allocator
+    const size_t sMinPooledBytes = 256*1024;
+
+    struct Pool {
+        QMutex fMutex;
+        std::map<size_t, std::vector<void*>> fIdle;
+        qint64 fIdleBytes = 0;
+        qint64 fIdleCap = 0;
+        MemoryAccounting::Tag fTag{MemoryAccounting::Category::rendering,
+                                   "Pixel buffer pool"};
+    };
+
+    // never destroyed, images may give buffers back during shutdown
+    Pool& pool() {
+        static Pool* const instance = new Pool;
+        return *instance;
+    }
+
+    // four classes per power of two, at most a fifth of a buffer is unused
+    size_t sizeClass(const size_t bytes) {
+        size_t power = 1;
+        while(power < bytes) power <<= 1;
+        const size_t step = power/8;
+        return (bytes + step - 1)/step*step;
+    }
+
+    qint64 idleCap() {
+        const qint64 ramBytes = qint64(eSettings::sRamMBCap().fValue)*1024*1024;
+        return ramBytes/16;
+    }
+
+    void releaseBuffer(void* addr, void* context) {
+        const auto bytes = static_cast<size_t>(
+                    reinterpret_cast<uintptr_t>(context));
+        auto& p = pool();
+        {
+            QMutexLocker lock(&p.fMutex);
+            if(p.fIdleBytes + qint64(bytes) <= p.fIdleCap) {
+                p.fIdle[bytes].push_back(addr);
+                p.fIdleBytes += bytes;
+                p.fTag.setBytes(p.fIdleBytes);
+                return;
+            }
+        }
+        std::free(addr);
+    }
+}
+
+bool PixelBufferPool::sTryAllocPixels(SkBitmap &bitmap,
+                                      const SkImageInfo &info) {
+    const size_t rowBytes = info.minRowBytes();
+    const size_t bytes = info.computeByteSize(rowBytes);
+    if(SkImageInfo::ByteSizeOverflowed(bytes) || bytes < sMinPooledBytes) {
+        return bitmap.tryAllocPixels(info);
+    }
+    const size_t size = sizeClass(bytes);
+    void* pixels = nullptr;
+    auto& p = pool();
+    {
+        QMutexLocker lock(&p.fMutex);
+        p.fIdleCap = idleCap();
+        const auto it = p.fIdle.find(size);
+        if(it != p.fIdle.end() && !it->second.empty()) {
+            pixels = it->second.back();
+            it->second.pop_back();
+            p.fIdleBytes -= size;
+            p.fTag.setBytes(p.fIdleBytes);
+        }
+    }
+    if(!pixels) pixels = std::malloc(size);
+    if(!pixels) return false;
+    const auto context = reinterpret_cast<void*>(static_cast<uintptr_t>(size));
+    return bitmap.installPixels(info, pixels, rowBytes, releaseBuffer, context);
+}
+
+sk_sp<SkImage> PixelBufferPool::sMakeRasterImage(const sk_sp<SkImage> &image) {
+    if(!image) return nullptr;
+    if(!image->isTextureBacked()) return image->makeRasterImage();
+    SkBitmap bitmap;
+    if(sTryAllocPixels(bitmap, image->imageInfo()) &&
+       image->readPixels(bitmap.pixmap(), 0, 0)) {
+        return SkiaHelpers::transferDataToSkImage(bitmap);
+    }
+    return image->makeRasterImage();
+}
+
+qint64 PixelBufferPool::sClear() {
+    std::map<size_t, std::vector<void*>> idle;
+    qint64 bytes;
+    {
+        auto& p = pool();
+        QMutexLocker lock(&p.fMutex);
+        idle.swap(p.fIdle);
+        bytes = p.fIdleBytes;
+        p.fIdleBytes = 0;
+        p.fTag.setBytes(0);
+    }
+    for(const auto& bucket : idle) {
+        for(const auto pixels : bucket.second) std::free(pixels);
+    }
+    return bytes;
+}
+
+qint64 PixelBufferPool::sIdleBytes() {
+    auto& p = pool();
+    QMutexLocker lock(&p.fMutex);
+    return p.fIdleBytes;
+}
@@ -0,0 +1,46 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef PIXELBUFFERPOOL_H
+#define PIXELBUFFERPOOL_H
+
+#include "skia/skiaincludes.h"
+#include "core_global.h"
+
+//! @brief Recycles large pixel buffers between bitmaps of similar size.
+//! Buffers are bucketed by size and go back to the pool once the last
+//! bitmap or image using them is gone, on whichever thread that happens.
+class CORE_EXPORT PixelBufferPool {
+    PixelBufferPool() = delete;
+public:
+    //! @brief Like SkBitmap::tryAllocPixels, pooled for large bitmaps.
+    static bool sTryAllocPixels(SkBitmap& bitmap, const SkImageInfo& info);
+    //! @brief Like SkImage::makeRasterImage, into a pooled buffer.
+    static sk_sp<SkImage> sMakeRasterImage(const sk_sp<SkImage>& image);
+
+    //! @brief Frees all idle buffers, returns the number of bytes freed.
+    static qint64 sClear();
+    static qint64 sIdleBytes();
+};
+
+#endif // PIXELBUFFERPOOL_H
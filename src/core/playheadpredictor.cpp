@@ -0,0 +1,114 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "playheadpredictor.h"
+
+// moves longer than this are jumps rather than scrubbing
+static const int sJumpFrames = 12;
+// frames around each marker worth having after a marker jump
+static const int sMarkerFrames = 3;
+
+void PlayheadPredictor::frameChanged(const int frame) {
+    const qint64 ms = mTimer.isValid() ? mTimer.restart() : 0;
+    if(!mTimer.isValid()) mTimer.start();
+    if(!mHasFrame) {
+        mHasFrame = true;
+        mFrame = frame;
+        return;
+    }
+    const int delta = frame - mFrame;
+    mFrame = frame;
+    if(delta == 0) return;
+
+    const qreal expected = qAbs(mVelocity)*ms/1000.;
+    if(qAbs(delta) > qMax(qreal(sJumpFrames), 2*expected)) {
+        // jumping back to where the previous jump back landed is a loop
+        if(delta < 0) {
+            const FrameRange wrap{frame, frame - delta};
+            if(mLastWrap.isValid() &&
+               qAbs(mLastWrap.fMin - wrap.fMin) <= 1 &&
+               qAbs(mLastWrap.fMax - wrap.fMax) <= 2) {
+                mLoop = {wrap.fMin, qMax(wrap.fMax, mLastWrap.fMax)};
+            }
+            mLastWrap = wrap;
+        }
+        // keep the velocity, playback continues after a loop or a jump
+        mJumped = true;
+        return;
+    }
+    mJumped = false;
+    if(mLoop.isValid() && !mLoop.inRange(frame)) mLoop = FrameRange::INVALID;
+
+    const qreal instant = delta*1000./qBound(qint64(1), ms, qint64(1000));
+    if(mVelocity*instant <= 0) mVelocity = instant;
+    else mVelocity = 0.6*mVelocity + 0.4*instant;
+}
+
+FrameRange PlayheadPredictor::loopRange() const {
+    if(mLoop.isValid()) return mLoop;
+    if(mLoopHint.isValid() && mLoopHint.inRange(mFrame)) return mLoopHint;
+    return FrameRange::INVALID;
+}
+
+int PlayheadPredictor::wrapFrame(const int frame,
+                                 const FrameRange& loop) const {
+    if(!loop.isValid()) return frame;
+    const int span = loop.span();
+    if(frame > loop.fMax) return loop.fMin + (frame - loop.fMax - 1) % span;
+    if(frame < loop.fMin) return loop.fMax - (loop.fMin - frame - 1) % span;
+    return frame;
+}
+
+QList<int> PlayheadPredictor::window(const int maxFrames) const {
+    QList<int> result;
+    if(!mHasFrame || maxFrames <= 0) return result;
+    const auto loop = loopRange();
+    const int maxCount = loop.isValid() ? qMin(maxFrames, loop.span() - 1) :
+                                          maxFrames;
+    const auto add = [&](const int frame) {
+        if(result.count() >= maxCount) return;
+        const int wrapped = wrapFrame(frame, loop);
+        if(wrapped == mFrame || !mBounds.inRange(wrapped)) return;
+        if(result.contains(wrapped)) return;
+        result << wrapped;
+    };
+
+    // after a jump between markers the next jump is likely to follow
+    if(mJumped && mMarkers.contains(mFrame)) {
+        for(const int marker : mMarkers) {
+            if(marker == mFrame) continue;
+            for(int i = 0; i < sMarkerFrames; i++) add(marker + i);
+        }
+    }
+
+    const int dir = mVelocity < 0 ? -1 : 1;
+    // the faster the playhead moves, the less likely it turns around
+    const int aheadPerBehind = qBound(1, qRound(qAbs(mVelocity)/8), 8);
+    int ahead = 1;
+    int behind = 1;
+    for(int i = 0; result.count() < maxCount && i < 2*maxFrames; i++) {
+        for(int j = 0; j < aheadPerBehind; j++) add(mFrame + dir*ahead++);
+        add(mFrame - dir*behind++);
+    }
+    return result;
+}
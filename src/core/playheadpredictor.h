@@ -0,0 +1,68 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef PLAYHEADPREDICTOR_H
+#define PLAYHEADPREDICTOR_H
+
+#include <QList>
+#include <QElapsedTimer>
+
+#include "framerange.h"
+
+//! @brief Guesses which frames the user will look at next from how the
+//! playhead moved so far. Follows scrubbing in both directions, detects
+//! loops and favors markers after jumps between them.
+class CORE_EXPORT PlayheadPredictor {
+public:
+    //! @brief Has to be called every time the playhead moves.
+    void frameChanged(const int frame);
+
+    void setBounds(const FrameRange& bounds) { mBounds = bounds; }
+    //! @brief Range played in a loop, e.g. the work area, INVALID if none.
+    void setLoopHint(const FrameRange& range) { mLoopHint = range; }
+    void setMarkers(const QList<int>& frames) { mMarkers = frames; }
+
+    //! @brief Frames per second, negative when going backwards.
+    qreal velocity() const { return mVelocity; }
+
+    //! @brief Up to maxFrames frames around the playhead,
+    //! most likely to be needed first.
+    QList<int> window(const int maxFrames) const;
+private:
+    FrameRange loopRange() const;
+    int wrapFrame(const int frame, const FrameRange& loop) const;
+
+    QElapsedTimer mTimer;
+    bool mHasFrame = false;
+    bool mJumped = false;
+    int mFrame = 0;
+    qreal mVelocity = 0;
+
+    FrameRange mBounds = FrameRange::EMINMAX;
+    FrameRange mLoopHint = FrameRange::INVALID;
+    FrameRange mLoop = FrameRange::INVALID;
+    FrameRange mLastWrap = FrameRange::INVALID;
+    QList<int> mMarkers;
+};
+
+#endif // PLAYHEADPREDICTOR_H
@@ -28,6 +28,8 @@
 #include "Boxes/boxrendercontainer.h"
 #include "CacheHandlers/sceneframecontainer.h"
 #include "canvas.h"
+#include "Private/esettings.h"
+#include "yuvconverter.h"
 
 #define AV_RuntimeThrow(errId, message) \
 { \
@@ -136,6 +138,25 @@ bool VideoEncoder::isValidProfile(const AVCodec *codec,
     return false;
 }
 
+// The encoder thread may still reference the previous buffer,
+// give the frame a new one instead of copying the old content.
+static void renewFrameBuffer(AVFrame * const frame) {
+    if(av_frame_is_writable(frame)) return;
+    AVFrame * const props = av_frame_alloc();
+    if(!props) RuntimeThrow("Could not allocate frame");
+    av_frame_move_ref(props, frame);
+    frame->format = props->format;
+    frame->width = props->width;
+    frame->height = props->height;
+    frame->nb_samples = props->nb_samples;
+    frame->channel_layout = props->channel_layout;
+    frame->channels = props->channels;
+    frame->sample_rate = props->sample_rate;
+    av_frame_free(&props);
+    const int ret = av_frame_get_buffer(frame, 0);
+    if(ret < 0) AV_RuntimeThrow(ret, "Could not allocate frame data")
+}
+
 static AVFrame *allocPicture(enum AVPixelFormat pix_fmt,
                              const int width, const int height) {
     AVFrame * const picture = av_frame_alloc();
@@ -155,6 +176,10 @@ static AVFrame *allocPicture(enum AVPixelFormat pix_fmt,
 static void openVideo(const AVCodec * const codec, OutputStream * const ost) {
     AVCodecContext * const c = ost->fCodec;
     ost->fNextPts = 0;
+    // encoding has a thread of its own,
+    // the codec can still split the work further
+    c->thread_count = eSettings::instance().fEncoderThreads;
+    c->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
     /* open the codec */
     int ret = avcodec_open2(c, codec, nullptr);
     if(ret < 0) AV_RuntimeThrow(ret, "Could not open codec")
@@ -186,6 +211,56 @@ static void openVideo(const AVCodec * const codec, OutputStream * const ost) {
     if(ret < 0) AV_RuntimeThrow(ret, "Could not copy the stream parameters")
 }
 
+// everything the codec context takes from the settings,
+// shared by the stream codec and the parallel frame encoders
+static void configureVideoCodec(AVCodecContext * const c,
+                                const AVFormatContext * const oc,
+                                const OutputSettings &outSettings,
+                                const RenderSettings &renSettings) {
+    /* Put sample parameters. */
+    c->bit_rate = outSettings.fVideoBitrate;//settings->getVideoBitrate();
+    /* Resolution must be a multiple of two. */
+    c->width    = renSettings.fVideoWidth;
+    c->height   = renSettings.fVideoHeight;
+    /* timebase: This is the fundamental unit of time (in seconds) in terms
+     * of which frame timestamps are represented. For fixed-fps content,
+     * timebase should be 1/framerate and timestamp increments should be
+     * identical to 1. */
+    const AVRational targetFps = av_inv_q(renSettings.fTimeBase);
+    if(targetFps.num > 0 && targetFps.den > 0) c->framerate = targetFps;
+    c->ticks_per_frame = 1;
+
+    c->time_base       = renSettings.fTimeBase;
+
+    if (VideoEncoder::isValidProfile(c->codec,
+                                     outSettings.fVideoProfile)) {
+        c->profile = outSettings.fVideoProfile;
+    }
+
+    for (const auto &opt : outSettings.fVideoOptions.fValues) {
+        if (opt.fType != FormatType::fTypeCodec) { continue; }
+        av_opt_set(c->priv_data,
+                   opt.fKey.toStdString().c_str(),
+                   opt.fValue.toStdString().c_str(), 0);
+    }
+
+    c->gop_size      = VideoEncoder::sGopSize; /* emit one intra frame every sGopSize frames at most */
+    c->pix_fmt       = outSettings.fVideoPixelFormat;//RGBA;
+    if(c->codec_id == AV_CODEC_ID_MPEG2VIDEO) {
+        /* just for testing, we also add B-frames */
+        c->max_b_frames = 2;
+    } else if(c->codec_id == AV_CODEC_ID_MPEG1VIDEO) {
+        /* Needed to avoid using macroblocks in which some coeffs overflow.
+         * This does not happen with normal video, it just happens here as
+         * the motion of the chroma plane does not match the luma plane. */
+        c->mb_decision = 2;
+    }
+    /* Some formats want stream headers to be separate. */
+    if(oc->oformat->flags & AVFMT_GLOBALHEADER) {
+        c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+}
+
 static void addVideoStream(OutputStream * const ost,
                            AVFormatContext * const oc,
                            const OutputSettings &outSettings,
@@ -209,39 +284,18 @@ static void addVideoStream(OutputStream * const ost,
 
     ost->fCodec = c;
 
-    /* Put sample parameters. */
-    c->bit_rate = outSettings.fVideoBitrate;//settings->getVideoBitrate();
-    /* Resolution must be a multiple of two. */
-    c->width    = renSettings.fVideoWidth;
-    c->height   = renSettings.fVideoHeight;
-    /* timebase: This is the fundamental unit of time (in seconds) in terms
-     * of which frame timestamps are represented. For fixed-fps content,
-     * timebase should be 1/framerate and timestamp increments should be
-     * identical to 1. */
     ost->fStream->time_base = renSettings.fTimeBase;
 
     const AVRational targetFps = av_inv_q(renSettings.fTimeBase);
     if(targetFps.num > 0 && targetFps.den > 0) {
         ost->fStream->avg_frame_rate = targetFps;
         ost->fStream->r_frame_rate = targetFps;
-        c->framerate = targetFps;
     }
-    c->ticks_per_frame = 1;
-
-    c->time_base       = ost->fStream->time_base;
 
-    if (VideoEncoder::isValidProfile(codec,
-                                     outSettings.fVideoProfile)) {
-        c->profile = outSettings.fVideoProfile;
-    }
+    configureVideoCodec(c, oc, outSettings, renSettings);
 
     for (const auto &opt : outSettings.fVideoOptions.fValues) {
         switch (opt.fType) {
-        case FormatType::fTypeCodec:
-            av_opt_set(c->priv_data,
-                       opt.fKey.toStdString().c_str(),
-                       opt.fValue.toStdString().c_str(), 0);
-            break;
         case FormatType::fTypeFormat:
             av_opt_set(oc->priv_data,
                        opt.fKey.toStdString().c_str(),
@@ -255,22 +309,6 @@ static void addVideoStream(OutputStream * const ost,
         default:;
         }
     }
-
-    c->gop_size      = 12; /* emit one intra frame every twelve frames at most */
-    c->pix_fmt       = outSettings.fVideoPixelFormat;//RGBA;
-    if(c->codec_id == AV_CODEC_ID_MPEG2VIDEO) {
-        /* just for testing, we also add B-frames */
-        c->max_b_frames = 2;
-    } else if(c->codec_id == AV_CODEC_ID_MPEG1VIDEO) {
-        /* Needed to avoid using macroblocks in which some coeffs overflow.
-         * This does not happen with normal video, it just happens here as
-         * the motion of the chroma plane does not match the luma plane. */
-        c->mb_decision = 2;
-    }
-    /* Some formats want stream headers to be separate. */
-    if(oc->oformat->flags & AVFMT_GLOBALHEADER) {
-        c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-    }
 }
 
 static AVFrame *getVideoFrame(OutputStream * const ost,
@@ -282,6 +320,20 @@ static AVFrame *getVideoFrame(OutputStream * const ost,
 //                      STREAM_DURATION, (AVRational) { 1, 1 }) >= 0)
 //        return nullptr;
 
+    // common export formats skip swscale, unpremultiplying where needed
+    SkPixmap rgbaPixmap;
+    if(YuvConverter::sSupports(c->pix_fmt) &&
+       image->peekPixels(&rgbaPixmap) &&
+       rgbaPixmap.colorType() == kRGBA_8888_SkColorType &&
+       rgbaPixmap.alphaType() != kUnpremul_SkAlphaType &&
+       rgbaPixmap.width() == c->width &&
+       rgbaPixmap.height() == c->height) {
+        renewFrameBuffer(ost->fDstFrame);
+        YuvConverter::sConvert(rgbaPixmap, ost->fDstFrame);
+        ost->fDstFrame->pts = ost->fNextPts++;
+        return ost->fDstFrame;
+    }
+
     /* as we only generate a rgba picture, we must convert it
      * to the codec pixel format if needed */
     if(!ost->fSwsCtx) {
@@ -322,8 +374,7 @@ static AVFrame *getVideoFrame(OutputStream * const ost,
     int linesizesSk[4];
 
     av_image_fill_linesizes(linesizesSk, AV_PIX_FMT_RGBA, image->width());
-    const int ret = av_frame_make_writable(ost->fDstFrame) ;
-    if(ret < 0) AV_RuntimeThrow(ret, "Could not make AVFrame writable")
+    renewFrameBuffer(ost->fDstFrame);
 
     sws_scale(ost->fSwsCtx, dstSk,
               linesizesSk, 0, c->height, ost->fDstFrame->data,
@@ -334,58 +385,6 @@ static AVFrame *getVideoFrame(OutputStream * const ost,
     return ost->fDstFrame;
 }
 
-static void writeVideoFrame(AVFormatContext * const oc,
-                            OutputStream * const ost,
-                            const sk_sp<SkImage> &image,
-                            bool * const encodeVideo) {
-    AVCodecContext * const c = ost->fCodec;
-
-    AVFrame * frame;
-    try {
-        frame = getVideoFrame(ost, image);
-    } catch(...) {
-        RuntimeThrow("Failed to retrieve video frame");
-    }
-
-
-    // encode the image
-    const int ret = avcodec_send_frame(c, frame);
-    if(ret < 0) AV_RuntimeThrow(ret, "Error submitting a frame for encoding")
-
-    while(ret >= 0) {
-        AVPacket pkt;
-        av_init_packet(&pkt);
-
-        const int recRet = avcodec_receive_packet(c, &pkt);
-        if(recRet >= 0) {
-            av_packet_rescale_ts(&pkt, c->time_base, ost->fStream->time_base);
-            // if we did not set frame duration earlier, do it now
-            if(ost->fFrameDuration <= 0) {
-                AVRational frameBase;
-                if(ost->fStream->avg_frame_rate.num > 0 && ost->fStream->avg_frame_rate.den > 0)
-                    frameBase = av_inv_q(ost->fStream->avg_frame_rate);
-                else
-                    frameBase = c->time_base;
-                ost->fFrameDuration = av_rescale_q(1, frameBase, ost->fStream->time_base);
-                if(ost->fFrameDuration <= 0) ost->fFrameDuration = 1;
-            }
-            pkt.duration = ost->fFrameDuration;
-            pkt.stream_index = ost->fStream->index;
-
-            // Write the compressed frame to the media file.
-            const int interRet = av_interleaved_write_frame(oc, &pkt);
-            if(interRet < 0) AV_RuntimeThrow(interRet, "Error while writing video frame")
-        } else if(recRet == AVERROR(EAGAIN) || recRet == AVERROR_EOF) {
-            *encodeVideo = ret != AVERROR_EOF;
-            break;
-        } else {
-            AV_RuntimeThrow(recRet, "Error encoding a video frame")
-        }
-
-        av_packet_unref(&pkt);
-    }
-}
-
 static void addAudioStream(OutputStream * const ost,
                            AVFormatContext * const oc,
                            const OutputSettings &settings,
@@ -507,43 +506,10 @@ static void openAudio(const AVCodec * const codec, OutputStream * const ost,
     if(parRet < 0) AV_RuntimeThrow(parRet, "Could not copy the stream parameters")
 }
 
-/* if a frame is provided, send it to the encoder, otherwise flush the encoder;
- * return 1 when encoding is finished, 0 otherwise
- */
-static void encodeAudioFrame(AVFormatContext * const oc,
-                             OutputStream * const ost,
-                             AVFrame * const frame,
-                             bool * const encodeAudio) {
-    const int ret = avcodec_send_frame(ost->fCodec, frame);
-    if(ret < 0) AV_RuntimeThrow(ret, "Error submitting a frame for encoding")
-
-    while(true) {
-        AVPacket pkt;
-        av_init_packet(&pkt);
-
-        const int recRet = avcodec_receive_packet(ost->fCodec, &pkt);
-        if(recRet >= 0) {
-            av_packet_rescale_ts(&pkt, ost->fCodec->time_base, ost->fStream->time_base);
-            pkt.stream_index = ost->fStream->index;
-
-            /* Write the compressed frame to the media file. */
-            const int interRet = av_interleaved_write_frame(oc, &pkt);
-            if(interRet < 0) AV_RuntimeThrow(interRet, "Error while writing audio frame")
-        } else if(recRet == AVERROR(EAGAIN) || recRet == AVERROR_EOF) {
-            *encodeAudio = recRet == AVERROR(EAGAIN);
-            break;
-        } else {
-            AV_RuntimeThrow(recRet, "Error encoding an audio frame")
-        }
-    }
-}
-
-static void processAudioStream(AVFormatContext * const oc,
-                               OutputStream * const ost,
-                               SoundIterator &iterator,
-                               bool * const audioEnabled) {
+static AVFrame *getAudioFrame(OutputStream * const ost,
+                              SoundIterator &iterator) {
+    renewFrameBuffer(ost->fSrcFrame);
     iterator.fillFrame(ost->fSrcFrame);
-    bool gotOutput = ost->fSrcFrame;
 
 //    const int nb_samples =
 //            swr_convert(ost->fSwrCtx,
@@ -558,13 +524,7 @@ static void processAudioStream(AVFormatContext * const oc,
     ost->fSrcFrame->pts = ost->fNextPts;
     ost->fNextPts += ost->fSrcFrame->nb_samples;
 
-    try {
-        encodeAudioFrame(oc, ost, ost->fSrcFrame, &gotOutput);
-    } catch(...) {
-        RuntimeThrow("Error while encoding audio frame");
-    }
-
-    *audioEnabled = gotOutput;
+    return ost->fSrcFrame;
 }
 
 #include "Sound/soundcomposition.h"
@@ -619,6 +579,9 @@ void VideoEncoder::startEncodingNow() {
     if(mEncodeVideo) {
         try {
             openVideo(mOutputSettings.fVideoCodec, &mVideoStream);
+            const int encoders = sParallelEncoders(mOutputSettings.fVideoCodec);
+            if(encoders > 1) createFrameEncoders(encoders);
+            else freeFrameEncoders();
         } catch (...) {
             RuntimeThrow("Error opening video stream");
         }
@@ -644,6 +607,307 @@ void VideoEncoder::startEncodingNow() {
     const int whRet = avformat_write_header(mFormatContext, nullptr);
     if(whRet < 0) AV_RuntimeThrow(whRet,
                                   "Could not write header to " + mPathByteArray.data())
+    startPipeline();
+}
+
+void VideoEncoder::startPipeline() {
+    mPipelineAbort = false;
+    mPipelineFailed = false;
+    mPipelineException = nullptr;
+    mEncodeQue.setup(sPipelineDepth);
+    mMuxQue.setup(4*sPipelineDepth);
+    if(!mFrameEncoders.empty()) startFrameEncoders();
+    mEncodeThread = std::thread(&VideoEncoder::encodeLoop, this);
+    mMuxThread = std::thread(&VideoEncoder::muxLoop, this);
+}
+
+void VideoEncoder::stopPipeline(const bool flush) {
+    if(!mEncodeThread.joinable()) return;
+    if(!flush) mPipelineAbort = true;
+    mEncodeQue.push(EncoderItem());
+    mEncodeThread.join();
+    mMuxThread.join();
+}
+
+void VideoEncoder::pushEncoderItem(OutputStream * const ost,
+                                   AVFrame * const frame) {
+    AVFrame * const ref = av_frame_clone(frame);
+    if(!ref) RuntimeThrow("Could not reference frame");
+    mEncodeQue.push({ref, ost});
+}
+
+void VideoEncoder::setPipelineException(const std::exception_ptr &e) {
+    std::lock_guard<std::mutex> lk(mPipelineMutex);
+    if(mPipelineFailed) return;
+    mPipelineException = e;
+    mPipelineFailed = true;
+}
+
+void VideoEncoder::checkPipeline() {
+    if(!mPipelineFailed) return;
+    std::lock_guard<std::mutex> lk(mPipelineMutex);
+    std::rethrow_exception(mPipelineException);
+}
+
+static void setupFrameDuration(OutputStream * const ost,
+                               const AVCodecContext * const c) {
+    if(ost->fFrameDuration <= 0) {
+        AVRational frameBase;
+        if(ost->fStream->avg_frame_rate.num > 0 && ost->fStream->avg_frame_rate.den > 0)
+            frameBase = av_inv_q(ost->fStream->avg_frame_rate);
+        else
+            frameBase = c->time_base;
+        ost->fFrameDuration = av_rescale_q(1, frameBase, ost->fStream->time_base);
+        if(ost->fFrameDuration <= 0) ost->fFrameDuration = 1;
+    }
+}
+
+static void setupVideoPacket(OutputStream * const ost,
+                             const AVCodecContext * const c,
+                             AVPacket * const pkt) {
+    av_packet_rescale_ts(pkt, c->time_base, ost->fStream->time_base);
+    // if we did not set frame duration earlier, do it now
+    setupFrameDuration(ost, c);
+    pkt->duration = ost->fFrameDuration;
+    pkt->stream_index = ost->fStream->index;
+}
+
+void VideoEncoder::encodeFrame(OutputStream * const ost,
+                               AVFrame * const frame) {
+    AVCodecContext * const c = ost->fCodec;
+    const bool video = ost == &mVideoStream;
+    // a nullptr frame drains the codec
+    const int ret = avcodec_send_frame(c, frame);
+    if(ret < 0) AV_RuntimeThrow(ret, "Error submitting a frame for encoding")
+
+    while(true) {
+        AVPacket *pkt = av_packet_alloc();
+        if(!pkt) RuntimeThrow("Could not allocate packet");
+        const int recRet = avcodec_receive_packet(c, pkt);
+        if(recRet == AVERROR(EAGAIN) || recRet == AVERROR_EOF) {
+            av_packet_free(&pkt);
+            break;
+        } else if(recRet < 0) {
+            av_packet_free(&pkt);
+            AV_RuntimeThrow(recRet, video ? "Error encoding a video frame" :
+                                            "Error encoding an audio frame")
+        }
+        if(video) {
+            setupVideoPacket(ost, c, pkt);
+        } else {
+            av_packet_rescale_ts(pkt, c->time_base, ost->fStream->time_base);
+            pkt->stream_index = ost->fStream->index;
+        }
+        mMuxQue.push(pkt);
+    }
+}
+
+void VideoEncoder::encodeLoop() {
+    const bool parallel = !mFrameEncoders.empty();
+    while(true) {
+        EncoderItem item;
+        mEncodeQue.pop(item);
+        const bool stop = !item.fStream;
+        // frame encoders are stopped and their packets written either way
+        if(stop && parallel) stopFrameEncoders();
+        if(!stop && parallel && item.fStream == &mVideoStream) {
+            dispatchVideoFrame(item.fFrame);
+            continue;
+        }
+        // after a failure or an interruption frames are only released
+        const bool skip = mPipelineAbort || mPipelineFailed;
+        try {
+            if(stop) {
+                if(!skip && mEncodeVideo && !parallel) {
+                    encodeFrame(&mVideoStream, nullptr);
+                }
+                if(!skip && mEncodeAudio) encodeFrame(&mAudioStream, nullptr);
+            } else if(!skip) encodeFrame(item.fStream, item.fFrame);
+        } catch(...) {
+            setPipelineException(std::current_exception());
+        }
+        av_frame_free(&item.fFrame);
+        if(stop) break;
+    }
+    mMuxQue.push(nullptr);
+}
+
+bool VideoEncoder::sCanSplitFrames(const AVCodec *codec) {
+    // intra-only is not enough, huffyuv/ffvhuff with context and
+    // two-pass ffv1 carry state between frames and codecs with extradata
+    // would mux the one of the unused stream codec, only list codecs
+    // that code every frame on its own without any extradata
+    if(!codec) return false;
+    switch(codec->id) {
+    case AV_CODEC_ID_PRORES:
+    case AV_CODEC_ID_DNXHD: // DNxHR is a DNxHD profile
+    case AV_CODEC_ID_MJPEG:
+    case AV_CODEC_ID_PNG:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int VideoEncoder::sParallelEncoders(const AVCodec *codec) {
+    // only frames coded on their own can be split between codecs
+    if(!sCanSplitFrames(codec)) return 1;
+    const int maxEncoders = 8;
+    const int setting = eSettings::instance().fParallelEncoders;
+    if(setting > 0) return qMin(setting, maxEncoders);
+    return qBound(1, eSettings::sCpuThreadsCapped()/4, maxEncoders);
+}
+
+void VideoEncoder::createFrameEncoders(const int count) {
+    freeFrameEncoders();
+    const AVCodec * const codec = mOutputSettings.fVideoCodec;
+    const AVCodecContext * const first = mVideoStream.fCodec;
+    const int encoderThreads = eSettings::instance().fEncoderThreads;
+    const int threads = encoderThreads > 0 ? encoderThreads :
+                        qMax(1, eSettings::sCpuThreadsCapped()/count);
+    for(int i = 0; i < count; i++) {
+        mFrameEncoders.push_back(std::make_unique<FrameEncoder>());
+        AVCodecContext * const c = avcodec_alloc_context3(codec);
+        if(!c) RuntimeThrow("Could not alloc an encoding context");
+        mFrameEncoders.back()->fCodec = c;
+        configureVideoCodec(c, mFormatContext, mOutputSettings,
+                            mRenderSettings);
+        // as openVideo adjusted the stream codec
+        c->time_base = first->time_base;
+        c->framerate = first->framerate;
+        c->ticks_per_frame = first->ticks_per_frame;
+        c->thread_count = threads;
+        // frame threads would hold frames back and stall the round robin
+        c->thread_type = FF_THREAD_SLICE;
+        const int ret = avcodec_open2(c, codec, nullptr);
+        if(ret < 0) AV_RuntimeThrow(ret, "Could not open codec")
+    }
+}
+
+void VideoEncoder::freeFrameEncoders() {
+    for(const auto& enc : mFrameEncoders) {
+        avcodec_free_context(&enc->fCodec);
+    }
+    mFrameEncoders.clear();
+}
+
+void VideoEncoder::startFrameEncoders() {
+    mDispatchedFrames = 0;
+    mCollectedFrames = 0;
+    // set here, the encoder threads only read it
+    setupFrameDuration(&mVideoStream, mVideoStream.fCodec);
+    for(const auto& enc : mFrameEncoders) {
+        enc->fFrames.setup(2);
+        enc->fPackets.setup(sPipelineDepth);
+        enc->fThread = std::thread(&VideoEncoder::frameEncoderLoop,
+                                   this, enc.get());
+    }
+}
+
+void VideoEncoder::stopFrameEncoders() {
+    for(const auto& enc : mFrameEncoders) {
+        int spins = 0;
+        while(!enc->fFrames.tryPush(nullptr)) {
+            collectVideoPackets(false);
+            SpscQue<AVFrame*>::sBackoff(spins);
+        }
+    }
+    collectVideoPackets(true);
+    for(const auto& enc : mFrameEncoders) {
+        if(enc->fThread.joinable()) enc->fThread.join();
+    }
+}
+
+void VideoEncoder::dispatchVideoFrame(AVFrame * const frame) {
+    const auto count = static_cast<qint64>(mFrameEncoders.size());
+    const auto& enc = mFrameEncoders[size_t(mDispatchedFrames % count)];
+    int spins = 0;
+    // the encoder might be waiting for its packets to be taken
+    while(!enc->fFrames.tryPush(frame)) {
+        collectVideoPackets(false);
+        SpscQue<AVFrame*>::sBackoff(spins);
+    }
+    mDispatchedFrames++;
+    collectVideoPackets(false);
+}
+
+void VideoEncoder::collectVideoPackets(const bool all) {
+    const auto count = static_cast<qint64>(mFrameEncoders.size());
+    int spins = 0;
+    while(mCollectedFrames < mDispatchedFrames) {
+        const auto& enc = mFrameEncoders[size_t(mCollectedFrames % count)];
+        AVPacket *pkt = nullptr;
+        if(!enc->fPackets.tryPop(pkt)) {
+            if(!all) return;
+            SpscQue<AVPacket*>::sBackoff(spins);
+            continue;
+        }
+        mCollectedFrames++;
+        if(pkt) mMuxQue.push(pkt);
+    }
+}
+
+void VideoEncoder::frameEncoderLoop(FrameEncoder * const enc) {
+    AVCodecContext * const c = enc->fCodec;
+    // frames sent to the codec that did not come back as a packet yet
+    int pending = 0;
+    bool failed = false;
+    while(true) {
+        AVFrame *frame = nullptr;
+        enc->fFrames.pop(frame);
+        failed = failed || mPipelineAbort || mPipelineFailed;
+        try {
+            if(!failed) {
+                // a nullptr frame drains the codec
+                if(frame) pending++;
+                const int ret = avcodec_send_frame(c, frame);
+                if(ret < 0) AV_RuntimeThrow(ret, "Error submitting a frame for encoding")
+                while(true) {
+                    AVPacket *pkt = av_packet_alloc();
+                    if(!pkt) RuntimeThrow("Could not allocate packet");
+                    const int recRet = avcodec_receive_packet(c, pkt);
+                    if(recRet == AVERROR(EAGAIN) || recRet == AVERROR_EOF) {
+                        av_packet_free(&pkt);
+                        break;
+                    } else if(recRet < 0) {
+                        av_packet_free(&pkt);
+                        AV_RuntimeThrow(recRet, "Error encoding a video frame")
+                    }
+                    setupVideoPacket(&mVideoStream, c, pkt);
+                    enc->fPackets.push(pkt);
+                    pending--;
+                }
+            } else if(frame) {
+                enc->fPackets.push(nullptr);
+            }
+        } catch(...) {
+            setPipelineException(std::current_exception());
+            failed = true;
+        }
+        if(!frame) break;
+        av_frame_free(&frame);
+    }
+    // stand-ins for packets that will not come keep the collector in step
+    for(; pending > 0; pending--) enc->fPackets.push(nullptr);
+}
+
+void VideoEncoder::muxLoop() {
+    while(true) {
+        AVPacket *pkt = nullptr;
+        mMuxQue.pop(pkt);
+        if(!pkt) break;
+        if(!mPipelineAbort && !mPipelineFailed) {
+            const int ret = av_interleaved_write_frame(mFormatContext, pkt);
+            if(ret < 0) {
+                try {
+                    AV_RuntimeThrow(ret, "Error while writing frame")
+                } catch(...) {
+                    setPipelineException(std::current_exception());
+                }
+            }
+        }
+        av_packet_free(&pkt);
+    }
 }
 
 bool VideoEncoder::startEncoding(RenderInstanceSettings * const settings) {
@@ -679,51 +943,21 @@ void VideoEncoder::interrupEncoding() {
 }
 
 void VideoEncoder::finishEncodingSuccess() {
+    // frames still in the pipeline have to be encoded and written first
+    stopPipeline(true);
+    if(mPipelineFailed) {
+        gPrintExceptionCritical(mPipelineException);
+        mRenderInstanceSettings->setCurrentState(RenderState::error, "Error");
+        finishEncodingNow();
+        mEmitter.encodingFailed();
+        return;
+    }
     mRenderInstanceSettings->setCurrentState(RenderState::finished);
     mEncodingSuccesfull = true;
     finishEncodingNow();
     mEmitter.encodingFinished();
 }
 
-static void flushStream(OutputStream * const ost,
-                        AVFormatContext * const formatCtx) {
-    if(!ost) return;
-    if(!ost->fCodec) return;
-    AVPacket pkt;
-    av_init_packet(&pkt);
-    int ret = avcodec_send_frame(ost->fCodec, nullptr);
-    while(ret >= 0) {
-        ret = avcodec_receive_packet(ost->fCodec, &pkt);
-        if(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            // Write packet
-            avcodec_flush_buffers(ost->fCodec);
-            break;
-        }
-        if(ret < 0) AV_RuntimeThrow(ret, "Error encoding a video frame during flush");
-
-        if(pkt.pts != AV_NOPTS_VALUE)
-            pkt.pts = av_rescale_q(pkt.pts, ost->fCodec->time_base,
-                                   ost->fStream->time_base);
-        if(pkt.dts != AV_NOPTS_VALUE)
-            pkt.dts = av_rescale_q(pkt.dts, ost->fCodec->time_base,
-                                   ost->fStream->time_base);
-        if(ost->fFrameDuration <= 0) {
-            // if we did not set frame duration earlier, do it now
-            AVRational frameBase;
-            if(ost->fStream->avg_frame_rate.num > 0 && ost->fStream->avg_frame_rate.den > 0)
-                frameBase = av_inv_q(ost->fStream->avg_frame_rate);
-            else
-                frameBase = ost->fCodec->time_base;
-            ost->fFrameDuration = av_rescale_q(1, frameBase, ost->fStream->time_base);
-            if(ost->fFrameDuration <= 0) ost->fFrameDuration = 1;
-        }
-        // set duration if not set
-        pkt.duration = ost->fFrameDuration;
-        pkt.stream_index = ost->fStream->index;
-        ret = av_interleaved_write_frame(formatCtx, &pkt);
-    }
-}
-
 static void closeStream(OutputStream * const ost) {
     if(!ost) return;
     if(ost->fCodec) {
@@ -740,8 +974,8 @@ static void closeStream(OutputStream * const ost) {
 void VideoEncoder::finishEncodingNow() {
     if(!mCurrentlyEncoding) return;
 
-    if(mEncodeVideo) flushStream(&mVideoStream, mFormatContext);
-    if(mEncodeAudio) flushStream(&mAudioStream, mFormatContext);
+    // no-op if the pipeline was already drained
+    stopPipeline(false);
 
     // set the number of frames in the video stream
     if(mEncodeVideo && mVideoStream.fStream && mVideoStream.fCodec) {
@@ -757,6 +991,7 @@ void VideoEncoder::finishEncodingNow() {
 
     /* Close each codec. */
     if(mEncodeVideo) closeStream(&mVideoStream);
+    freeFrameEncoders();
     if(mEncodeAudio) closeStream(&mAudioStream);
 
     if(mOutputFormat) {
@@ -788,6 +1023,7 @@ void VideoEncoder::clearContainers() {
 }
 
 void VideoEncoder::process() {
+    checkPipeline();
     bool hasVideo = !_mContainers.isEmpty(); // local encode
     bool hasAudio;
     if(mEncodeAudio) {
@@ -811,9 +1047,9 @@ void VideoEncoder::process() {
             const auto contRange = cacheCont->getRange()*_mRenderRange;
             const int nFrames = contRange.span();
             try {
-                writeVideoFrame(mFormatContext, &mVideoStream,
-                                cacheCont->getImage(), &hasVideo);
-                avcodec_flush_buffers(mVideoStream.fCodec);
+                pushEncoderItem(&mVideoStream,
+                                getVideoFrame(&mVideoStream,
+                                              cacheCont->rgbaImage()));
             } catch(...) {
                 RuntimeThrow("Failed to write video frame");
             }
@@ -833,9 +1069,9 @@ void VideoEncoder::process() {
         const bool encodeAudio = mEncodeAudio && hasAudio && audioAligned;
         if(encodeAudio) {
             try {
-                processAudioStream(mFormatContext, &mAudioStream,
-                                   mSoundIterator, &hasAudio);
-                avcodec_flush_buffers(mAudioStream.fCodec);
+                pushEncoderItem(&mAudioStream,
+                                getAudioFrame(&mAudioStream,
+                                              mSoundIterator));
             } catch(...) {
                 RuntimeThrow("Failed to process audio stream");
             }
@@ -843,6 +1079,7 @@ void VideoEncoder::process() {
                                             mSoundIterator.hasSamples(mAudioStream.fSrcFrame->nb_samples);
         }
         if(!encodeVideo && !encodeAudio) break;
+        checkPipeline();
     }
 }
 
@@ -902,6 +1139,172 @@ bool VideoEncoder::sEncodeAudio() {
     return sInstance->mEncodeAudio;
 }
 
+bool VideoEncoder::sEncodeVideo() {
+    return sInstance->mEncodeVideo;
+}
+
+bool VideoEncoder::sIsIntraOnly(const AVCodec *codec) {
+    if(!codec) return false;
+    const auto desc = avcodec_descriptor_get(codec->id);
+    return desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY);
+}
+
+struct MuxInput {
+    ~MuxInput() {
+        if(fCtx) avformat_close_input(&fCtx);
+    }
+
+    void open(const QString &path, const AVMediaType type) {
+        const QByteArray pathData = path.toUtf8();
+        const int openRet = avformat_open_input(&fCtx, pathData.constData(),
+                                                nullptr, nullptr);
+        if(openRet < 0) AV_RuntimeThrow(openRet,
+                                        "Could not open " + pathData.constData())
+        const int infoRet = avformat_find_stream_info(fCtx, nullptr);
+        if(infoRet < 0) AV_RuntimeThrow(infoRet,
+                                        "Could not read streams from " + pathData.constData())
+        fStreamId = av_find_best_stream(fCtx, type, -1, -1, nullptr, 0);
+        if(fStreamId < 0) RuntimeThrow("No stream found in " + pathData.constData());
+        fStream = fCtx->streams[fStreamId];
+    }
+
+    // returns false at the end of the file
+    bool readPacket(AVPacket * const pkt) {
+        while(av_read_frame(fCtx, pkt) >= 0) {
+            if(pkt->stream_index == fStreamId) return true;
+            av_packet_unref(pkt);
+        }
+        return false;
+    }
+
+    AVFormatContext *fCtx = nullptr;
+    AVStream *fStream = nullptr;
+    int fStreamId = -1;
+};
+
+static AVStream *addCopyStream(AVFormatContext * const oc,
+                               const AVStream * const src) {
+    AVStream * const dst = avformat_new_stream(oc, nullptr);
+    if(!dst) RuntimeThrow("Could not allocate stream");
+    const int copyRet = avcodec_parameters_copy(dst->codecpar, src->codecpar);
+    if(copyRet < 0) AV_RuntimeThrow(copyRet, "Could not copy codec parameters")
+    dst->codecpar->codec_tag = 0;
+    dst->time_base = src->time_base;
+    dst->avg_frame_rate = src->avg_frame_rate;
+    dst->r_frame_rate = src->r_frame_rate;
+    return dst;
+}
+
+void VideoEncoder::sMuxSegments(const QStringList &videoSegments,
+                                const QString &audioFile,
+                                const QString &output,
+                                const AVOutputFormat *format) {
+    if(videoSegments.isEmpty()) RuntimeThrow("No segments to mux");
+    const QByteArray outputData = output.toUtf8();
+
+    MuxInput firstSegment;
+    firstSegment.open(videoSegments.first(), AVMEDIA_TYPE_VIDEO);
+    MuxInput audio;
+    if(!audioFile.isEmpty()) audio.open(audioFile, AVMEDIA_TYPE_AUDIO);
+
+    AVFormatContext *oc = nullptr;
+    const int allocRet = avformat_alloc_output_context2(
+                &oc, const_cast<AVOutputFormat*>(format),
+                nullptr, outputData.constData());
+    if(allocRet < 0) AV_RuntimeThrow(allocRet, "Could not allocate output context")
+    AVPacket *pkt = av_packet_alloc();
+    AVPacket *audioPkt = av_packet_alloc();
+    const auto cleanup = [&]() {
+        av_packet_free(&pkt);
+        av_packet_free(&audioPkt);
+        if(!(oc->oformat->flags & AVFMT_NOFILE)) avio_closep(&oc->pb);
+        avformat_free_context(oc);
+    };
+
+    try {
+        AVStream * const videoStream = addCopyStream(oc, firstSegment.fStream);
+        AVStream * const audioStream = audio.fCtx ?
+                    addCopyStream(oc, audio.fStream) : nullptr;
+        if(!(oc->oformat->flags & AVFMT_NOFILE)) {
+            const int avioRet = avio_open(&oc->pb, outputData.constData(),
+                                          AVIO_FLAG_WRITE);
+            if(avioRet < 0) AV_RuntimeThrow(avioRet,
+                                            "Could not open " + outputData.constData())
+        }
+        const int whRet = avformat_write_header(oc, nullptr);
+        if(whRet < 0) AV_RuntimeThrow(whRet,
+                                      "Could not write header to " + outputData.constData())
+
+        const AVRational videoTb = videoStream->time_base;
+        const int64_t frameDuration = qMax<int64_t>(1, av_rescale_q(
+                    1, av_inv_q(firstSegment.fStream->avg_frame_rate), videoTb));
+
+        bool hasAudioPkt = audioStream && audio.readPacket(audioPkt);
+        // writes audio up to the given video time, interleaving by hand
+        // keeps the muxer from buffering a whole segment of video
+        const auto writeAudioUntil = [&](const int64_t videoDts) {
+            while(hasAudioPkt) {
+                const auto audioInTb = audio.fStream->time_base;
+                if(videoDts != AV_NOPTS_VALUE &&
+                   av_compare_ts(audioPkt->dts, audioInTb,
+                                 videoDts, videoTb) > 0) break;
+                av_packet_rescale_ts(audioPkt, audioInTb, audioStream->time_base);
+                audioPkt->stream_index = audioStream->index;
+                audioPkt->pos = -1;
+                const int wRet = av_interleaved_write_frame(oc, audioPkt);
+                if(wRet < 0) AV_RuntimeThrow(wRet, "Error writing audio packet")
+                hasAudioPkt = audio.readPacket(audioPkt);
+            }
+        };
+
+        int64_t offset = 0;
+        int64_t lastDts = AV_NOPTS_VALUE;
+        for(int i = 0; i < videoSegments.count(); i++) {
+            MuxInput nextSegment;
+            MuxInput& segment = i == 0 ? firstSegment : nextSegment;
+            if(i > 0) segment.open(videoSegments.at(i), AVMEDIA_TYPE_VIDEO);
+            const auto segmentTb = segment.fStream->time_base;
+            int64_t segmentEnd = offset;
+            int64_t shift = offset;
+            bool firstPacket = true;
+            while(segment.readPacket(pkt)) {
+                av_packet_rescale_ts(pkt, segmentTb, videoTb);
+                // reordered codecs start each segment with negative dts,
+                // the whole segment is shifted past the last dts written
+                // so that pts >= dts still holds for every packet
+                if(firstPacket) {
+                    firstPacket = false;
+                    if(pkt->dts != AV_NOPTS_VALUE && lastDts != AV_NOPTS_VALUE) {
+                        shift = qMax(shift, lastDts + 1 - pkt->dts);
+                    }
+                }
+                if(pkt->pts != AV_NOPTS_VALUE) pkt->pts += shift;
+                if(pkt->dts != AV_NOPTS_VALUE) pkt->dts += shift;
+                if(pkt->dts != AV_NOPTS_VALUE) lastDts = pkt->dts;
+                const int64_t duration = pkt->duration > 0 ?
+                            pkt->duration : frameDuration;
+                if(pkt->pts != AV_NOPTS_VALUE) {
+                    segmentEnd = qMax(segmentEnd, pkt->pts + duration);
+                }
+                writeAudioUntil(pkt->dts);
+                pkt->stream_index = videoStream->index;
+                pkt->pos = -1;
+                const int wRet = av_interleaved_write_frame(oc, pkt);
+                if(wRet < 0) AV_RuntimeThrow(wRet, "Error writing video packet")
+            }
+            offset = segmentEnd;
+        }
+        writeAudioUntil(AV_NOPTS_VALUE);
+
+        const int wtRet = av_write_trailer(oc);
+        if(wtRet < 0) AV_RuntimeThrow(wtRet, "Could not write trailer")
+    } catch(...) {
+        cleanup();
+        RuntimeThrow("Could not mux segments to " + outputData.constData());
+    }
+    cleanup();
+}
+
 void VideoEncoder::sInterruptEncoding() {
     sInstance->interruptCurrentEncoding();
 }
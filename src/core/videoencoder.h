@@ -30,12 +30,20 @@
 
 #include <QString>
 #include <QList>
+#include <QStringList>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <memory>
+#include <vector>
 #include "skia/skiaincludes.h"
 #include "Tasks/updatable.h"
 #include "renderinstancesettings.h"
 #include "framerange.h"
 #include "CacheHandlers/samples.h"
 #include "Sound/esoundsettings.h"
+#include "Private/spscque.h"
 
 extern "C" {
     #include <libavcodec/avcodec.h>
@@ -225,6 +233,18 @@ public:
     static void sFinishEncoding();
     static bool sEncodingSuccessfulyStarted();
     static bool sEncodeAudio();
+    static bool sEncodeVideo();
+
+    // every keyframe interval starts a new GOP, see addVideoStream
+    static const int sGopSize = 12;
+    static bool sIsIntraOnly(const AVCodec *codec);
+    // Joins separately encoded video segments and an optional audio
+    // file into output without re-encoding. Video segments have to
+    // start on a keyframe and share codec parameters.
+    static void sMuxSegments(const QStringList &videoSegments,
+                             const QString &audioFile,
+                             const QString &output,
+                             const AVOutputFormat *format);
 
     VideoEncoderEmitter *getEmitter() {
         return &mEmitter;
@@ -242,6 +262,54 @@ protected:
     bool startEncoding(RenderInstanceSettings * const settings);
     void startEncodingNow();
 
+    // Frames are converted in process(), encoded on mEncodeThread and
+    // written on mMuxThread. The stages hand over through bounded ques.
+    struct EncoderItem {
+        AVFrame *fFrame = nullptr;
+        OutputStream *fStream = nullptr; // nullptr flushes and stops
+    };
+    static const int sPipelineDepth = 8;
+
+    void startPipeline();
+    void stopPipeline(const bool flush);
+    void pushEncoderItem(OutputStream * const ost, AVFrame * const frame);
+    void setPipelineException(const std::exception_ptr &e);
+    void checkPipeline();
+    void encodeFrame(OutputStream * const ost, AVFrame * const frame);
+    void encodeLoop();
+    void muxLoop();
+
+    // Intra-only video is dealt round robin to several codec instances,
+    // frame n goes to mFrameEncoders[n % count] and its packet is
+    // collected from there in the same order.
+    struct FrameEncoder {
+        AVCodecContext *fCodec = nullptr;
+        SpscQue<AVFrame*> fFrames; // nullptr drains and stops
+        SpscQue<AVPacket*> fPackets; // nullptr stands in for a lost packet
+        std::thread fThread;
+    };
+    static bool sCanSplitFrames(const AVCodec *codec);
+    static int sParallelEncoders(const AVCodec *codec);
+    void createFrameEncoders(const int count);
+    void freeFrameEncoders();
+    void startFrameEncoders();
+    void stopFrameEncoders();
+    void dispatchVideoFrame(AVFrame * const frame);
+    void collectVideoPackets(const bool all);
+    void frameEncoderLoop(FrameEncoder * const enc);
+
+    SpscQue<EncoderItem> mEncodeQue;
+    SpscQue<AVPacket*> mMuxQue; // nullptr ends the stream
+    std::thread mEncodeThread;
+    std::thread mMuxThread;
+    std::atomic<bool> mPipelineAbort{false};
+    std::atomic<bool> mPipelineFailed{false};
+    std::mutex mPipelineMutex;
+    std::exception_ptr mPipelineException;
+    std::vector<std::unique_ptr<FrameEncoder>> mFrameEncoders;
+    qint64 mDispatchedFrames = 0;
+    qint64 mCollectedFrames = 0;
+
     bool mEncodingSuccesfull = false;
     bool mEncodingFinished = false;
     bool mInterruptEncoding = false;
@@ -0,0 +1,570 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "yuvconverter.h"
+
+#include <QElapsedTimer>
+#include <QDebug>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Private/esettings.h"
+
+extern "C" {
+    #include <libswscale/swscale.h>
+    #include <libavutil/imgutils.h>
+    #include <libavutil/pixdesc.h>
+}
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_M_X64) && defined(__AVX2__))
+    #define YUV_AVX2
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        // MSVC only emits AVX2 with /arch:AVX2, no runtime check needed
+        #define AVX2_TARGET
+    #else
+        #define AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#elif defined(__aarch64__)
+    #define YUV_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+// BT.601 limited range, the default swscale uses for RGB input
+const float kYR = 0.299f*219/255;
+const float kYG = 0.587f*219/255;
+const float kYB = 0.114f*219/255;
+const float kUR = -0.168736f*224/255;
+const float kUG = -0.331264f*224/255;
+const float kUB = 0.5f*224/255;
+const float kVR = 0.5f*224/255;
+const float kVG = -0.418688f*224/255;
+const float kVB = -0.081312f*224/255;
+
+// scale is 1 for 8 bit planes and 4 for 10 bit planes
+template <typename T>
+inline T toPlane(const float v, const float scale) {
+    const float maxV = 255*scale;
+    return static_cast<T>(std::lrint(std::min(std::max(v, 0.f), maxV)));
+}
+
+inline void rgbOf(const uint32_t px, float &r, float &g, float &b) {
+    r = px & 0xFF;
+    g = (px >> 8) & 0xFF;
+    b = (px >> 16) & 0xFF;
+}
+
+template <typename T>
+void lumaRowScalar(const uint32_t * const src, const int n,
+                   T * const dstY, const float scale) {
+    for(int i = 0; i < n; i++) {
+        float r, g, b;
+        rgbOf(src[i], r, g, b);
+        dstY[i] = toPlane<T>(scale*(16 + kYR*r + kYG*g + kYB*b), scale);
+    }
+}
+
+// Averages pixel pairs of two rows, pass the same row twice for 4:2:2.
+template <typename T>
+void chromaRowScalar(const uint32_t * const src0,
+                     const uint32_t * const src1,
+                     const int first, const int n, const int width,
+                     T * const dstU, T * const dstV, const float scale) {
+    for(int i = first; i < n; i++) {
+        const int x0 = 2*i;
+        const int x1 = std::min(x0 + 1, width - 1);
+        float r = 0, g = 0, b = 0;
+        for(const uint32_t px : {src0[x0], src0[x1], src1[x0], src1[x1]}) {
+            float pr, pg, pb;
+            rgbOf(px, pr, pg, pb);
+            r += pr; g += pg; b += pb;
+        }
+        r *= 0.25f; g *= 0.25f; b *= 0.25f;
+        dstU[i] = toPlane<T>(scale*(128 + kUR*r + kUG*g + kUB*b), scale);
+        dstV[i] = toPlane<T>(scale*(128 + kVR*r + kVG*g + kVB*b), scale);
+    }
+}
+
+void yuvaRowScalar(const uint32_t * const src, const int first, const int n,
+                   uint8_t * const dstY, uint8_t * const dstU,
+                   uint8_t * const dstV, uint8_t * const dstA) {
+    for(int i = first; i < n; i++) {
+        float r, g, b;
+        rgbOf(src[i], r, g, b);
+        const uint32_t a = src[i] >> 24;
+        const float inv = a ? 255.f/a : 0.f;
+        r = std::min(r*inv, 255.f);
+        g = std::min(g*inv, 255.f);
+        b = std::min(b*inv, 255.f);
+        dstY[i] = toPlane<uint8_t>(16 + kYR*r + kYG*g + kYB*b, 1);
+        dstU[i] = toPlane<uint8_t>(128 + kUR*r + kUG*g + kUB*b, 1);
+        dstV[i] = toPlane<uint8_t>(128 + kVR*r + kVG*g + kVB*b, 1);
+        dstA[i] = static_cast<uint8_t>(a);
+    }
+}
+
+#ifdef YUV_AVX2
+bool hasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return true;
+#else
+    static const bool result = __builtin_cpu_supports("avx2");
+    return result;
+#endif
+}
+
+AVX2_TARGET inline void loadAvx2(const uint32_t * const src,
+                                 __m256 &r, __m256 &g, __m256 &b) {
+    const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    r = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+    g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+    b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+}
+
+AVX2_TARGET inline __m256 dotAvx2(const __m256 r, const __m256 g, const __m256 b,
+                                  const float cr, const float cg, const float cb,
+                                  const float offset, const float scale) {
+    __m256 v = _mm256_mul_ps(r, _mm256_set1_ps(cr*scale));
+    v = _mm256_add_ps(v, _mm256_mul_ps(g, _mm256_set1_ps(cg*scale)));
+    v = _mm256_add_ps(v, _mm256_mul_ps(b, _mm256_set1_ps(cb*scale)));
+    return _mm256_add_ps(v, _mm256_set1_ps(offset*scale));
+}
+
+AVX2_TARGET inline __m128i packAvx2(const __m256 v) {
+    const __m256i i = _mm256_cvtps_epi32(v);
+    return _mm_packus_epi32(_mm256_castsi256_si128(i),
+                            _mm256_extracti128_si256(i, 1));
+}
+
+AVX2_TARGET inline void storeAvx2(uint8_t * const dst, const __m256 v) {
+    const __m128i w = packAvx2(v);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(w, w));
+}
+
+AVX2_TARGET inline void storeAvx2(uint16_t * const dst, const __m256 v) {
+    const __m128i w = _mm_min_epu16(packAvx2(v), _mm_set1_epi16(1023));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), w);
+}
+
+// sums neighbouring lanes, a0 + a1, a2 + a3, ..., b6 + b7
+AVX2_TARGET inline __m256 pairSumAvx2(const __m256 a, const __m256 b) {
+    const __m256 h = _mm256_hadd_ps(a, b);
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(h),
+                                                  _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+template <typename T>
+AVX2_TARGET int lumaRowAvx2(const uint32_t * const src, const int n,
+                            T * const dstY, const float scale) {
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256 r, g, b;
+        loadAvx2(src + i, r, g, b);
+        storeAvx2(dstY + i, dotAvx2(r, g, b, kYR, kYG, kYB, 16, scale));
+    }
+    return i;
+}
+
+template <typename T>
+AVX2_TARGET int chromaRowAvx2(const uint32_t * const src0,
+                              const uint32_t * const src1,
+                              const int n, T * const dstU, T * const dstV,
+                              const float scale) {
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    int i = 0;
+    // only whole pixel pairs, an odd last column is left to the caller
+    for(; i + 8 <= n; i += 8) {
+        __m256 r0a, g0a, b0a, r0b, g0b, b0b;
+        __m256 r1a, g1a, b1a, r1b, g1b, b1b;
+        loadAvx2(src0 + 2*i, r0a, g0a, b0a);
+        loadAvx2(src0 + 2*i + 8, r0b, g0b, b0b);
+        loadAvx2(src1 + 2*i, r1a, g1a, b1a);
+        loadAvx2(src1 + 2*i + 8, r1b, g1b, b1b);
+        const __m256 r = _mm256_mul_ps(pairSumAvx2(_mm256_add_ps(r0a, r1a),
+                                                   _mm256_add_ps(r0b, r1b)), quarter);
+        const __m256 g = _mm256_mul_ps(pairSumAvx2(_mm256_add_ps(g0a, g1a),
+                                                   _mm256_add_ps(g0b, g1b)), quarter);
+        const __m256 b = _mm256_mul_ps(pairSumAvx2(_mm256_add_ps(b0a, b1a),
+                                                   _mm256_add_ps(b0b, b1b)), quarter);
+        storeAvx2(dstU + i, dotAvx2(r, g, b, kUR, kUG, kUB, 128, scale));
+        storeAvx2(dstV + i, dotAvx2(r, g, b, kVR, kVG, kVB, 128, scale));
+    }
+    return i;
+}
+
+AVX2_TARGET int yuvaRowAvx2(const uint32_t * const src, const int n,
+                            uint8_t * const dstY, uint8_t * const dstU,
+                            uint8_t * const dstV, uint8_t * const dstA) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 full = _mm256_set1_ps(255);
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256 r, g, b;
+        loadAvx2(src + i, r, g, b);
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256 a = _mm256_cvtepi32_ps(_mm256_srli_epi32(px, 24));
+        const __m256 visible = _mm256_cmp_ps(a, zero, _CMP_GT_OQ);
+        const __m256 inv = _mm256_and_ps(visible, _mm256_div_ps(full, a));
+        r = _mm256_min_ps(_mm256_mul_ps(r, inv), full);
+        g = _mm256_min_ps(_mm256_mul_ps(g, inv), full);
+        b = _mm256_min_ps(_mm256_mul_ps(b, inv), full);
+        storeAvx2(dstY + i, dotAvx2(r, g, b, kYR, kYG, kYB, 16, 1));
+        storeAvx2(dstU + i, dotAvx2(r, g, b, kUR, kUG, kUB, 128, 1));
+        storeAvx2(dstV + i, dotAvx2(r, g, b, kVR, kVG, kVB, 128, 1));
+        storeAvx2(dstA + i, a);
+    }
+    return i;
+}
+#endif
+
+#ifdef YUV_NEON
+struct NeonPixels {
+    float32x4_t fR[2];
+    float32x4_t fG[2];
+    float32x4_t fB[2];
+    float32x4_t fA[2];
+};
+
+inline void widenNeon(const uint8x8_t src, float32x4_t * const dst) {
+    const uint16x8_t w = vmovl_u8(src);
+    dst[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(w)));
+    dst[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(w)));
+}
+
+// loads eight pixels
+inline NeonPixels loadNeon(const uint32_t * const src) {
+    const uint8x8x4_t px = vld4_u8(reinterpret_cast<const uint8_t*>(src));
+    NeonPixels result;
+    widenNeon(px.val[0], result.fR);
+    widenNeon(px.val[1], result.fG);
+    widenNeon(px.val[2], result.fB);
+    widenNeon(px.val[3], result.fA);
+    return result;
+}
+
+inline float32x4_t dotNeon(const float32x4_t r, const float32x4_t g,
+                           const float32x4_t b,
+                           const float cr, const float cg, const float cb,
+                           const float offset, const float scale) {
+    float32x4_t v = vdupq_n_f32(offset*scale);
+    v = vmlaq_n_f32(v, r, cr*scale);
+    v = vmlaq_n_f32(v, g, cg*scale);
+    return vmlaq_n_f32(v, b, cb*scale);
+}
+
+inline uint16x8_t packNeon(const float32x4_t v0, const float32x4_t v1) {
+    return vcombine_u16(vqmovun_s32(vcvtnq_s32_f32(v0)),
+                        vqmovun_s32(vcvtnq_s32_f32(v1)));
+}
+
+inline void storeNeon(uint8_t * const dst, const float32x4_t v0,
+                      const float32x4_t v1) {
+    vst1_u8(dst, vqmovn_u16(packNeon(v0, v1)));
+}
+
+inline void storeNeon(uint16_t * const dst, const float32x4_t v0,
+                      const float32x4_t v1) {
+    vst1q_u16(dst, vminq_u16(packNeon(v0, v1), vdupq_n_u16(1023)));
+}
+
+template <typename T>
+int lumaRowNeon(const uint32_t * const src, const int n,
+                T * const dstY, const float scale) {
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        const auto px = loadNeon(src + i);
+        storeNeon(dstY + i,
+                  dotNeon(px.fR[0], px.fG[0], px.fB[0], kYR, kYG, kYB, 16, scale),
+                  dotNeon(px.fR[1], px.fG[1], px.fB[1], kYR, kYG, kYB, 16, scale));
+    }
+    return i;
+}
+
+// sums pixel pairs of 16 pixels from two rows into 8 values
+inline void pairSumNeon(const float32x4_t * const a0, const float32x4_t * const a1,
+                        const float32x4_t * const b0, const float32x4_t * const b1,
+                        float32x4_t * const dst) {
+    const float32x4_t quarter = vdupq_n_f32(0.25f);
+    dst[0] = vmulq_f32(vpaddq_f32(vaddq_f32(a0[0], b0[0]),
+                                  vaddq_f32(a0[1], b0[1])), quarter);
+    dst[1] = vmulq_f32(vpaddq_f32(vaddq_f32(a1[0], b1[0]),
+                                  vaddq_f32(a1[1], b1[1])), quarter);
+}
+
+template <typename T>
+int chromaRowNeon(const uint32_t * const src0,
+                  const uint32_t * const src1,
+                  const int n, T * const dstU, T * const dstV,
+                  const float scale) {
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        const auto p0a = loadNeon(src0 + 2*i);
+        const auto p0b = loadNeon(src0 + 2*i + 8);
+        const auto p1a = loadNeon(src1 + 2*i);
+        const auto p1b = loadNeon(src1 + 2*i + 8);
+        float32x4_t r[2], g[2], b[2];
+        pairSumNeon(p0a.fR, p0b.fR, p1a.fR, p1b.fR, r);
+        pairSumNeon(p0a.fG, p0b.fG, p1a.fG, p1b.fG, g);
+        pairSumNeon(p0a.fB, p0b.fB, p1a.fB, p1b.fB, b);
+        storeNeon(dstU + i,
+                  dotNeon(r[0], g[0], b[0], kUR, kUG, kUB, 128, scale),
+                  dotNeon(r[1], g[1], b[1], kUR, kUG, kUB, 128, scale));
+        storeNeon(dstV + i,
+                  dotNeon(r[0], g[0], b[0], kVR, kVG, kVB, 128, scale),
+                  dotNeon(r[1], g[1], b[1], kVR, kVG, kVB, 128, scale));
+    }
+    return i;
+}
+
+int yuvaRowNeon(const uint32_t * const src, const int n,
+                uint8_t * const dstY, uint8_t * const dstU,
+                uint8_t * const dstV, uint8_t * const dstA) {
+    const float32x4_t full = vdupq_n_f32(255);
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        auto px = loadNeon(src + i);
+        for(int j = 0; j < 2; j++) {
+            const uint32x4_t visible = vcgtq_f32(px.fA[j], vdupq_n_f32(0));
+            const float32x4_t inv = vreinterpretq_f32_u32(
+                        vandq_u32(visible, vreinterpretq_u32_f32(
+                                      vdivq_f32(full, px.fA[j]))));
+            px.fR[j] = vminq_f32(vmulq_f32(px.fR[j], inv), full);
+            px.fG[j] = vminq_f32(vmulq_f32(px.fG[j], inv), full);
+            px.fB[j] = vminq_f32(vmulq_f32(px.fB[j], inv), full);
+        }
+        storeNeon(dstY + i,
+                  dotNeon(px.fR[0], px.fG[0], px.fB[0], kYR, kYG, kYB, 16, 1),
+                  dotNeon(px.fR[1], px.fG[1], px.fB[1], kYR, kYG, kYB, 16, 1));
+        storeNeon(dstU + i,
+                  dotNeon(px.fR[0], px.fG[0], px.fB[0], kUR, kUG, kUB, 128, 1),
+                  dotNeon(px.fR[1], px.fG[1], px.fB[1], kUR, kUG, kUB, 128, 1));
+        storeNeon(dstV + i,
+                  dotNeon(px.fR[0], px.fG[0], px.fB[0], kVR, kVG, kVB, 128, 1),
+                  dotNeon(px.fR[1], px.fG[1], px.fB[1], kVR, kVG, kVB, 128, 1));
+        storeNeon(dstA + i, px.fA[0], px.fA[1]);
+    }
+    return i;
+}
+#endif
+
+template <typename T>
+void lumaRow(const uint32_t * const src, const int n,
+             T * const dstY, const float scale) {
+    int done = 0;
+#if defined(YUV_AVX2)
+    if(hasAvx2()) done = lumaRowAvx2(src, n, dstY, scale);
+#elif defined(YUV_NEON)
+    done = lumaRowNeon(src, n, dstY, scale);
+#endif
+    lumaRowScalar(src + done, n - done, dstY + done, scale);
+}
+
+template <typename T>
+void chromaRow(const uint32_t * const src0, const uint32_t * const src1,
+               const int width, T * const dstU, T * const dstV,
+               const float scale) {
+    const int n = (width + 1)/2;
+    int done = 0;
+#if defined(YUV_AVX2)
+    if(hasAvx2()) done = chromaRowAvx2(src0, src1, width/2, dstU, dstV, scale);
+#elif defined(YUV_NEON)
+    done = chromaRowNeon(src0, src1, width/2, dstU, dstV, scale);
+#endif
+    chromaRowScalar(src0, src1, done, n, width, dstU, dstV, scale);
+}
+
+void yuvaRow(const uint32_t * const src, const int n,
+             uint8_t * const dstY, uint8_t * const dstU,
+             uint8_t * const dstV, uint8_t * const dstA) {
+    int done = 0;
+#if defined(YUV_AVX2)
+    if(hasAvx2()) done = yuvaRowAvx2(src, n, dstY, dstU, dstV, dstA);
+#elif defined(YUV_NEON)
+    done = yuvaRowNeon(src, n, dstY, dstU, dstV, dstA);
+#endif
+    yuvaRowScalar(src, done, n, dstY, dstU, dstV, dstA);
+}
+
+template <typename T>
+T *planeRow(AVFrame * const dst, const int plane, const int row) {
+    return reinterpret_cast<T*>(dst->data[plane] + row*dst->linesize[plane]);
+}
+
+// converts luma rows [first, last), first and last are even for 4:2:0
+void convertRows(const SkPixmap &src, AVFrame * const dst,
+                 const int first, const int last) {
+    const int width = src.width();
+    const int height = src.height();
+    const auto srcRow = [&src](const int row) {
+        return static_cast<const uint32_t*>(src.addr(0, row));
+    };
+    const auto format = static_cast<AVPixelFormat>(dst->format);
+    if(format == AV_PIX_FMT_YUV420P) {
+        for(int y = first; y < last; y++) {
+            lumaRow(srcRow(y), width, planeRow<uint8_t>(dst, 0, y), 1);
+        }
+        for(int y = first; y < last; y += 2) {
+            const int y1 = std::min(y + 1, height - 1);
+            chromaRow(srcRow(y), srcRow(y1), width,
+                      planeRow<uint8_t>(dst, 1, y/2),
+                      planeRow<uint8_t>(dst, 2, y/2), 1);
+        }
+    } else if(format == AV_PIX_FMT_YUV422P10) {
+        for(int y = first; y < last; y++) {
+            lumaRow(srcRow(y), width, planeRow<uint16_t>(dst, 0, y), 4);
+            chromaRow(srcRow(y), srcRow(y), width,
+                      planeRow<uint16_t>(dst, 1, y),
+                      planeRow<uint16_t>(dst, 2, y), 4);
+        }
+    } else if(format == AV_PIX_FMT_YUVA444P) {
+        for(int y = first; y < last; y++) {
+            yuvaRow(srcRow(y), width,
+                    planeRow<uint8_t>(dst, 0, y),
+                    planeRow<uint8_t>(dst, 1, y),
+                    planeRow<uint8_t>(dst, 2, y),
+                    planeRow<uint8_t>(dst, 3, y));
+        }
+    }
+}
+
+}
+
+bool YuvConverter::sSupports(const AVPixelFormat format) {
+    return format == AV_PIX_FMT_YUV420P ||
+           format == AV_PIX_FMT_YUV422P10 ||
+           format == AV_PIX_FMT_YUVA444P;
+}
+
+void YuvConverter::sConvert(const SkPixmap &src, AVFrame * const dst) {
+    Q_ASSERT(src.colorType() == kRGBA_8888_SkColorType);
+    Q_ASSERT(sSupports(static_cast<AVPixelFormat>(dst->format)));
+    // Helper threads stay alive between frames. A quarter of the threads
+    // at most, the render workers are busy with the next frames meanwhile.
+    static QThreadPool sPool;
+    static const int sHelpers = [] {
+        const int helpers = std::max(1, eSettings::sCpuThreadsCapped()/4);
+        sPool.setMaxThreadCount(helpers);
+        sPool.setExpiryTimeout(-1);
+        return helpers;
+    }();
+    const int height = src.height();
+    // bands of at least 64 rows, an even number of rows each
+    const int maxBands = std::max(1, height/64);
+    const int nBands = std::min(sHelpers + 1, maxBands);
+    const int bandRows = ((height + nBands - 1)/nBands + 1)/2*2;
+
+    QSemaphore done;
+    int helped = 0;
+    for(int first = bandRows; first < height; first += bandRows) {
+        const int last = std::min(height, first + bandRows);
+        sPool.start([&src, &done, dst, first, last]() {
+            convertRows(src, dst, first, last);
+            done.release();
+        });
+        helped++;
+    }
+    convertRows(src, dst, 0, std::min(height, bandRows));
+    done.acquire(helped);
+}
+
+void YuvConverter::sBenchmark(const int width, const int height,
+                              const int iterations) {
+    // premultiplied gradients with varying transparency
+    std::vector<uint32_t> pixels(static_cast<size_t>(width*height));
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            const uint32_t a = static_cast<uint32_t>((x + y) % 256);
+            const uint32_t r = (x % 256)*a/255;
+            const uint32_t g = (y % 256)*a/255;
+            const uint32_t b = ((x ^ y) % 256)*a/255;
+            pixels[static_cast<size_t>(y*width + x)] = r | g << 8 | b << 16 | a << 24;
+        }
+    }
+    const auto info = SkImageInfo::Make(width, height, kRGBA_8888_SkColorType,
+                                        kPremul_SkAlphaType);
+    const SkPixmap pixmap(info, pixels.data(), info.minRowBytes());
+
+    qInfo().noquote() << QString("RGBA to YUV, %1x%2, %3 iterations, %4 threads")
+                         .arg(width).arg(height).arg(iterations)
+                         .arg(std::max(1, eSettings::sCpuThreadsCapped()/4) + 1);
+    for(const auto format : {AV_PIX_FMT_YUV420P,
+                             AV_PIX_FMT_YUV422P10,
+                             AV_PIX_FMT_YUVA444P}) {
+        AVFrame *swsFrame = av_frame_alloc();
+        AVFrame *frame = av_frame_alloc();
+        for(const auto f : {swsFrame, frame}) {
+            f->format = format;
+            f->width = width;
+            f->height = height;
+            av_frame_get_buffer(f, 0);
+        }
+        SwsContext * const sws = sws_getContext(width, height, AV_PIX_FMT_RGBA,
+                                                width, height, format,
+                                                SWS_BICUBIC, nullptr,
+                                                nullptr, nullptr);
+        const uint8_t * const srcData[] = {reinterpret_cast<const uint8_t*>(pixels.data())};
+        const int srcLinesize[] = {static_cast<int>(info.minRowBytes())};
+
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < iterations; i++) {
+            sws_scale(sws, srcData, srcLinesize, 0, height,
+                      swsFrame->data, swsFrame->linesize);
+        }
+        const qreal swsMs = timer.nsecsElapsed()*1e-6/iterations;
+
+        timer.restart();
+        for(int i = 0; i < iterations; i++) sConvert(pixmap, frame);
+        const qreal convMs = timer.nsecsElapsed()*1e-6/iterations;
+
+        // luma only, swscale keeps premultiplied colors and filters chroma
+        int maxDiff = 0;
+        const bool wide = format == AV_PIX_FMT_YUV422P10;
+        const bool straight = format == AV_PIX_FMT_YUVA444P;
+        for(int y = 0; y < height && !straight; y++) {
+            for(int x = 0; x < width; x++) {
+                const int a = wide ? planeRow<uint16_t>(swsFrame, 0, y)[x] :
+                                     planeRow<uint8_t>(swsFrame, 0, y)[x];
+                const int b = wide ? planeRow<uint16_t>(frame, 0, y)[x] :
+                                     planeRow<uint8_t>(frame, 0, y)[x];
+                maxDiff = std::max(maxDiff, std::abs(a - b));
+            }
+        }
+        qInfo().noquote() << QString("  %1: swscale %2 ms, kernel %3 ms (%4x)%5")
+                             .arg(av_get_pix_fmt_name(format))
+                             .arg(swsMs, 0, 'f', 2).arg(convMs, 0, 'f', 2)
+                             .arg(swsMs/std::max(convMs, 1e-6), 0, 'f', 1)
+                             .arg(straight ? QString() :
+                                             QString(", max luma difference %1").arg(maxDiff));
+        sws_freeContext(sws);
+        av_frame_free(&swsFrame);
+        av_frame_free(&frame);
+    }
+}
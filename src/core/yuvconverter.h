@@ -0,0 +1,55 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include "core_global.h"
+#include "skia/skiaincludes.h"
+
+extern "C" {
+    #include <libavutil/frame.h>
+    #include <libavutil/pixfmt.h>
+}
+
+//! @brief Converts premultiplied Skia RGBA output straight to the planar
+//! YUV formats most used for export, in one pass over the image.
+//! Uses AVX2 or NEON when available and splits rows between a few
+//! pooled threads.
+//! Matches the swscale defaults, BT.601 limited range.
+class CORE_EXPORT YuvConverter {
+    YuvConverter() = delete;
+public:
+    static bool sSupports(const AVPixelFormat format);
+    //! @brief src has to be kRGBA_8888_SkColorType, premultiplied or opaque.
+    //! Formats with alpha get unpremultiplied colors, formats without
+    //! alpha get the image composited over black, like swscale does.
+    static void sConvert(const SkPixmap &src, AVFrame * const dst);
+
+    //! @brief Prints time per frame of swscale and of sConvert
+    //! for each supported format.
+    static void sBenchmark(const int width, const int height,
+                           const int iterations);
+};
+
+#endif // YUVCONVERTER_H
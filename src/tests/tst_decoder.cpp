@@ -0,0 +1,110 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include <QtTest>
+#include <QSemaphore>
+#include <thread>
+
+#include "Private/Tasks/execcontroller.h"
+#include "FileCacheHandlers/videocachehandler.h"
+#include "Tasks/updatable.h"
+
+class DecoderTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cancelQuedLoads();
+};
+
+void DecoderTest::initTestCase() {
+    qRegisterMetaType<stdsptr<eTask>>();
+}
+
+// Loads queued on a decoder that gets released are canceled, they must
+// not report the end of the file the way a finished frame load does.
+void DecoderTest::cancelQuedLoads() {
+    VideoDataHandler data;
+    data.setFrameCount(100);
+    int countUpdates = 0;
+    connect(&data, &VideoDataHandler::frameCountUpdated,
+            this, [&countUpdates]() { countUpdates++; });
+
+    const auto decoder = new DecoderExecController("test");
+    // what TaskScheduler::afterDecoderTaskFinished does
+    connect(decoder, &ExecController::finishedTaskSignal,
+            this, [](const stdsptr<eTask>& task) {
+        TaskExecutor::sTaskFinishSignals--;
+        task->finishedProcessing();
+    });
+
+    QSemaphore started;
+    QSemaphore gate;
+    const auto blocking = enve::make_shared<eCustomCpuTask>(
+                nullptr, [&]() { started.release(); gate.acquire(); },
+                nullptr, nullptr);
+    blocking->aboutToProcess(Hardware::hdd);
+    decoder->addTask(blocking);
+    started.acquire();
+
+    int finished = 0;
+    int canceled = 0;
+    QList<stdsptr<eTask>> loads;
+    for(int i = 0; i < 4; i++) {
+        const int frame = 10 + i;
+        // a frame loader finishing without an image ends the file
+        const auto load = enve::make_shared<eCustomCpuTask>(
+                    nullptr, nullptr,
+                    [&data, &finished, frame]() {
+                        finished++;
+                        data.frameLoaderFinished(
+                                    frame, nullptr,
+                                    CompactFrame::Format::rgba, QSize(), 0);
+                    },
+                    [&canceled]() { canceled++; });
+        load->aboutToProcess(Hardware::hdd);
+        decoder->addTask(load);
+        loads << load;
+    }
+
+    // the waiting loads are taken before the blocking task returns
+    std::thread release([&gate]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        gate.release();
+    });
+    decoder->stopAndCancel();
+    release.join();
+    decoder->deleteLater();
+    QTest::qWait(100);
+
+    QCOMPARE(finished, 0);
+    QCOMPARE(canceled, loads.count());
+    QCOMPARE(data.getFrameCount(), 100);
+    QCOMPARE(countUpdates, 0);
+    QCOMPARE(int(TaskExecutor::sTaskFinishSignals), 0);
+    for(const auto& load : loads) {
+        QCOMPARE(load->getState(), eTaskState::canceled);
+    }
+}
+
+QTEST_GUILESS_MAIN(DecoderTest)
+#include "tst_decoder.moc"
@@ -0,0 +1,145 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+
+#include "memoryusagewidget.h"
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QMap>
+
+#include <algorithm>
+
+#include "memoryaccounting.h"
+
+static QString bytesToString(const qint64 bytes)
+{
+    const qreal mb = bytes/(1024.*1024.);
+    if (mb < 1024) { return QString("%1 MB").arg(mb, 0, 'f', 1); }
+    return QString("%1 GB").arg(mb/1024., 0, 'f', 2);
+}
+
+MemoryUsageWidget::MemoryUsageWidget(QWidget *parent)
+    : QWidget(parent)
+    , mTimer(new QTimer(this))
+    , mCategories(new QTreeWidget(this))
+    , mOwners(new QTreeWidget(this))
+    , mTotalLabel(new QLabel(this))
+{
+    const auto lay = new QVBoxLayout(this);
+    lay->setContentsMargins(0, 0, 0, 0);
+
+    mCategories->setHeaderLabels(QStringList() << tr("Category")
+                                               << tr("Memory")
+                                               << tr("Items"));
+    mOwners->setHeaderLabels(QStringList() << tr("Owner")
+                                           << tr("Memory")
+                                           << tr("Items"));
+    for (const auto tree : {mCategories, mOwners}) {
+        tree->setFrameShape(QFrame::NoFrame);
+        tree->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    }
+    mCategories->setRootIsDecorated(false);
+    mOwners->setToolTip(tr("Scenes, layers and files holding memory"));
+
+    mTotalLabel->setWordWrap(true);
+    mTotalLabel->setContentsMargins(5, 0, 5, 0);
+
+    lay->addWidget(mCategories);
+    lay->addWidget(mOwners, 1);
+    lay->addWidget(mTotalLabel);
+
+    mTimer->setInterval(1000);
+    connect(mTimer, &QTimer::timeout,
+            this, &MemoryUsageWidget::updateUsage);
+}
+
+void MemoryUsageWidget::showEvent(QShowEvent *event)
+{
+    mTimer->start();
+    updateUsage();
+    QWidget::showEvent(event);
+}
+
+void MemoryUsageWidget::hideEvent(QHideEvent *event)
+{
+    mTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+void MemoryUsageWidget::updateUsage()
+{
+    using Category = MemoryAccounting::Category;
+    const auto usage = MemoryAccounting::sUsage();
+
+    QMap<int, QPair<qint64, int>> categories;
+    QMap<QString, QList<MemoryAccounting::Usage>> owners;
+    QMap<QString, qint64> ownerBytes;
+    qint64 total = 0;
+    for (const auto &use : usage) {
+        auto &cat = categories[int(use.fCategory)];
+        cat.first += use.fBytes;
+        cat.second += use.fCount;
+        const QString owner = use.fOwner.isEmpty() ? tr("Unknown") : use.fOwner;
+        owners[owner] << use;
+        ownerBytes[owner] += use.fBytes;
+        total += use.fBytes;
+    }
+
+    mCategories->clear();
+    for (int i = 0; i < int(Category::count); i++) {
+        const auto cat = categories.value(i);
+        const auto item = new QTreeWidgetItem(mCategories);
+        item->setText(0, MemoryAccounting::sCategoryName(Category(i)));
+        item->setText(1, bytesToString(cat.first));
+        item->setText(2, QString::number(cat.second));
+    }
+
+    QStringList sorted = owners.keys();
+    std::sort(sorted.begin(), sorted.end(),
+              [&ownerBytes](const QString &a, const QString &b) {
+        return ownerBytes.value(a) > ownerBytes.value(b);
+    });
+    QStringList expanded;
+    for (int i = 0; i < mOwners->topLevelItemCount(); i++) {
+        const auto item = mOwners->topLevelItem(i);
+        if (item->isExpanded()) { expanded << item->text(0); }
+    }
+    mOwners->clear();
+    for (const auto &owner : sorted) {
+        const auto item = new QTreeWidgetItem(mOwners);
+        int count = 0;
+        for (const auto &use : owners.value(owner)) {
+            const auto child = new QTreeWidgetItem(item);
+            child->setText(0, MemoryAccounting::sCategoryName(use.fCategory));
+            child->setText(1, bytesToString(use.fBytes));
+            child->setText(2, QString::number(use.fCount));
+            count += use.fCount;
+        }
+        item->setText(0, owner);
+        item->setToolTip(0, owner);
+        item->setText(1, bytesToString(ownerBytes.value(owner)));
+        item->setText(2, QString::number(count));
+        item->setExpanded(expanded.contains(owner));
+    }
+
+    mTotalLabel->setText(tr("Accounted for: %1").arg(bytesToString(total)));
+}
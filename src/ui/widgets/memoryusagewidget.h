@@ -19,24 +19,33 @@
 #
 # See 'README.md' for more information.
 #
-*/
 
-// Fork of enve - Copyright (C) 2016-2020 Maurycy Liebner
+#ifndef MEMORYUSAGEWIDGET_H
+#define MEMORYUSAGEWIDGET_H
 
-#ifndef TMPFILEHANDLERS_H
-#define TMPFILEHANDLERS_H
-#include "Tasks/updatable.h"
-#include <QTemporaryFile>
+#include "ui_global.h"
 
-class CORE_EXPORT TmpDeleter : public eHddTask {
-    e_OBJECT
-protected:
-    TmpDeleter(const qsptr<QTemporaryFile> &file);
+#include <QWidget>
+#include <QLabel>
+#include <QTimer>
+#include <QTreeWidget>
+
+class UI_EXPORT MemoryUsageWidget : public QWidget
+{
 public:
-    void process();
+    explicit MemoryUsageWidget(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
 private:
-    qsptr<QTemporaryFile> mTmpFile;
-};
+    void updateUsage();
 
+    QTimer *mTimer;
+    QTreeWidget *mCategories;
+    QTreeWidget *mOwners;
+    QLabel *mTotalLabel;
+};
 
-#endif // TMPFILEHANDLERS_H
+#endif // MEMORYUSAGEWIDGET_H
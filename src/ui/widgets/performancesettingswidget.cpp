@@ -71,6 +71,44 @@ PerformanceSettingsWidget::PerformanceSettingsWidget(QWidget *parent)
     cpuCapSett->addWidget(mCpuThreadsCapLabel);
     capLayout->addLayout(cpuCapSett);
 
+    mCpuWorkStealingCheck = new QCheckBox(tr("Per thread task queues"), this);
+    mCpuWorkStealingCheck->setToolTip(gSingleLineTooltip(tr("Give each CPU thread its own task queue, "
+                                                            "idle threads steal work from busy ones")));
+    capLayout->addWidget(mCpuWorkStealingCheck);
+
+    QHBoxLayout* parallelOutputSett = new QHBoxLayout;
+
+    mParallelOutputCheck = new QCheckBox(tr("Parallel export"), this);
+    mParallelOutputCheck->setToolTip(gSingleLineTooltip(tr("Render several frames at once when exporting, "
+                                                           "frames are still encoded in order")));
+    mOutputFramesInFlightSpin = new QSpinBox(this);
+    mOutputFramesInFlightSpin->setRange(0, 64);
+    mOutputFramesInFlightSpin->setSpecialValueText(tr("Auto"));
+    mOutputFramesInFlightSpin->setSuffix(tr(" frames"));
+    mOutputFramesInFlightSpin->setToolTip(gSingleLineTooltip(tr("Maximum number of frames in flight, "
+                                                                "limited to a quarter of the RAM, "
+                                                                "but never fewer than the CPU threads")));
+    mOutputFramesInFlightSpin->setEnabled(false);
+    connect(mParallelOutputCheck, &QCheckBox::toggled,
+            mOutputFramesInFlightSpin, &QWidget::setEnabled);
+
+    parallelOutputSett->addWidget(mParallelOutputCheck);
+    parallelOutputSett->addWidget(mOutputFramesInFlightSpin);
+    capLayout->addLayout(parallelOutputSett);
+
+    QHBoxLayout* encoderThreadsSett = new QHBoxLayout;
+
+    const auto encoderThreadsLabel = new QLabel(tr("Encoder threads"), this);
+    mEncoderThreadsSpin = new QSpinBox(this);
+    mEncoderThreadsSpin->setRange(0, HardwareInfo::sCpuThreads());
+    mEncoderThreadsSpin->setSpecialValueText(tr("Auto"));
+    mEncoderThreadsSpin->setToolTip(gSingleLineTooltip(tr("Frame and slice threads used by the video codec "
+                                                          "when exporting")));
+
+    encoderThreadsSett->addWidget(encoderThreadsLabel);
+    encoderThreadsSett->addWidget(mEncoderThreadsSpin);
+    capLayout->addLayout(encoderThreadsSett);
+
     QHBoxLayout* ramCapSett = new QHBoxLayout;
 
     mRamMBCapCheck = new QCheckBox(tr("RAM"), this);
@@ -162,6 +200,8 @@ PerformanceSettingsWidget::PerformanceSettingsWidget(QWidget *parent)
     eSizesUI::widget.add(mCpuThreadsCapCheck, [this](const int size) {
         mCpuThreadsCapCheck->setFixedHeight(size);
         mRamMBCapCheck->setFixedHeight(size);
+        mCpuWorkStealingCheck->setFixedHeight(size);
+        mParallelOutputCheck->setFixedHeight(size);
         mPathGpuAccCheck->setFixedHeight(size);
         mAudioDevicesCombo->setFixedHeight(eSizesUI::button);
     });
@@ -176,6 +216,10 @@ void PerformanceSettingsWidget::applySettings()
 {
     mSett.fCpuThreadsCap = mCpuThreadsCapCheck->isChecked() ?
                 mCpuThreadsCapSlider->value() : 0;
+    mSett.fCpuWorkStealing = mCpuWorkStealingCheck->isChecked();
+    mSett.fParallelOutput = mParallelOutputCheck->isChecked();
+    mSett.fOutputFramesInFlight = mOutputFramesInFlightSpin->value();
+    mSett.fEncoderThreads = mEncoderThreadsSpin->value();
     mSett.fRamMBCap = intMB(mRamMBCapCheck->isChecked() ?
                 mRamMBCapSpin->value() : 0);
     mSett.fAccPreference = static_cast<AccPreference>(
@@ -198,6 +242,10 @@ void PerformanceSettingsWidget::updateSettings(bool restore)
     const int nThreads = capCpu ? mSett.fCpuThreadsCap :
                                   HardwareInfo::sCpuThreads();
     mCpuThreadsCapSlider->setValue(nThreads);
+    mCpuWorkStealingCheck->setChecked(mSett.fCpuWorkStealing);
+    mParallelOutputCheck->setChecked(mSett.fParallelOutput);
+    mOutputFramesInFlightSpin->setValue(mSett.fOutputFramesInFlight);
+    mEncoderThreadsSpin->setValue(mSett.fEncoderThreads);
 
     const bool capRam = mSett.fRamMBCap.fValue > 250;
     mRamMBCapCheck->setChecked(capRam);
@@ -54,6 +54,11 @@ private:
     QCheckBox* mCpuThreadsCapCheck = nullptr;
     QLabel* mCpuThreadsCapLabel = nullptr;
     QSlider* mCpuThreadsCapSlider = nullptr;
+    QCheckBox* mCpuWorkStealingCheck = nullptr;
+
+    QCheckBox* mParallelOutputCheck = nullptr;
+    QSpinBox* mOutputFramesInFlightSpin = nullptr;
+    QSpinBox* mEncoderThreadsSpin = nullptr;
 
     QCheckBox* mRamMBCapCheck = nullptr;
     QSpinBox* mRamMBCapSpin = nullptr;
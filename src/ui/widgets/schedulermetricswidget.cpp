@@ -0,0 +1,173 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#include "schedulermetricswidget.h"
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QMessageBox>
+
+#include "Private/Tasks/tasktracer.h"
+
+SchedulerMetricsWidget::SchedulerMetricsWidget(QWidget *parent)
+    : QWidget(parent)
+    , mTimer(new QTimer(this))
+    , mExecutors(new QTreeWidget(this))
+    , mQuesLabel(new QLabel(this))
+    , mStallsLabel(new QLabel(this))
+    , mMemoryLabel(new QLabel(this))
+    , mTraceButton(new QPushButton(tr("Record Trace"), this))
+{
+    const auto lay = new QVBoxLayout(this);
+    lay->setContentsMargins(0, 0, 0, 0);
+
+    mExecutors->setHeaderLabels(QStringList() << tr("Executor")
+                                              << tr("Busy")
+                                              << tr("Tasks/s")
+                                              << tr("Tasks"));
+    mExecutors->setRootIsDecorated(false);
+    mExecutors->setFrameShape(QFrame::NoFrame);
+    mExecutors->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    for (const auto label : {mQuesLabel, mStallsLabel, mMemoryLabel}) {
+        label->setWordWrap(true);
+        label->setContentsMargins(5, 0, 5, 0);
+    }
+
+    lay->addWidget(mExecutors);
+    lay->addWidget(mQuesLabel);
+    lay->addWidget(mStallsLabel);
+    lay->addWidget(mMemoryLabel);
+    lay->addWidget(mTraceButton);
+
+    mTraceButton->setCheckable(true);
+    mTraceButton->setChecked(TaskTracer::sEnabled());
+    mTraceButton->setToolTip(tr("Record the lifetime of every task and save it "
+                                "as a Chrome trace (chrome://tracing, ui.perfetto.dev)"));
+    connect(mTraceButton, &QPushButton::toggled,
+            this, &SchedulerMetricsWidget::setTraceRecording);
+
+    mTimer->setInterval(500);
+    connect(mTimer, &QTimer::timeout,
+            this, &SchedulerMetricsWidget::updateMetrics);
+}
+
+void SchedulerMetricsWidget::showEvent(QShowEvent *event)
+{
+    mElapsed.start();
+    mTimer->start();
+    updateMetrics();
+    QWidget::showEvent(event);
+}
+
+void SchedulerMetricsWidget::hideEvent(QHideEvent *event)
+{
+    mTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+void SchedulerMetricsWidget::setTraceRecording(const bool record)
+{
+    if (record) {
+        TaskTracer::sStart();
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this,
+                                                      tr("Save Trace"),
+                                                      QDir::homePath() + "/friction-trace.json",
+                                                      tr("Chrome Trace (*.json)"));
+    if (!TaskTracer::sStop(path) && !path.isEmpty()) {
+        QMessageBox::warning(this, tr("Save Trace"),
+                             tr("Failed to write %1").arg(path));
+    }
+}
+
+QTreeWidgetItem *SchedulerMetricsWidget::executorItem(const int index)
+{
+    while (mExecutors->topLevelItemCount() <= index) {
+        mExecutors->addTopLevelItem(new QTreeWidgetItem(mExecutors));
+    }
+    return mExecutors->topLevelItem(index);
+}
+
+void SchedulerMetricsWidget::updateExecutor(QTreeWidgetItem *item,
+                                            const QString &name,
+                                            const ExecutorMetrics &now,
+                                            const ExecutorMetrics &prev,
+                                            const qint64 elapsedMs)
+{
+    const qint64 busyMs = now.fBusyMs - prev.fBusyMs;
+    const int tasks = now.fProcessedTasks - prev.fProcessedTasks;
+    const qreal busy = elapsedMs > 0 ? qBound(0., 100.*busyMs/elapsedMs, 100.) : 0.;
+    const qreal perSec = elapsedMs > 0 ? 1000.*tasks/elapsedMs : 0.;
+    item->setText(0, name);
+    item->setText(1, QString("%1 %").arg(busy, 0, 'f', 0));
+    item->setText(2, QString::number(perSec, 'f', 1));
+    item->setText(3, QString::number(now.fProcessedTasks));
+}
+
+void SchedulerMetricsWidget::updateMetrics()
+{
+    const auto scheduler = TaskScheduler::instance();
+    if (!scheduler) { return; }
+
+    const auto metrics = scheduler->metrics();
+    const qint64 elapsedMs = mElapsed.restart();
+
+    int index = 0;
+    for (int i = 0; i < metrics.fCpuExecutors.count(); i++) {
+        const auto prev = i < mPrevious.fCpuExecutors.count() ?
+                              mPrevious.fCpuExecutors.at(i) : ExecutorMetrics();
+        updateExecutor(executorItem(index++), tr("CPU %1").arg(i + 1),
+                       metrics.fCpuExecutors.at(i), prev, elapsedMs);
+    }
+    updateExecutor(executorItem(index++), tr("GPU"),
+                   metrics.fGpuExecutor, mPrevious.fGpuExecutor, elapsedMs);
+    updateExecutor(executorItem(index++), tr("HDD"),
+                   metrics.fHddExecutor, mPrevious.fHddExecutor, elapsedMs);
+
+    const auto &qued = metrics.fQued;
+    mQuesLabel->setText(tr("Queued: GPU only %1, GPU preferred %2, "
+                           "CPU preferred %3, CPU only %4, HDD %5\n"
+                           "Waiting in executors: CPU %6, GPU %7, HDD %8\n"
+                           "Video decoders: queued %9, waiting %10")
+                        .arg(qued.fGpuOnly)
+                        .arg(qued.fGpuPreffered)
+                        .arg(qued.fCpuPreffered)
+                        .arg(qued.fCpuOnly)
+                        .arg(metrics.fQuedHdd)
+                        .arg(metrics.fWaitingCpu)
+                        .arg(metrics.fWaitingGpu)
+                        .arg(metrics.fWaitingHdd)
+                        .arg(metrics.fQuedDecoder)
+                        .arg(metrics.fWaitingDecoder));
+    mStallsLabel->setText(tr("Held back by queue overflow: %1, CPU idle waiting on HDD: %2")
+                          .arg(metrics.fOverflowStalls)
+                          .arg(metrics.fHddStalls));
+    mMemoryLabel->setText(tr("Critical memory state: %1 (%2 s total)")
+                          .arg(metrics.fCriticalMemoryState ? tr("yes") : tr("no"))
+                          .arg(metrics.fCriticalMemoryMs/1000., 0, 'f', 1));
+
+    mPrevious = metrics;
+}
@@ -0,0 +1,67 @@
+/*
+#
+# Friction - https://friction.graphics
+#
+# Copyright (c) Ole-André Rodlie and contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# See 'README.md' for more information.
+#
+*/
+
+#ifndef SCHEDULERMETRICSWIDGET_H
+#define SCHEDULERMETRICSWIDGET_H
+
+#include "ui_global.h"
+
+#include <QWidget>
+#include <QLabel>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QPushButton>
+
+#include "Private/Tasks/taskscheduler.h"
+
+class UI_EXPORT SchedulerMetricsWidget : public QWidget
+{
+public:
+    explicit SchedulerMetricsWidget(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+private:
+    void updateMetrics();
+    void updateExecutor(QTreeWidgetItem *item,
+                        const QString &name,
+                        const ExecutorMetrics &now,
+                        const ExecutorMetrics &prev,
+                        const qint64 elapsedMs);
+    QTreeWidgetItem *executorItem(const int index);
+    void setTraceRecording(const bool record);
+
+    QTimer *mTimer;
+    QTreeWidget *mExecutors;
+    QLabel *mQuesLabel;
+    QLabel *mStallsLabel;
+    QLabel *mMemoryLabel;
+    QPushButton *mTraceButton;
+
+    QElapsedTimer mElapsed;
+    TaskSchedulerMetrics mPrevious;
+};
+
+#endif // SCHEDULERMETRICSWIDGET_H